@@ -168,12 +168,27 @@ GASNet is linked with.
 
 ])dnl if gasnet
 
-AS_IF([test "x$gasnet_available_conduits" != x],[
+# The shared memory network connects processes of the same host and does
+# not need GASNet, it enables the cluster architecture on its own.
+AC_ARG_ENABLE([cluster-shm],
+  [AS_HELP_STRING([--enable-cluster-shm],
+                  [Enables the shared memory network of the Cluster architecture (single host, does not require GASNet)])],
+  [cluster_shm=$enableval],
+  [cluster_shm=no])
+
+AS_IF([test x$cluster_shm = xyes -a "x$gasnet_available_conduits" = x],[
+  ARCHITECTURES="$ARCHITECTURES cluster"
+  AC_DEFINE([CLUSTER_DEV],[],[Indicates the presence of the Cluster arch plugin.])
+])
+
+AS_IF([test "x$gasnet_available_conduits" != x -o x$cluster_shm = xyes],[
   AC_SUBST([HAVE_GASNET], [CLUSTER_DEV])
 ], [
   AC_SUBST([HAVE_GASNET], [NO_CLUSTER_DEV])
 ])
 
+AM_CONDITIONAL([cluster_shm_available],[test x$cluster_shm = xyes])
+
 m4_foreach_w([conduit_name],[smp udp mpi ibv mxm aries],[
   _AX_CONDUIT_SUBST(conduit_name)
 ])
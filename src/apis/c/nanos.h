@@ -121,6 +121,7 @@
  * - nanos interface family: deps_api
  *   - 1000: First implementation of dependencies plugins.
  *   - 1001: Commutative clause support.
+ *   - 1002: Dependence graph regions (nanos_dependence_region_begin/end).
  * - nanos interface family: openmp
  *   - 1: First Nanos OpenMP interface: nanos_omp_single ( b ) service
  *   - 2: Including nanos_omp_barrier() service
@@ -283,6 +284,8 @@ NANOS_API_DECL(nanos_err_t, nanos_expel_current_thread, (void));
 NANOS_API_DECL(nanos_err_t, nanos_dependence_release_all, ( void ) );
 NANOS_API_DECL(nanos_err_t, nanos_dependence_pendant_writes, ( bool *res, void *addr ));
 NANOS_API_DECL(nanos_err_t, nanos_dependence_create, ( nanos_wd_t pred, nanos_wd_t succ ) );
+NANOS_API_DECL(nanos_err_t, nanos_dependence_region_begin, ( const void *key ) );
+NANOS_API_DECL(nanos_err_t, nanos_dependence_region_end, ( void ) );
 
 /* worksharing */
 NANOS_API_DECL(nanos_err_t, nanos_worksharing_create ,( nanos_ws_desc_t **wsd, nanos_ws_t ws, nanos_ws_info_t *info, bool *b ) );
@@ -83,6 +83,37 @@ NANOS_API_DEF(nanos_err_t, nanos_dependence_create, ( nanos_wd_t pred, nanos_wd_
    }
    return NANOS_OK;
 }
+
+//! \brief Starts a dependence graph region in the current WorkDescriptor
+//!
+//! Tasks submitted between nanos_dependence_region_begin() and nanos_dependence_region_end()
+//! have their dependences resolved the first time the region (identified by key) is run. Next
+//! runs reuse that resolution while the tasks keep accessing the same data in the same order,
+//! and fall back to the normal resolution from the first access that differs.
+//!
+//! \param [in] key identifies the region (e.g. the address of the loop body)
+NANOS_API_DEF(nanos_err_t, nanos_dependence_region_begin, ( const void *key ) )
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","dependence_region_begin", NANOS_RUNTIME) );
+   try {
+      myThread->getCurrentWD()->getDependenciesDomain().beginGraphRegion( key );
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+   return NANOS_OK;
+}
+
+//! \brief Ends the dependence graph region of the current WorkDescriptor
+NANOS_API_DEF(nanos_err_t, nanos_dependence_region_end, ( void ) )
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","dependence_region_end", NANOS_RUNTIME) );
+   try {
+      myThread->getCurrentWD()->getDependenciesDomain().endGraphRegion();
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+   return NANOS_OK;
+}
 /*!
  * \}
  */ 
@@ -90,7 +90,6 @@ bool ClusterDevice::_copyDevToDev( uint64_t devDestAddr, uint64_t devOrigAddr, s
 }
 
 void ClusterDevice::_copyInStrided1D( uint64_t devAddr, uint64_t hostAddr, std::size_t len, std::size_t count, std::size_t ld, SeparateMemoryAddressSpace &mem, DeviceOps *ops, WD const *wd, void *hostObject, reg_t hostRegionId ) {
-   char *hostAddrPtr = (char *) hostAddr;
    char *packedAddr = NULL;
    ops->addOp();
    //NANOS_INSTRUMENT( InstrumentState inst2(NANOS_STRIDED_COPY_PACK); );
@@ -103,12 +102,8 @@ void ClusterDevice::_copyInStrided1D( uint64_t devAddr, uint64_t hostAddr, std::
    } while ( packedAddr == NULL );
       //*myThread->_file << "Got address " << (void *)packedAddr << std::endl;
 
-   if ( packedAddr != NULL) { 
-      for ( unsigned int i = 0; i < count; i += 1 ) {
-         ::memcpy( &packedAddr[ i * len ], &hostAddrPtr[ i * ld ], len );
-      }
-   } else { std::cerr << "copyInStrided ERROR!!! could not get a packet to gather data." << std::endl; }
    //NANOS_INSTRUMENT( inst2.close(); );
+   // The rows are gathered into packedAddr by the network layer, as they are sent
    sys.getNetwork()->putStrided1D( mem.getNodeNumber(),  devAddr, ( void * ) hostAddr, packedAddr, len, count, ld, wd->getId(), wd, hostObject, hostRegionId );
    if ( _packer.free_pack( hostAddr, len, count, packedAddr ) == false ) {
       *myThread->_file << "Error freeing pack after sending copyIn to node " << mem.getNodeNumber() << " HostAddr " << (void *) hostAddr << " wd: " << wd->getId() << " region: " << (void *) hostObject << ":" << hostRegionId << std::endl;
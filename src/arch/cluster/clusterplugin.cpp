@@ -19,7 +19,11 @@
 
 #include "plugin.hpp"
 #include "system.hpp"
+#ifdef NANOS_CLUSTER_SHM
+#include "shmnetapi_decl.hpp"
+#else
 #include "gasnetapi_decl.hpp"
+#endif
 #include "clusterplugin_decl.hpp"
 #include "clusternode_decl.hpp"
 #include "remoteworkdescriptor_decl.hpp"
@@ -35,7 +39,13 @@
 #include "fpgadd.hpp"
 #endif
 
-#if defined(__SIZEOF_SIZE_T__) 
+#if defined(NANOS_CLUSTER_SHM)
+
+/* All the nodes share the host memory */
+#define DEFAULT_NODE_MEM (0x40000000UL) 
+#define MAX_NODE_MEM     (0x40000000UL) 
+
+#elif defined(__SIZEOF_SIZE_T__) 
    #if  __SIZEOF_SIZE_T__ == 8
 
 #define DEFAULT_NODE_MEM (0x542000000ULL) 
@@ -58,12 +68,16 @@ namespace nanos {
 namespace ext {
 
 ClusterPlugin::ClusterPlugin() : ArchPlugin( "Cluster PE Plugin", 1 ),
-   _gasnetApi( NEW GASNetAPI() ), _numPinnedSegments( 0 ), _pinnedSegmentAddrList( NULL ),
+   _netApi( NEW ClusterNetworkAPI() ), _numPinnedSegments( 0 ), _pinnedSegmentAddrList( NULL ),
    _pinnedSegmentLenList( NULL ), _extraPEsCount( 0 ), _conduit(""),
    _nodeMem( DEFAULT_NODE_MEM ), _allocFit( false ), _allowSharedThd( false ),
    _unalignedNodeMem( false ), _gpuPresend( 1 ), _smpPresend( 1 ),
-   _cachePolicy( System::DEFAULT ), _remoteNodes( NULL ), _cpu( NULL ),
-   _clusterThread( NULL ), _gasnetSegmentSize( 0 ) {
+   _aggregationFrameSize( 4096 ), _aggregationTimeout( 50 ), _cachePolicy( System::DEFAULT ), _remoteNodes( NULL ), _cpu( NULL ),
+   _clusterThread( NULL ), _gasnetSegmentSize( 0 )
+#ifdef NANOS_CLUSTER_SHM
+   , _shmNodes( 1 ), _shmRingSize( 0 )
+#endif
+{
 }
 
 void ClusterPlugin::config( Config& cfg )
@@ -74,18 +88,26 @@ void ClusterPlugin::config( Config& cfg )
 
 void ClusterPlugin::init()
 {
-   _gasnetApi->initialize( sys.getNetwork() );
-   //sys.getNetwork()->setAPI(_gasnetApi);
-   _gasnetApi->setGASNetSegmentSize( _gasnetSegmentSize );
-   _gasnetApi->setUnalignedNodeMemory( _unalignedNodeMem );
-   sys.getNetwork()->initialize( _gasnetApi );
+#ifdef NANOS_CLUSTER_SHM
+   _netApi->setNumNodes( _shmNodes );
+   _netApi->setSegmentSize( _gasnetSegmentSize );
+   _netApi->setRingSize( _shmRingSize );
+   _netApi->initialize( sys.getNetwork() );
+#else
+   _netApi->initialize( sys.getNetwork() );
+   //sys.getNetwork()->setAPI(_netApi);
+   _netApi->setGASNetSegmentSize( _gasnetSegmentSize );
+#endif
+   _netApi->setUnalignedNodeMemory( _unalignedNodeMem );
+   sys.getNetwork()->setAggregation( _aggregationFrameSize, _aggregationTimeout );
+   sys.getNetwork()->initialize( _netApi );
    sys.getNetwork()->setGpuPresend(this->getGpuPresend() );
    sys.getNetwork()->setSmpPresend(this->getSmpPresend() );
 
-   unsigned int nodes = _gasnetApi->getNumNodes();
+   unsigned int nodes = _netApi->getNumNodes();
 
    if ( nodes > 1 ) {
-      if ( _gasnetApi->getNodeNum() == 0 ) {
+      if ( _netApi->getNodeNum() == 0 ) {
          void *segmentAddr[ nodes ];
          sys.getNetwork()->mallocSlaves( &segmentAddr[ 1 ], _nodeMem );
          segmentAddr[ 0 ] = NULL;
@@ -114,7 +136,7 @@ void ClusterPlugin::init()
          _remoteNodes = NEW std::vector<nanos::ext::ClusterNode *>(nodes - 1, (nanos::ext::ClusterNode *) NULL); 
          unsigned int node_index = 0;
          for ( unsigned int nodeC = 0; nodeC < nodes; nodeC++ ) {
-            if ( nodeC != _gasnetApi->getNodeNum() ) {
+            if ( nodeC != _netApi->getNodeNum() ) {
                memory_space_id_t id = sys.addSeparateMemoryAddressSpace( ext::Cluster, !( getAllocFit() ), 0 );
                SeparateMemoryAddressSpace &nodeMemory = sys.getSeparateMemory( id );
                nodeMemory.setSpecificData( NEW SimpleAllocator( ( uintptr_t ) segmentAddr[ nodeC ], _nodeMem ) );
@@ -206,6 +228,14 @@ void ClusterPlugin::prepare( Config& cfg ) {
    cfg.registerArgOption ( "cluster-smp-presend", "cluster-smp-presend" );
    cfg.registerEnvOption ( "cluster-smp-presend", "NX_CLUSTER_SMP_PRESEND" );
 
+   cfg.registerConfigOption ( "cluster-aggregation-size", NEW Config::SizeVar ( _aggregationFrameSize ), "Size of the frames used to send small control messages together to a node, 0 disables the aggregation." );
+   cfg.registerArgOption ( "cluster-aggregation-size", "cluster-aggregation-size" );
+   cfg.registerEnvOption ( "cluster-aggregation-size", "NX_CLUSTER_AGGREGATION_SIZE" );
+
+   cfg.registerConfigOption ( "cluster-aggregation-timeout", NEW Config::UintVar ( _aggregationTimeout ), "Microseconds a control message can wait in a frame before the frame is sent." );
+   cfg.registerArgOption ( "cluster-aggregation-timeout", "cluster-aggregation-timeout" );
+   cfg.registerEnvOption ( "cluster-aggregation-timeout", "NX_CLUSTER_AGGREGATION_TIMEOUT" );
+
    System::CachePolicyConfig *cachePolicyCfg = NEW System::CachePolicyConfig ( _cachePolicy );
    cachePolicyCfg->addOption("wt", System::WRITE_THROUGH );
    cachePolicyCfg->addOption("wb", System::WRITE_BACK );
@@ -222,9 +252,23 @@ void ClusterPlugin::prepare( Config& cfg ) {
    cfg.registerArgOption ( "cluster-unaligned-node-memory", "cluster-unaligned-node-memory" );
    cfg.registerEnvOption ( "cluster-unaligned-node-memory", "NX_CLUSTER_UNALIGNED_NODE_MEMORY" );
 
+#ifdef NANOS_CLUSTER_SHM
+   cfg.registerConfigOption ( "cluster-shm-nodes", NEW Config::UintVar ( _shmNodes ), "Number of nodes (processes) of the shared memory network." );
+   cfg.registerArgOption ( "cluster-shm-nodes", "cluster-shm-nodes" );
+   cfg.registerEnvOption ( "cluster-shm-nodes", "NX_CLUSTER_SHM_NODES" );
+
+   cfg.registerConfigOption ( "cluster-shm-segment", NEW Config::SizeVar ( _gasnetSegmentSize ), "Size of the data segment of each node of the shared memory network." );
+   cfg.registerArgOption ( "cluster-shm-segment", "cluster-shm-segment-size" );
+   cfg.registerEnvOption ( "cluster-shm-segment", "NX_CLUSTER_SHM_SEGMENT_SIZE" );
+
+   cfg.registerConfigOption ( "cluster-shm-ring", NEW Config::SizeVar ( _shmRingSize ), "Size of the message ring between each pair of nodes of the shared memory network." );
+   cfg.registerArgOption ( "cluster-shm-ring", "cluster-shm-ring-size" );
+   cfg.registerEnvOption ( "cluster-shm-ring", "NX_CLUSTER_SHM_RING_SIZE" );
+#else
    cfg.registerConfigOption ( "gasnet-segment", NEW Config::SizeVar ( _gasnetSegmentSize ), "GASNet segment size." );
    cfg.registerArgOption ( "gasnet-segment", "gasnet-segment-size" );
    cfg.registerEnvOption ( "gasnet-segment", "NX_GASNET_SEGMENT_SIZE" );
+#endif
 
 }
 
@@ -237,10 +281,10 @@ unsigned ClusterPlugin::getNumThreads() const {
 }
 
 void ClusterPlugin::startSupportThreads() {
-   if ( _gasnetApi->getNumNodes() > 1 )
+   if ( _netApi->getNumNodes() > 1 )
    {
-      if ( _gasnetApi->getNodeNum() == 0 ) {
-         _clusterThread = dynamic_cast<ext::SMPMultiThread *>( &_cpu->startMultiWorker( _gasnetApi->getNumNodes() - 1, (ProcessingElement **) &(*_remoteNodes)[0] ) );
+      if ( _netApi->getNodeNum() == 0 ) {
+         _clusterThread = dynamic_cast<ext::SMPMultiThread *>( &_cpu->startMultiWorker( _netApi->getNumNodes() - 1, (ProcessingElement **) &(*_remoteNodes)[0] ) );
       } else {
          _clusterThread = dynamic_cast<ext::SMPMultiThread *>( &_cpu->startMultiWorker( 0, NULL ) );
          if ( sys.getPMInterface().getInternalDataSize() > 0 )
@@ -252,17 +296,17 @@ void ClusterPlugin::startSupportThreads() {
             sys.getNetwork()->enableCheckingForDataInOtherAddressSpaces();
          }
 
-         _gasnetApi->_rwgs = (GASNetAPI::ArchRWDs *) NEW GASNetAPI::ArchRWDs();
-         _gasnetApi->_rwgs[0][0] = getRemoteWorkDescriptor(0);
-         _gasnetApi->_rwgs[0][1] = getRemoteWorkDescriptor(1);
-         _gasnetApi->_rwgs[0][2] = getRemoteWorkDescriptor(2);
-         _gasnetApi->_rwgs[0][3] = getRemoteWorkDescriptor(3);
+         _netApi->_rwgs = (ClusterNetworkAPI::ArchRWDs *) NEW ClusterNetworkAPI::ArchRWDs();
+         _netApi->_rwgs[0][0] = getRemoteWorkDescriptor(0);
+         _netApi->_rwgs[0][1] = getRemoteWorkDescriptor(1);
+         _netApi->_rwgs[0][2] = getRemoteWorkDescriptor(2);
+         _netApi->_rwgs[0][3] = getRemoteWorkDescriptor(3);
       }
    }
 }
 
 void ClusterPlugin::startWorkerThreads( std::map<unsigned int, BaseThread *> &workers ) {
-   if ( _gasnetApi->getNodeNum() == 0 )
+   if ( _netApi->getNodeNum() == 0 )
    {
       if ( _clusterThread ) {
          for ( unsigned int thdIndex = 0; thdIndex < _clusterThread->getNumThreads(); thdIndex += 1 )
@@ -277,7 +321,7 @@ void ClusterPlugin::startWorkerThreads( std::map<unsigned int, BaseThread *> &wo
 }
 
 void ClusterPlugin::finalize() {
-   if ( _gasnetApi->getNodeNum() == 0 ) {
+   if ( _netApi->getNodeNum() == 0 ) {
       //message0("Master: Created " << createdWds << " WDs.");
       //message0("Master: Failed to correctly schedule " << sys.getAffinityFailureCount() << " WDs.");
       int soft_inv = 0;
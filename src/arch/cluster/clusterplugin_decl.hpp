@@ -23,14 +23,24 @@
 #include "plugin.hpp"
 #include "system_decl.hpp"
 #include "clusternode_decl.hpp"
+#ifdef NANOS_CLUSTER_SHM
+#include "shmnetapi_fwd.hpp"
+#else
 #include "gasnetapi_fwd.hpp"
+#endif
 
 namespace nanos {
 namespace ext {
 
+#ifdef NANOS_CLUSTER_SHM
+typedef SHMNetAPI ClusterNetworkAPI;
+#else
+typedef GASNetAPI ClusterNetworkAPI;
+#endif
+
 class ClusterPlugin : public ArchPlugin
 {
-      GASNetAPI *_gasnetApi;
+      ClusterNetworkAPI *_netApi;
 
       unsigned int _numPinnedSegments;
       void ** _pinnedSegmentAddrList;
@@ -43,11 +53,17 @@ class ClusterPlugin : public ArchPlugin
       bool _unalignedNodeMem;
       int _gpuPresend;
       int _smpPresend;
+      std::size_t _aggregationFrameSize;
+      unsigned int _aggregationTimeout;
       System::CachePolicyType _cachePolicy;
       std::vector<ext::ClusterNode *> *_remoteNodes;
       ext::SMPProcessor *_cpu;
       ext::SMPMultiThread *_clusterThread;
       std::size_t _gasnetSegmentSize;
+#ifdef NANOS_CLUSTER_SHM
+      unsigned int _shmNodes;
+      std::size_t _shmRingSize;
+#endif
 
    public:
       ClusterPlugin();
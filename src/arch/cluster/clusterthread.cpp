@@ -26,6 +26,7 @@
 #include "basethread.hpp"
 #include "smpthread.hpp"
 #include "netwd_decl.hpp"
+#include "chunkpool.hpp"
 #ifdef OpenCL_DEV
 #include "opencldd.hpp"
 #endif
@@ -63,7 +64,7 @@ void ClusterThread::RunningWDQueue::clearCompletedWDs( ClusterThread *self ) {
    {
       WD *completedWD = _completedWDs[pos];
       Scheduler::postOutlineWork( completedWD, false, self );
-      delete[] (char *) completedWD;
+      ChunkPool::deallocate( completedWD );
       _completedWDs[pos] =(WD *) 0xdeadbeef;
       pos = (pos+1) % MAX_PRESEND;
       lowval += 1;
@@ -282,6 +283,7 @@ void ClusterThread::idle( bool debug )
    myThread = parent;
    sys.getNetwork()->poll(0);
    myThread = orig_myThread;
+   sys.getNetwork()->notifyThreadIdle( getId() );
 
    if ( !_pendingRequests.empty() ) {
       std::set<void *>::iterator it = _pendingRequests.begin();
@@ -129,6 +129,7 @@ GASNetAPI::GASNetAPI() : _net( 0 ),
    _nodeBarrierCounter( 0 ),
    _GASNetSegmentSize( 0 ),
    _unalignedNodeMemory( false ),
+   _wdTemplates(),
    _rwgs( 0 ) {
    _instance = this;
 }
@@ -244,6 +245,7 @@ void GASNetAPI::SendDataGetRequest::doSingleChunk() {
 }
 
 void GASNetAPI::SendDataGetRequest::doStrided( void *localAddr ) {
+   Packer::pack( ( char * ) localAddr, ( char * ) _origAddr, _len, _count, _ld );
    NANOS_INSTRUMENT ( static Instrumentation *instr = sys.getInstrumentation(); )
    NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = instr->getInstrumentationDictionary(); )
    NANOS_INSTRUMENT ( static nanos_event_key_t network_transfer_key = ID->getEventKey("network-transfer"); )
@@ -338,15 +340,18 @@ void GASNetAPI::amWork(gasnet_token_t token, void *arg, std::size_t argSize,
    }
 
    char *work_data = getInstance()->_incomingWorkBuffers.get(wdId, totalArgSize, argSize, (char *) arg);
-   Net2WD nwd( work_data, totalArgSize, getInstance()->_rwgs[src_node] ); // FIXME
+   Net2WD nwd( work_data, totalArgSize, getInstance()->_rwgs[src_node], src_node, expectedData, seq, getInstance()->_wdTemplates ); // FIXME
 
-   if ( _emitPtPEvents ) {
-      NANOS_INSTRUMENT ( static Instrumentation *instr = sys.getInstrumentation(); )
-      NANOS_INSTRUMENT ( nanos_event_id_t id = (nanos_event_id_t) ( nwd.getWD()->getRemoteAddr() ) ; )
-      NANOS_INSTRUMENT ( instr->raiseClosePtPEvent( NANOS_AM_WORK, id, 0, 0, src_node ); )
-   }
+   for ( unsigned int i = 0; i < nwd.getNumWDs(); i += 1 ) {
+      Net2WD::ReceivedWork const &work = nwd.getWork( i );
+      if ( _emitPtPEvents ) {
+         NANOS_INSTRUMENT ( static Instrumentation *instr = sys.getInstrumentation(); )
+         NANOS_INSTRUMENT ( nanos_event_id_t id = (nanos_event_id_t) ( work._wd->getRemoteAddr() ) ; )
+         NANOS_INSTRUMENT ( instr->raiseClosePtPEvent( NANOS_AM_WORK, id, 0, 0, src_node ); )
+      }
 
-   getInstance()->_net->notifyWork(expectedData, nwd.getWD(), seq);
+      getInstance()->_net->notifyWork(work._expectedData, work._wd, work._seq);
+   }
 
    delete[] work_data;
    VERBOSE_AM( (myThread != NULL ? (*myThread->_file) : std::cerr) << __FUNCTION__ << " done." << std::endl; );
@@ -606,10 +611,7 @@ void GASNetAPI::amPutStrided1D( gasnet_token_t token,
       char* realAddrPtr = (char *) realTag;
       char* localAddrPtr = ( (char *) ( ( ( uintptr_t ) buf ) + ( ( uintptr_t ) len ) - ( uintptr_t ) totalLen ) );
       //NANOS_INSTRUMENT( InstrumentState inst2(NANOS_STRIDED_COPY_UNPACK); );
-      for ( int i = 0; i < count; i += 1 ) {
-         ::memcpy( &realAddrPtr[ i * ld ], &localAddrPtr[ i * size ], size );
-         //if (i == 0)fprintf(stderr, "[%d] amPutStrided1D from %d: dst[%p]=%f buff[%p]=%f\n", gasnet_mynode(), src_node, &realAddrPtr[ i * ld], *((double*)&realAddrPtr[i*ld]), &localAddrPtr[i*size], *((double*)&localAddrPtr[i*size]) );
-      }
+      Packer::unpack( realAddrPtr, localAddrPtr, size, count, ld );
       //NANOS_INSTRUMENT( inst2.close(); );
       uintptr_t localAddr = ( ( uintptr_t ) buf ) + ( ( uintptr_t ) len ) - ( uintptr_t ) totalLen;
       getInstance()->enqueueFreeBufferNotify( issueNode, ( void * ) localAddr, wd );
@@ -905,6 +907,18 @@ void GASNetAPI::amIdle( gasnet_token_t token ) {
    getInstance()->_net->notifyIdle( src_node );
 }
 
+void GASNetAPI::amFrame( gasnet_token_t token, void *buff, std::size_t len ) {
+   DisableAM c;
+   gasnet_node_t src_node;
+   if (gasnet_AMGetMsgSource(token, &src_node) != GASNET_OK)
+   {
+      fprintf(stderr, "gasnet: Error obtaining node information.\n");
+   }
+   VERBOSE_AM( (myThread != NULL ? (*myThread->_file) : std::cerr) << __FUNCTION__ << " from " << src_node << std::endl; );
+   getInstance()->_net->notifyAggregatedMessages( src_node, (char *) buff, len );
+   VERBOSE_AM( (myThread != NULL ? (*myThread->_file) : std::cerr) << __FUNCTION__ << " done." << std::endl; );
+}
+
 void GASNetAPI::initialize ( Network *net )
 {
    int my_argc = OS::getArgc();
@@ -937,7 +951,8 @@ void GASNetAPI::initialize ( Network *net )
       { 223, (void (*)()) amGetReplyStrided1D },
       { 224, (void (*)()) amRegionMetadata },
       { 225, (void (*)()) amSynchronizeDirectory },
-      { 226, (void (*)()) amIdle }
+      { 226, (void (*)()) amIdle },
+      { 227, (void (*)()) amFrame }
    };
 
    gasnet_init( &my_argc, &my_argv );
@@ -1064,7 +1079,19 @@ void GASNetAPI::sendWorkMsg ( unsigned int dest, WorkDescriptor const &wd, std::
    std::size_t sent = 0;
    unsigned int msgCount = 0;
 
-   WD2Net nwd( wd );
+   WD2Net nwd( wd, dest, _wdTemplates );
+   unsigned int seq = _seqN[dest]++;
+
+   if ( _emitPtPEvents ) {
+      NANOS_INSTRUMENT ( static Instrumentation *instr = sys.getInstrumentation(); )
+      NANOS_INSTRUMENT ( nanos_event_id_t id = (nanos_event_id_t) ( &wd ) ; )
+      NANOS_INSTRUMENT ( instr->raiseOpenPtPEvent( NANOS_AM_WORK, id, 0, 0, dest ); )
+   }
+
+   uint64_t args[] = { ( uint64_t ) wd.getId(), expectedData, seq };
+   if ( _net->aggregateMessage( dest, AGGREGATED_WORK, args, sizeof( args ), nwd.getBuffer(), nwd.getBufferSize() ) ) {
+      return;
+   }
 
    while ( (nwd.getBufferSize() - sent) > gasnet_AMMaxMedium() )
    {
@@ -1084,11 +1111,6 @@ void GASNetAPI::sendWorkMsg ( unsigned int dest, WorkDescriptor const &wd, std::
    //std::size_t expectedData = _sentWdData.getSentData( wdId );
 
    //message("To node " << dest << " wd id " << wdId << " seq " << (_seqN[dest].value() + 1) << " expectedData=" << expectedData);
-   if ( _emitPtPEvents ) {
-      NANOS_INSTRUMENT ( static Instrumentation *instr = sys.getInstrumentation(); )
-      NANOS_INSTRUMENT ( nanos_event_id_t id = (nanos_event_id_t) ( &wd ) ; )
-      NANOS_INSTRUMENT ( instr->raiseOpenPtPEvent( NANOS_AM_WORK, id, 0, 0, dest ); )
-   }
 
    VERBOSE_AM( (myThread != NULL ? (*myThread->_file) : std::cerr) << __FUNCTION__ << " send amWork" << std::endl; );
    if (gasnet_AMRequestMedium6( dest, 205, &(nwd.getBuffer()[ sent ]), nwd.getBufferSize() - sent,
@@ -1097,7 +1119,7 @@ void GASNetAPI::sendWorkMsg ( unsigned int dest, WorkDescriptor const &wd, std::
             ARG_HI( nwd.getBufferSize() ),
             ARG_LO( expectedData ),
             ARG_HI( expectedData ),
-            _seqN[dest]++ ) != GASNET_OK)
+            seq ) != GASNET_OK)
    {
       fprintf(stderr, "gasnet: Error sending a message to node %d.\n", dest);
    }
@@ -1203,8 +1225,16 @@ void GASNetAPI::_putStrided1D ( unsigned int issueNode, unsigned int remoteNode,
 {
    std::size_t sent = 0, thisReqSize;
    std::size_t realSize = size * count;
+   // Messages carry whole rows, each one is packed right before being sent so packing
+   // overlaps with the injection of the previous message
+   std::size_t rowsPerReq = MAX_LONG_REQUEST / size;
+   std::size_t maxReqSize = rowsPerReq > 0 ? rowsPerReq * size : MAX_LONG_REQUEST;
+   char *localRows = ( char * ) localAddr;
    _txBytes += realSize;
    _totalBytes += realSize;
+   if ( rowsPerReq == 0 ) {
+      Packer::pack( ( char * ) localPack, localRows, size, count, ld );
+   }
    NANOS_INSTRUMENT ( static Instrumentation *instr = sys.getInstrumentation(); )
    NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = instr->getInstrumentationDictionary(); )
    NANOS_INSTRUMENT ( static nanos_event_key_t network_transfer_key = ID->getEventKey("network-transfer"); )
@@ -1212,12 +1242,15 @@ void GASNetAPI::_putStrided1D ( unsigned int issueNode, unsigned int remoteNode,
    {
       while ( sent < realSize )
       {
-         thisReqSize = ( ( realSize - sent ) <= MAX_LONG_REQUEST ) ? realSize - sent : MAX_LONG_REQUEST;
+         thisReqSize = ( ( realSize - sent ) <= maxReqSize ) ? realSize - sent : maxReqSize;
 
          NANOS_INSTRUMENT ( static nanos_event_key_t sizeKey = ID->getEventKey("xfer-size"); )
 
          if ( remoteTmpBuffer != NULL )
          { 
+            if ( rowsPerReq > 0 ) {
+               Packer::pack( &( ( char * ) localPack )[ sent ], &localRows[ ( sent / size ) * ld ], size, thisReqSize / size, ld );
+            }
             if ( _emitPtPEvents ) {
                NANOS_INSTRUMENT ( nanos_event_value_t xferSize = thisReqSize; )
                NANOS_INSTRUMENT ( nanos_event_id_t id = (nanos_event_id_t) ( ((uint64_t)remoteTmpBuffer) + sent ) ; )
@@ -1554,6 +1587,41 @@ void GASNetAPI::synchronizeDirectory(unsigned int dest, void *addr ) {
    VERBOSE_AM( (myThread != NULL ? (*myThread->_file) : std::cerr) << __FUNCTION__ << " send amSynchronizeDirectory done" << std::endl; );
 }
 
+std::size_t GASNetAPI::getMaxFrameSize() const {
+   return gasnet_AMMaxMedium();
+}
+
+void GASNetAPI::sendFrame( unsigned int dest, char const *frame, std::size_t len ) {
+   VERBOSE_AM( (myThread != NULL ? (*myThread->_file) : std::cerr) << __FUNCTION__ << " send amFrame" << std::endl; );
+   if ( gasnet_AMRequestMedium0( dest, 227, (void *) frame, len ) != GASNET_OK )
+   {
+      fprintf(stderr, "gasnet: Error sending a message to node %d.\n", dest);
+   }
+   VERBOSE_AM( (myThread != NULL ? (*myThread->_file) : std::cerr) << __FUNCTION__ << " send amFrame done" << std::endl; );
+}
+
+void GASNetAPI::processAggregatedMessage( unsigned int src, unsigned int type, char *data, std::size_t len ) {
+   switch ( type ) {
+      case AGGREGATED_WORK:
+         {
+            uint64_t const *args = ( uint64_t const * ) data;
+            Net2WD nwd( data + 3 * sizeof( uint64_t ), len - 3 * sizeof( uint64_t ), _rwgs[src], src, ( std::size_t ) args[1], ( unsigned int ) args[2], _wdTemplates );
+            for ( unsigned int i = 0; i < nwd.getNumWDs(); i += 1 ) {
+               Net2WD::ReceivedWork const &work = nwd.getWork( i );
+               if ( _emitPtPEvents ) {
+                  NANOS_INSTRUMENT ( static Instrumentation *instr = sys.getInstrumentation(); )
+                  NANOS_INSTRUMENT ( nanos_event_id_t id = (nanos_event_id_t) ( work._wd->getRemoteAddr() ) ; )
+                  NANOS_INSTRUMENT ( instr->raiseClosePtPEvent( NANOS_AM_WORK, id, 0, 0, src ); )
+               }
+               _net->notifyWork( work._expectedData, work._wd, work._seq );
+            }
+         }
+         break;
+      default:
+         fatal0( "Unknown aggregated message type " << type << " received from node " << src );
+   }
+}
+
 void GASNetAPI::broadcastIdle() {
    for ( unsigned int node = 0; node < _net->getNumNodes(); node += 1 )
    {
@@ -27,6 +27,7 @@
 #include "simpleallocator_decl.hpp"
 #include "requestqueue_decl.hpp"
 #include "remoteworkdescriptor_decl.hpp"
+#include "netwd_decl.hpp"
 #include <vector>
 
 extern "C" {
@@ -56,6 +57,9 @@ namespace ext {
             }
          };
 
+         //! \brief Work messages carried in aggregated frames
+         static const unsigned int AGGREGATED_WORK = Network::AGGREGATED_API_MESSAGE;
+
          Network *_net;
 #ifndef GASNET_SEGMENT_EVERYTHING
          SimpleAllocator *_thisNodeSegment;
@@ -164,6 +168,7 @@ namespace ext {
          unsigned int _nodeBarrierCounter;
          std::size_t _GASNetSegmentSize;
          bool _unalignedNodeMemory;
+         NetWDTemplates _wdTemplates;
 
       public:
          typedef RemoteWorkDescriptor *ArchRWDs[4]; //0: smp, 1: cuda, 2: opencl, 3: fpga
@@ -205,6 +210,9 @@ namespace ext {
          unsigned int getNodeNum() const;
          void synchronizeDirectory( unsigned int dest, void *addr );
          void broadcastIdle();
+         std::size_t getMaxFrameSize() const;
+         void sendFrame( unsigned int dest, char const *frame, std::size_t len );
+         void processAggregatedMessage( unsigned int src, unsigned int type, char *data, std::size_t len );
 
 
          void setGASNetSegmentSize(std::size_t segmentSize);
@@ -313,6 +321,7 @@ namespace ext {
                void *arg, std::size_t argSize, gasnet_handlerarg_t seq );
          static void amSynchronizeDirectory(gasnet_token_t token, gasnet_handlerarg_t addrLo, gasnet_handlerarg_t addrHi);
          static void amIdle(gasnet_token_t token);
+         static void amFrame(gasnet_token_t token, void *buff, std::size_t len );
    };
 } // namespace ext
 } // namespace nanos
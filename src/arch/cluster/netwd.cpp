@@ -63,26 +63,15 @@ namespace ext {
 
 
 std::size_t SerializedWDFields::getTotalSize( WD const &wd ) {
-   unsigned int totalDimensions = 0;
-   std::size_t total_size = 0;
-   for (unsigned int i = 0; i < wd.getNumCopies(); i += 1) {
-      totalDimensions += wd.getCopies()[i].getNumDimensions();
-   }
-   total_size = sizeof(SerializedWDFields) +
-      wd.getNumCopies() * sizeof( CopyData ) + 
-      totalDimensions * sizeof( nanos_region_dimension_t ) +
-      wd.getDataSize();
-   return total_size;
+   return sizeof(SerializedWDFields) + wd.getNumCopies() * sizeof( CopyData );
 }
 
 void SerializedWDFields::setup( WD const &wd ) {
-   _wdId =  wd.getId();
    _outline = wd.getActiveDevice().getWorkFct();
    _xlate =  wd.getTranslateArgs();
    _dataSize = wd.getDataSize();
    _numCopies = wd.getNumCopies();
    _descriptionAddr = wd.getDescription();
-   _wd = &wd;
    _totalDimensions = 0;
    for (unsigned int i = 0; i < wd.getNumCopies(); i += 1) {
       _totalDimensions += wd.getCopies()[i].getNumDimensions();
@@ -120,14 +109,6 @@ CopyData *SerializedWDFields::getCopiesAddr() const {
    return (CopyData *) addr;
 }
 
-nanos_region_dimension_internal_t *SerializedWDFields::getDimensionsAddr() const {
-   return (nanos_region_dimension_internal_t *) (((char *) getCopiesAddr()) + _numCopies * sizeof( CopyData ));
-}
-
-char *SerializedWDFields::getDataAddr() const {
-   return (((char *)getDimensionsAddr()) + _totalDimensions * sizeof( nanos_region_dimension_internal_t ));
-}
-
 std::size_t SerializedWDFields::getTotalDimensions() const {
    return _totalDimensions;
 }
@@ -144,14 +125,6 @@ unsigned int SerializedWDFields::getArchId() const {
    return _archId;
 }
 
-unsigned int SerializedWDFields::getWDId() const {
-   return _wdId;
-}
-
-WD const *SerializedWDFields::getWDAddr() const {
-   return _wd;
-}
-
 void (*SerializedWDFields::getOutline() const)(void *) {
    return _outline;
 }
@@ -164,36 +137,175 @@ const char *SerializedWDFields::getDescriptionAddr() const {
    return _descriptionAddr;
 }
 
-WD2Net::WD2Net( WD const &wd ) {
-   _bufferSize = SerializedWDFields::getTotalSize( wd );
-   _buffer = new char[ _bufferSize ];
-   SerializedWDFields *swd = ( SerializedWDFields * ) _buffer;
-   swd->setup( wd );
+void SerializedWDInstance::setup( WD const &wd, unsigned int templateId, std::size_t templateSize ) {
+   _templateId = templateId;
+   _wdId = wd.getId();
+   _wd = &wd;
+   _templateSize = templateSize;
+}
 
-   if ( wd.getDataSize() > 0 )
-   {
-      ::memcpy( swd->getDataAddr(), wd.getData(), wd.getDataSize() );
+unsigned int SerializedWDInstance::getTemplateId() const {
+   return _templateId;
+}
+
+unsigned int SerializedWDInstance::getWDId() const {
+   return _wdId;
+}
+
+WD const *SerializedWDInstance::getWDAddr() const {
+   return _wd;
+}
+
+std::size_t SerializedWDInstance::getTemplateSize() const {
+   return _templateSize;
+}
+
+char *SerializedWDInstance::getTemplateAddr() const {
+   return ((char *) this) + sizeof( SerializedWDInstance );
+}
+
+SerializedCopyInstance *SerializedWDInstance::getCopiesAddr() const {
+   return (SerializedCopyInstance *) ( getTemplateAddr() + _templateSize );
+}
+
+nanos_region_dimension_internal_t *SerializedWDInstance::getDimensionsAddr( SerializedWDFields const &fields ) const {
+   return (nanos_region_dimension_internal_t *) ( ((char *) getCopiesAddr()) + fields.getNumCopies() * sizeof( SerializedCopyInstance ) );
+}
+
+char *SerializedWDInstance::getDataAddr( SerializedWDFields const &fields ) const {
+   return ((char *) getDimensionsAddr( fields )) + fields.getTotalDimensions() * sizeof( nanos_region_dimension_internal_t );
+}
+
+NetWDTemplates::NetWDTemplates() : _sentLock(), _templateIds(), _registered(), _recvLock(), _templates(), _pendingWork() {
+}
+
+NetWDTemplates::~NetWDTemplates() {
+   for ( TemplateMap::iterator it = _templates.begin(); it != _templates.end(); it++ ) {
+      delete[] (char *) it->second;
    }
+   for ( PendingWorkMap::iterator it = _pendingWork.begin(); it != _pendingWork.end(); it++ ) {
+      delete[] it->second._buffer;
+   }
+}
 
-   CopyData *newCopies = ( CopyData * ) swd->getCopiesAddr();
-   nanos_region_dimension_internal_t *dimensions = ( nanos_region_dimension_internal_t * ) swd->getDimensionsAddr();
-   
+bool NetWDTemplates::getTemplateId( unsigned int dest, std::string const &tmpl, unsigned int &id ) {
+   bool mustRegister = false;
+   _sentLock.acquire();
+   TemplateIdMap::iterator it = _templateIds.find( tmpl );
+   if ( it == _templateIds.end() ) {
+      it = _templateIds.insert( std::make_pair( tmpl, (unsigned int) _templateIds.size() ) ).first;
+   }
+   id = it->second;
+   if ( dest >= _registered.size() ) {
+      _registered.resize( dest + 1 );
+   }
+   std::vector< bool > &registered = _registered[ dest ];
+   if ( id >= registered.size() ) {
+      registered.resize( id + 1, false );
+   }
+   if ( !registered[ id ] ) {
+      registered[ id ] = true;
+      mustRegister = true;
+   }
+   _sentLock.release();
+   return mustRegister;
+}
+
+SerializedWDFields const *NetWDTemplates::registerTemplate( unsigned int src, unsigned int id, SerializedWDFields const *tmpl, std::size_t size, std::vector< PendingWork > &ready ) {
+   char *storage = NEW char[ size ];
+   ::memcpy( storage, tmpl, size );
+   std::pair< unsigned int, unsigned int > key( src, id );
+
+   _recvLock.acquire();
+   ensure( _templates.find( key ) == _templates.end(), "WD template registered twice." );
+   _templates[ key ] = (SerializedWDFields *) storage;
+   std::pair< PendingWorkMap::iterator, PendingWorkMap::iterator > range = _pendingWork.equal_range( key );
+   for ( PendingWorkMap::iterator it = range.first; it != range.second; it++ ) {
+      ready.push_back( it->second );
+   }
+   _pendingWork.erase( range.first, range.second );
+   _recvLock.release();
+   return (SerializedWDFields const *) storage;
+}
+
+SerializedWDFields const *NetWDTemplates::findTemplate( unsigned int src, unsigned int id, char const *buffer, std::size_t size, std::size_t expectedData, unsigned int seq ) {
+   SerializedWDFields const *tmpl = NULL;
+   std::pair< unsigned int, unsigned int > key( src, id );
+
+   _recvLock.acquire();
+   TemplateMap::const_iterator it = _templates.find( key );
+   if ( it != _templates.end() ) {
+      tmpl = it->second;
+   } else {
+      // the message that registers this template has not arrived yet
+      PendingWork work = { NEW char[ size ], expectedData, seq };
+      ::memcpy( work._buffer, buffer, size );
+      _pendingWork.insert( std::make_pair( key, work ) );
+   }
+   _recvLock.release();
+   return tmpl;
+}
+
+WD2Net::WD2Net( WD const &wd, unsigned int dest, NetWDTemplates &templates ) {
+   std::size_t templateSize = SerializedWDFields::getTotalSize( wd );
+   std::size_t totalDimensions = 0;
+   for (unsigned int i = 0; i < wd.getNumCopies(); i += 1) {
+      totalDimensions += wd.getCopies()[i].getNumDimensions();
+   }
+   std::size_t instanceSize = wd.getNumCopies() * sizeof( SerializedCopyInstance ) +
+      totalDimensions * sizeof( nanos_region_dimension_internal_t ) +
+      wd.getDataSize();
+
+   _buffer = NEW char[ sizeof( SerializedWDInstance ) + templateSize + instanceSize ];
+   SerializedWDInstance *swi = ( SerializedWDInstance * ) _buffer;
+
+   // Build the template in place, it is kept in the buffer only if it has to be registered
+   SerializedWDFields *swd = ( SerializedWDFields * ) swi->getTemplateAddr();
+   ::memset( swd, 0, templateSize );
+   swd->setup( wd );
+   SerializedWDFields fields = *swd;
+
+   CopyData *tmplCopies = swd->getCopiesAddr();
    uintptr_t dimensionIndex = 0;
    for (unsigned int i = 0; i < wd.getNumCopies(); i += 1) {
       CopyData &cd = ( wd.getCopies()[i].getDeductedCD() != NULL ) 
          ? *(wd.getCopies()[i].getDeductedCD()) 
          : wd.getCopies()[i];
-      new ( &newCopies[i] ) CopyData( cd );
-      if ( newCopies[i].getDeductedCD() != NULL ) {
+      if ( cd.getDeductedCD() != NULL ) {
          std::cerr << "REGISTERED REG!!!!" << std::endl;
       }
+      // The dimensions field is the index because it makes no sense to send an address over the network
+      new ( &tmplCopies[i] ) CopyData( 0, cd.getSharing(), cd.isInput(), cd.isOutput(), cd.getNumDimensions(), ( nanos_region_dimension_internal_t * ) dimensionIndex, 0, 0, 0 );
+      tmplCopies[i].setRemoteHost( true );
+      dimensionIndex += cd.getNumDimensions();
+   }
+
+   unsigned int templateId = 0;
+   bool mustRegister = templates.getTemplateId( dest, std::string( (char *) swd, templateSize ), templateId );
+   if ( !mustRegister ) {
+      templateSize = 0;
+   }
+   swi->setup( wd, templateId, templateSize );
+   _bufferSize = sizeof( SerializedWDInstance ) + templateSize + instanceSize;
+
+   if ( wd.getDataSize() > 0 )
+   {
+      ::memcpy( swi->getDataAddr( fields ), wd.getData(), wd.getDataSize() );
+   }
+
+   SerializedCopyInstance *newCopies = swi->getCopiesAddr();
+   nanos_region_dimension_internal_t *dimensions = swi->getDimensionsAddr( fields );
+   dimensionIndex = 0;
+   for (unsigned int i = 0; i < wd.getNumCopies(); i += 1) {
+      CopyData &cd = ( wd.getCopies()[i].getDeductedCD() != NULL ) 
+         ? *(wd.getCopies()[i].getDeductedCD()) 
+         : wd.getCopies()[i];
       memcpy( &dimensions[ dimensionIndex ], cd.getDimensions(), sizeof( nanos_region_dimension_internal_t ) * cd.getNumDimensions());
-      newCopies[i].setDimensions( ( nanos_region_dimension_internal_t *  ) dimensionIndex ); // This is the index because it makes no sense to send an address over the network
-      newCopies[i].setHostBaseAddress( (uint64_t) cd.getBaseAddress() );
-      newCopies[i].setRemoteHost( true );
-      //newCopies[i].setBaseAddress( (void *) ( wd._ccontrol.getAddress( i ) - cd.getOffset() ) );
-      newCopies[i].setBaseAddress( (void *) wd._mcontrol.getAddress( i ) );
-      newCopies[i].setHostRegionId( wd._mcontrol._memCacheCopies[i]._reg.id );
+      newCopies[i]._hostBaseAddress = (uint64_t) cd.getBaseAddress();
+      newCopies[i]._offset = cd.getOffset();
+      //newCopies[i]._baseAddress = wd._ccontrol.getAddress( i ) - cd.getOffset();
+      newCopies[i]._baseAddress = wd._mcontrol.getAddress( i );
+      newCopies[i]._hostRegionId = wd._mcontrol._memCacheCopies[i]._reg.id;
       dimensionIndex += cd.getNumDimensions();
    }
 }
@@ -212,12 +324,33 @@ std::size_t WD2Net::getBufferSize() const {
    return _bufferSize;
 }
 
-Net2WD::Net2WD( char *buffer, std::size_t buffer_size, RemoteWorkDescriptor **rwds ) {
-   SerializedWDFields *swd = (SerializedWDFields *) buffer;
+Net2WD::Net2WD( char *buffer, std::size_t buffer_size, RemoteWorkDescriptor **rwds, unsigned int src, std::size_t expectedData, unsigned int seq, NetWDTemplates &templates ) : _work(), _releasedWork() {
+   SerializedWDInstance *swi = (SerializedWDInstance *) buffer;
+   SerializedWDFields const *fields = NULL;
+   std::vector< NetWDTemplates::PendingWork > ready;
+
+   _work._wd = NULL;
+   if ( swi->getTemplateSize() > 0 ) {
+      fields = templates.registerTemplate( src, swi->getTemplateId(), ( SerializedWDFields const * ) swi->getTemplateAddr(), swi->getTemplateSize(), ready );
+   } else {
+      fields = templates.findTemplate( src, swi->getTemplateId(), buffer, buffer_size, expectedData, seq );
+   }
+
+   if ( fields != NULL ) {
+      _work = createWD( *fields, buffer, rwds, expectedData, seq );
+      for ( std::vector< NetWDTemplates::PendingWork >::iterator it = ready.begin(); it != ready.end(); it++ ) {
+         _releasedWork.push_back( createWD( *fields, it->_buffer, rwds, it->_expectedData, it->_seq ) );
+         delete[] it->_buffer;
+      }
+   }
+}
+
+Net2WD::ReceivedWork Net2WD::createWD( SerializedWDFields const &fields, char const *buffer, RemoteWorkDescriptor **rwds, std::size_t expectedData, unsigned int seq ) {
+   SerializedWDInstance const *swi = (SerializedWDInstance const *) buffer;
 
-   nanos_smp_args_t smp_args = { swd->getOutline() };
+   nanos_smp_args_t smp_args = { fields.getOutline() };
    nanos_device_t dev = { NULL, (void *) &smp_args };
-   switch (swd->getArchId()) {
+   switch (fields.getArchId()) {
       case 0: //SMP
          dev.factory = local_nanos_smp_factory; 
          break;
@@ -240,40 +373,52 @@ Net2WD::Net2WD( char *buffer, std::size_t buffer_size, RemoteWorkDescriptor **rw
          break;
    }
 
-   int num_dimensions = swd->getTotalDimensions();
+   int num_dimensions = fields.getTotalDimensions();
    nanos_region_dimension_internal_t *dimensions = NULL;
    nanos_region_dimension_internal_t **dimensions_ptr = ( num_dimensions > 0 ) ? &dimensions : NULL ;
    char *data = NULL;
    CopyData *newCopies = NULL;
-   CopyData **newCopiesPtr = ( swd->getNumCopies() > 0 ) ? &newCopies : NULL ;
+   CopyData **newCopiesPtr = ( fields.getNumCopies() > 0 ) ? &newCopies : NULL ;
 
-   _wd = NULL;
-   sys.createWD( &_wd, (std::size_t) 1, &dev, swd->getDataSize(), (int) ( sizeof(void *) ), (void **) &data, rwds[swd->getArchId()], (nanos_wd_props_t *) NULL, (nanos_wd_dyn_props_t *) NULL, swd->getNumCopies(), newCopiesPtr, num_dimensions, dimensions_ptr, swd->getXlateFunc(), swd->getDescriptionAddr(), NULL );
+   WD *wd = NULL;
+   sys.createWD( &wd, (std::size_t) 1, &dev, fields.getDataSize(), (int) ( sizeof(void *) ), (void **) &data, rwds[fields.getArchId()], (nanos_wd_props_t *) NULL, (nanos_wd_dyn_props_t *) NULL, fields.getNumCopies(), newCopiesPtr, num_dimensions, dimensions_ptr, fields.getXlateFunc(), fields.getDescriptionAddr(), NULL );
 
-   std::memcpy(data, swd->getDataAddr(), swd->getDataSize());
+   std::memcpy(data, swi->getDataAddr( fields ), fields.getDataSize());
 
-   // Set copies and dimensions, getDimensions() returns an index here, instead of a pointer,
-   // the index is the position inside the dimension array that must be set as the base address for the dimensions
-   CopyData *recvCopies = swd->getCopiesAddr();
-   nanos_region_dimension_t *recvDimensions = swd->getDimensionsAddr();
-   if ( swd->getNumCopies() > 0 ) {
-      memcpy( *dimensions_ptr, recvDimensions, num_dimensions * sizeof(nanos_region_dimension_t) );
+   // Set copies and dimensions, the template copies hold the index of their first dimension
+   // inside the dimension array instead of a pointer
+   CopyData const *tmplCopies = fields.getCopiesAddr();
+   SerializedCopyInstance const *recvCopies = swi->getCopiesAddr();
+   if ( fields.getNumCopies() > 0 ) {
+      memcpy( *dimensions_ptr, swi->getDimensionsAddr( fields ), num_dimensions * sizeof(nanos_region_dimension_t) );
    }
-   for (unsigned int i = 0; i < swd->getNumCopies(); i += 1)
+   for (unsigned int i = 0; i < fields.getNumCopies(); i += 1)
    {
-      new ( &newCopies[i] ) CopyData( recvCopies[i] );
-      newCopies[i].setDimensions( (*dimensions_ptr) + ( ( uintptr_t ) recvCopies[i].getDimensions() ) );
+      CopyData const &tmpl = tmplCopies[i];
+      new ( &newCopies[i] ) CopyData( recvCopies[i]._baseAddress, tmpl.getSharing(), tmpl.isInput(), tmpl.isOutput(), tmpl.getNumDimensions(),
+            (*dimensions_ptr) + ( ( uintptr_t ) tmpl.getDimensions() ), (ptrdiff_t) recvCopies[i]._offset, recvCopies[i]._hostBaseAddress, (reg_t) recvCopies[i]._hostRegionId );
+      newCopies[i].setRemoteHost( true );
    }
 
-   _wd->setHostId( swd->getWDId() );
-   _wd->setRemoteAddr( swd->getWDAddr() );
+   wd->setHostId( swi->getWDId() );
+   wd->setRemoteAddr( swi->getWDAddr() );
+
+   ReceivedWork work = { wd, expectedData, seq };
+   return work;
 }
 
 Net2WD::~Net2WD() {
 }
 
-WD *Net2WD::getWD() {
-   return _wd;
+std::size_t Net2WD::getNumWDs() const {
+   return ( _work._wd != NULL ? 1 : 0 ) + _releasedWork.size();
+}
+
+Net2WD::ReceivedWork const &Net2WD::getWork( unsigned int i ) const {
+   if ( _work._wd != NULL ) {
+      return ( i == 0 ) ? _work : _releasedWork[ i - 1 ];
+   }
+   return _releasedWork[ i ];
 }
 
 }
@@ -1,12 +1,21 @@
+#ifndef _NETWD_DECL
+#define _NETWD_DECL
+
 #include "nanos-int.h"
 #include "workdescriptor_fwd.hpp"
 #include "remoteworkdescriptor_decl.hpp"
+#include "lock_decl.hpp"
+#include <map>
+#include <string>
+#include <vector>
 
 namespace nanos {
 namespace ext {
 
+   /*! \brief Fields of a serialized WD that are constant for a task type,
+    *         sent once per node pair as a template (see NetWDTemplates).
+    */
    class SerializedWDFields {
-      unsigned int _wdId;
       int          _archId;
       void       (*_outline)(void *);
       void       (*_xlate)(void *, void*);
@@ -14,45 +23,123 @@ namespace ext {
       std::size_t  _numCopies;
       std::size_t  _totalDimensions;
       const char  *_descriptionAddr;
-      WD const    *_wd;
       public:
       static std::size_t getTotalSize( WD const &wd );
       void setup( WD const &wd );
       CopyData *getCopiesAddr() const;
-      nanos_region_dimension_internal_t *getDimensionsAddr() const;
-      char *getDataAddr() const;
       std::size_t getTotalDimensions() const;
       std::size_t getDataSize() const;
       void (*getXlateFunc() const)(void *, void*);
       void (*getOutline() const)(void *);
       unsigned int getArchId() const;
-      unsigned int getWDId() const;
-      WD const *getWDAddr() const;
       unsigned int getNumCopies() const;
       const char *getDescriptionAddr() const;
    };
 
+   /*! \brief Per task part of a serialized CopyData */
+   struct SerializedCopyInstance {
+      uint64_t _baseAddress;
+      uint64_t _hostBaseAddress;
+      uint64_t _offset;
+      uint64_t _hostRegionId;
+   };
+
+   /*! \brief Header of a serialized WD. It is followed by the template fields
+    *         (only when _templateSize > 0), a SerializedCopyInstance per copy,
+    *         the dimensions of the copies and the data of the WD.
+    */
+   class SerializedWDInstance {
+      unsigned int _templateId;
+      unsigned int _wdId;
+      WD const    *_wd;
+      std::size_t  _templateSize;
+      public:
+      void setup( WD const &wd, unsigned int templateId, std::size_t templateSize );
+      unsigned int getTemplateId() const;
+      unsigned int getWDId() const;
+      WD const *getWDAddr() const;
+      std::size_t getTemplateSize() const;
+      char *getTemplateAddr() const;
+      SerializedCopyInstance *getCopiesAddr() const;
+      nanos_region_dimension_internal_t *getDimensionsAddr( SerializedWDFields const &fields ) const;
+      char *getDataAddr( SerializedWDFields const &fields ) const;
+   };
+
+   /*! \brief Serialization templates of this node: the ones registered at each
+    *         destination and the ones received from each source node.
+    */
+   class NetWDTemplates {
+      public:
+         struct PendingWork {
+            char        *_buffer;
+            std::size_t  _expectedData;
+            unsigned int _seq;
+         };
+      private:
+         typedef std::map< std::string, unsigned int > TemplateIdMap;
+         typedef std::map< std::pair< unsigned int, unsigned int >, SerializedWDFields * > TemplateMap;
+         typedef std::multimap< std::pair< unsigned int, unsigned int >, PendingWork > PendingWorkMap;
+
+         Lock                     _sentLock;
+         TemplateIdMap            _templateIds;
+         std::vector< std::vector< bool > > _registered; //!< per destination, indexed by template id
+         Lock                     _recvLock;
+         TemplateMap              _templates;
+         PendingWorkMap           _pendingWork;
+
+         NetWDTemplates( NetWDTemplates const & );
+         NetWDTemplates &operator=( NetWDTemplates const & );
+      public:
+         NetWDTemplates();
+         ~NetWDTemplates();
+
+         /*! \brief Get the id of a template, returns true if it has to be
+          *         registered at dest by the message being built.
+          */
+         bool getTemplateId( unsigned int dest, std::string const &tmpl, unsigned int &id );
+         /*! \brief Register a template received from src, the work that was
+          *         held back waiting for it is returned in ready.
+          */
+         SerializedWDFields const *registerTemplate( unsigned int src, unsigned int id, SerializedWDFields const *tmpl, std::size_t size, std::vector< PendingWork > &ready );
+         /*! \brief Find a template received from src. If it is not known yet,
+          *         a copy of the message is held back until it is registered.
+          */
+         SerializedWDFields const *findTemplate( unsigned int src, unsigned int id, char const *buffer, std::size_t size, std::size_t expectedData, unsigned int seq );
+   };
+
    class WD2Net {
       std::size_t _bufferSize;
-      std::size_t _dataSize;
       char *_buffer;
-      void build();
       WD2Net( WD2Net const &nwd );
       WD2Net &operator=( WD2Net const & );
       public:
-      WD2Net( WD const &wd );
+      WD2Net( WD const &wd, unsigned int dest, NetWDTemplates &templates );
       ~WD2Net();
       char *getBuffer() const;
       std::size_t getBufferSize() const;
    };
 
+   /*! \brief Builds the WDs of a work message. The message may be held back
+    *         until its template arrives, or release other held messages.
+    */
    class Net2WD {
-      WD *_wd;
       public:
-      Net2WD( char *buffer, std::size_t buffer_size, RemoteWorkDescriptor **rwds );
+         struct ReceivedWork {
+            WD          *_wd;
+            std::size_t  _expectedData;
+            unsigned int _seq;
+         };
+      private:
+         ReceivedWork                _work;         //!< work of this message, _wd is NULL if it was held back
+         std::vector< ReceivedWork > _releasedWork; //!< held back work released by this message
+         ReceivedWork createWD( SerializedWDFields const &fields, char const *buffer, RemoteWorkDescriptor **rwds, std::size_t expectedData, unsigned int seq );
+      public:
+      Net2WD( char *buffer, std::size_t buffer_size, RemoteWorkDescriptor **rwds, unsigned int src, std::size_t expectedData, unsigned int seq, NetWDTemplates &templates );
       ~Net2WD();
-      WD *getWD();
+      std::size_t getNumWDs() const;
+      ReceivedWork const &getWork( unsigned int i ) const;
    };
 } // namespace ext
 } // namespace nanos
 
+#endif /* _NETWD_DECL */
@@ -0,0 +1,910 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#include "shmnetapi_decl.hpp"
+#include "system.hpp"
+#include "os.hpp"
+#include "osallocator_decl.hpp"
+#include "requestqueue.hpp"
+#include "atomic.hpp"
+#include "lock.hpp"
+#include "packer_decl.hpp"
+#include "netwd_decl.hpp"
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#define DEFAULT_SEGMENT_SIZE ( 32 * 1024 * 1024 )
+#define DEFAULT_RING_SIZE    ( 256 * 1024 )
+#define MIN_RING_SIZE        ( 4096 )
+
+using namespace nanos;
+using namespace ext;
+
+//! \brief Messages start at 8 byte boundaries of the ring
+static inline std::size_t alignMessage( std::size_t len )
+{
+   return ( len + 7 ) & ~( ( std::size_t ) 7 );
+}
+
+SHMNetAPI *SHMNetAPI::_instance = 0;
+
+SHMNetAPI *SHMNetAPI::getInstance() {
+   return _instance;
+}
+
+SHMNetAPI::SHMNetAPI() : _dataSendRequests(), _freeBufferReqs(), _workDoneReqs(), _net( 0 ),
+   _numNodes( 1 ), _nodeNum( 0 ), _children(), _pollCount( 0 ), _mapping( NULL ), _mappingSize( 0 ), _shared( NULL ),
+   _ringSize( DEFAULT_RING_SIZE ), _ringStride( 0 ), _rings( NULL ), _segmentSize( DEFAULT_SEGMENT_SIZE ),
+   _segments( NULL ), _sendLocks(), _recvLocks(), _recvBuffers(), _thisNodeSegment( NULL ),
+   _thisNodeSegmentLock(), _packSegment( NULL ), _pinnedAllocators(), _pinnedAllocatorsLocks(), _seqN( 0 ),
+   _rxBytes( 0 ), _txBytes( 0 ), _totalBytes( 0 ), _unalignedNodeMemory( false ), _wdTemplates(), _rwgs( 0 ) {
+   _instance = this;
+}
+
+SHMNetAPI::~SHMNetAPI(){
+}
+
+SHMNetAPI::SendDataPutRequestPayload::SendDataPutRequestPayload( unsigned int issueNode, unsigned int seqNumber, void *origAddr,
+      void *dstAddr, std::size_t len, std::size_t count, std::size_t ld, unsigned int dest, unsigned int wdId, void *tmpBuffer,
+      WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq ) : _issueNode( issueNode ), _seqNumber( seqNumber ),
+   _origAddr( origAddr ), _destAddr( dstAddr ), _len( len ), _count( count ), _ld( ld ), _destination( dest ), _wdId( wdId ),
+   _tmpBuffer( tmpBuffer ), _wd( wd ), _hostObject( hostObject ), _hostRegId( hostRegId ), _metaSeq( metaSeq ) {
+}
+
+SHMNetAPI::SendDataGetRequestPayload::SendDataGetRequestPayload( unsigned int seqNumber, void *origAddr, void *dstAddr, std::size_t len,
+   std::size_t count, std::size_t ld, GetRequest *req, CopyData const &cd ) :
+   _seqNumber( seqNumber ), _origAddr( origAddr ), _destAddr( dstAddr ), _len( len ), _count( count ), _ld( ld ), _req( req ),
+   _cd( cd ) {
+}
+
+SHMNetAPI::SHMSendDataRequest::SHMSendDataRequest( SHMNetAPI *api, unsigned int issueNode, unsigned int seqNumber, void *origAddr, void *destAddr, std::size_t len, std::size_t count, std::size_t ld, unsigned int dst, unsigned int wdId, void *hostObject, reg_t hostRegId, unsigned int metaSeq ) :
+   SendDataRequest( api, issueNode, seqNumber, origAddr, destAddr, len, count, ld, dst, wdId, hostObject, hostRegId, metaSeq ), _shmApi( api ) {
+}
+
+SHMNetAPI::SendDataPutRequest::SendDataPutRequest( SHMNetAPI *api, SendDataPutRequestPayload *msg ) :
+   SHMSendDataRequest( api, msg->_issueNode, msg->_seqNumber, msg->_origAddr, msg->_destAddr, msg->_len, msg->_count, msg->_ld, msg->_destination, msg->_wdId, msg->_hostObject, msg->_hostRegId, msg->_metaSeq ), _tmpBuffer( msg->_tmpBuffer ), _wd( msg->_wd ) {
+}
+
+SHMNetAPI::SendDataPutRequest::~SendDataPutRequest() {
+}
+
+void SHMNetAPI::SendDataPutRequest::doSingleChunk() {
+   _shmApi->_put( getIssueNode(), getDestination(), (uint64_t) _destAddr, _origAddr, _len, _tmpBuffer, _wdId, _wd, _hostObject, _hostRegId, _metaSeq );
+}
+
+void SHMNetAPI::SendDataPutRequest::doStrided( void *localAddr ) {
+   // rows are packed straight into the temporary buffer of the destination, localAddr is not needed
+   _shmApi->_putStrided1D( getIssueNode(), getDestination(), (uint64_t) _destAddr, _origAddr, _len, _count, _ld, _tmpBuffer, _wdId, _wd, _hostObject, _hostRegId, _metaSeq );
+}
+
+SHMNetAPI::SendDataGetRequest::SendDataGetRequest( SHMNetAPI *api, unsigned int seqNumber, unsigned int dest, void *origAddr, void *destAddr, std::size_t len, std::size_t count, std::size_t ld, GetRequest *req, CopyData const &cd, nanos_region_dimension_internal_t *dims ) :
+   SHMSendDataRequest( api, dest, seqNumber, origAddr, destAddr, len, count, ld, dest, 0, (void *) cd.getHostBaseAddress(),
+   cd.getHostRegionId(), 0 /* metaSeq is unused in this context */ ), _req( req ), _cd( cd ) {
+   nanos_region_dimension_internal_t *cd_dims = NEW nanos_region_dimension_internal_t[ _cd.getNumDimensions() ];
+   ::memcpy( cd_dims, dims, sizeof(nanos_region_dimension_internal_t) * _cd.getNumDimensions());
+   _cd.setDimensions( cd_dims );
+}
+
+SHMNetAPI::SendDataGetRequest::~SendDataGetRequest() {
+   delete[] _cd.getDimensions();
+}
+
+void SHMNetAPI::SendDataGetRequest::doSingleChunk() {
+   // _destAddr is a receive buffer of the requester, it lives in its segment of the shared mapping
+   ::memcpy( _destAddr, _origAddr, _len );
+   uint64_t args[] = { ( uintptr_t ) _req };
+   _shmApi->sendMessage( _destination, MSG_GET_REPLY, args, 1 );
+}
+
+void SHMNetAPI::SendDataGetRequest::doStrided( void *localAddr ) {
+   Packer::pack( ( char * ) _destAddr, ( char * ) _origAddr, _len, _count, _ld );
+   uint64_t args[] = { ( uintptr_t ) _req };
+   _shmApi->sendMessage( _destination, MSG_GET_REPLY, args, 1 );
+}
+
+SHMNetAPI::FreeBufferRequest::FreeBufferRequest(unsigned int dest, void *addr, WD const *w ) : destination( dest ), address( addr ), wd ( w ) {
+}
+
+void SHMNetAPI::processSendDataRequest( SendDataRequest *req ) {
+   _dataSendRequests.add( req );
+}
+
+void SHMNetAPI::checkForPutReqs()
+{
+   SendDataRequest *req = _dataSendRequests.tryFetch();
+   if ( req != NULL ) {
+      req->doSend();
+      delete req;
+   }
+}
+
+void SHMNetAPI::enqueueFreeBufferNotify( unsigned int dest, void *tmpBuffer, WD const *wd )
+{
+   FreeBufferRequest *addrWd = NEW FreeBufferRequest( dest, tmpBuffer, wd );
+   _freeBufferReqs.add( addrWd );
+}
+
+void SHMNetAPI::checkForFreeBufferReqs()
+{
+   FreeBufferRequest *req = _freeBufferReqs.tryFetch();
+   if ( req != NULL ) {
+      sendFreeTmpBuffer( req->destination, req->address, req->wd );
+      delete req;
+   }
+}
+
+void SHMNetAPI::checkWorkDoneReqs()
+{
+   std::pair<void const *, unsigned int> *rwd = _workDoneReqs.tryFetch();
+   if ( rwd != NULL ) {
+      _sendWorkDoneMsg( rwd->second, rwd->first );
+      delete rwd;
+   }
+}
+
+SHMNetAPI::Ring *SHMNetAPI::getRing( unsigned int src, unsigned int dst ) const
+{
+   return ( Ring * ) ( _rings + ( src * _numNodes + dst ) * _ringStride );
+}
+
+char *SHMNetAPI::getSegment( unsigned int node ) const
+{
+   return _segments + node * _segmentSize;
+}
+
+void SHMNetAPI::sendMessage( unsigned int dest, MessageType type, uint64_t const *args, unsigned int numArgs, void const *payload, std::size_t payloadLen )
+{
+   std::size_t msgLen = alignMessage( sizeof( MessageHeader ) + payloadLen );
+   ensure( msgLen <= _ringSize, "Message does not fit in a shared memory ring." );
+   ensure( numArgs <= MAX_MESSAGE_ARGS, "Too many message arguments." );
+
+   Ring *ring = getRing( _nodeNum, dest );
+   char *data = ( char * ) ( ring + 1 );
+   Lock &lock = *_sendLocks[ dest ];
+
+   lock.acquire();
+   for (;;) {
+      std::size_t head = ring->_head;
+      std::size_t offset = head & ( _ringSize - 1 );
+      // messages are never split, the end of the ring is skipped if the message does not fit there
+      std::size_t padding = ( _ringSize - offset < msgLen ) ? _ringSize - offset : 0;
+      if ( head + padding + msgLen - ring->_tail <= _ringSize ) {
+         if ( padding >= sizeof( MessageHeader ) ) {
+            ( ( MessageHeader * ) &data[ offset ] )->_type = MSG_PAD;
+         }
+         offset = ( head + padding ) & ( _ringSize - 1 );
+         MessageHeader *hdr = ( MessageHeader * ) &data[ offset ];
+         hdr->_type = type;
+         hdr->_payloadLen = ( uint32_t ) payloadLen;
+         for ( unsigned int idx = 0; idx < numArgs; idx += 1 ) {
+            hdr->_args[ idx ] = args[ idx ];
+         }
+         if ( payloadLen > 0 ) {
+            ::memcpy( hdr + 1, payload, payloadLen );
+         }
+         memoryFence();
+         ring->_head = head + padding + msgLen;
+         break;
+      }
+      // The ring is full: let other threads use it and keep our incoming rings
+      // moving, the destination may be waiting for room to send to this node
+      lock.release();
+      processIncoming();
+      sched_yield();
+      lock.acquire();
+   }
+   lock.release();
+}
+
+bool SHMNetAPI::processRing( unsigned int src )
+{
+   Ring *ring = getRing( src, _nodeNum );
+   if ( ring->_tail == ring->_head ) return false;
+   if ( !_recvLocks[ src ]->tryAcquire() ) return false;
+
+   char *data = ( char * ) ( ring + 1 );
+   char *buffer = _recvBuffers[ src ];
+   bool handled = false;
+   std::size_t tail = ring->_tail;
+   while ( tail != ring->_head ) {
+      memoryFence();
+      std::size_t offset = tail & ( _ringSize - 1 );
+      std::size_t remaining = _ringSize - offset;
+      MessageHeader *hdr = ( MessageHeader * ) &data[ offset ];
+      if ( remaining < sizeof( MessageHeader ) || hdr->_type == MSG_PAD ) {
+         tail += remaining;
+         continue;
+      }
+      // Copy the message out so the producer can reuse its space while it is handled
+      std::size_t len = sizeof( MessageHeader ) + hdr->_payloadLen;
+      ::memcpy( buffer, hdr, len );
+      tail += alignMessage( len );
+      memoryFence();
+      ring->_tail = tail;
+
+      MessageHeader *msg = ( MessageHeader * ) buffer;
+      handleMessage( src, *msg, buffer + sizeof( MessageHeader ) );
+      handled = true;
+   }
+   ring->_tail = tail;
+   _recvLocks[ src ]->release();
+   return handled;
+}
+
+void SHMNetAPI::processIncoming()
+{
+   for ( unsigned int src = 0; src < _numNodes; src += 1 ) {
+      processRing( src );
+   }
+}
+
+void SHMNetAPI::handleMessage( unsigned int src, MessageHeader const &msg, char *payload )
+{
+   DisableAM c;
+   uint64_t const *args = msg._args;
+
+   switch ( msg._type ) {
+      case MSG_FINALIZE:
+         sys.stopFirstThread();
+         break;
+      case MSG_WORK:
+         amWork( src, args, payload, msg._payloadLen );
+         break;
+      case MSG_WORK_DONE:
+         amWorkDone( src, args );
+         break;
+      case MSG_MALLOC:
+         amMalloc( src, args );
+         break;
+      case MSG_MALLOC_REPLY:
+         sys.getNetwork()->notifyMalloc( src, ( void * ) args[0], ( Network::mallocWaitObj * ) args[1] );
+         break;
+      case MSG_FREE:
+         free( ( void * ) args[0] );
+         break;
+      case MSG_REALLOC:
+         std::memcpy( ( void * ) args[2], ( void * ) args[0], ( std::size_t ) args[1] );
+         break;
+      case MSG_MASTER_HOSTNAME:
+         /* for now we only allow this at node 0 */
+         if ( src == 0 ) {
+            sys.getNetwork()->setMasterHostname( payload );
+         }
+         break;
+      case MSG_PUT:
+         amPut( src, args );
+         break;
+      case MSG_PUT_STRIDED_1D:
+         amPutStrided1D( src, args );
+         break;
+      case MSG_GET:
+      case MSG_GET_STRIDED_1D:
+         amGet( src, payload );
+         break;
+      case MSG_GET_REPLY:
+         if ( args[0] != 0 ) {
+            ( ( GetRequest * ) args[0] )->complete();
+         }
+         break;
+      case MSG_REQUEST_PUT:
+      case MSG_REQUEST_PUT_STRIDED_1D:
+         _net->notifyRequestPut( NEW SendDataPutRequest( this, ( SendDataPutRequestPayload * ) payload ) );
+         break;
+      case MSG_WAIT_REQUEST_PUT:
+         _net->notifyWaitRequestPut( ( void * ) args[0], ( unsigned int ) args[1], ( unsigned int ) args[2] );
+         break;
+      case MSG_FREE_TMP_BUFFER:
+         amFreeTmpBuffer( src, args );
+         break;
+      case MSG_REGION_METADATA:
+         {
+            CopyData *cd = ( CopyData * ) payload;
+            cd->setDimensions( ( nanos_region_dimension_internal_t * ) ( payload + sizeof( CopyData ) ) );
+            _net->notifyRegionMetaData( cd, ( unsigned int ) args[0] );
+         }
+         break;
+      case MSG_SYNCHRONIZE_DIRECTORY:
+         amSynchronizeDirectory( src, args );
+         break;
+      case MSG_IDLE:
+         _net->notifyIdle( src );
+         break;
+      case MSG_FRAME:
+         _net->notifyAggregatedMessages( src, payload, msg._payloadLen );
+         break;
+      default:
+         fatal0( "Unknown message type " << msg._type << " received from node " << src );
+   }
+}
+
+void SHMNetAPI::amWork( unsigned int src, uint64_t const *args, char *payload, std::size_t len )
+{
+   Net2WD nwd( payload, len, _rwgs[src], src, ( std::size_t ) args[1], ( unsigned int ) args[2], _wdTemplates );
+   for ( unsigned int i = 0; i < nwd.getNumWDs(); i += 1 ) {
+      Net2WD::ReceivedWork const &work = nwd.getWork( i );
+      _net->notifyWork( work._expectedData, work._wd, work._seq );
+   }
+}
+
+void SHMNetAPI::amWorkDone( unsigned int src, uint64_t const *args )
+{
+   sys.getNetwork()->notifyWorkDone( src, ( void * ) args[0], 0 );
+}
+
+void SHMNetAPI::amMalloc( unsigned int src, uint64_t const *args )
+{
+   void *addr = NULL;
+   std::size_t size = ( std::size_t ) args[0];
+
+   if ( _unalignedNodeMemory ) {
+      addr = (void *) NEW char[ size ];
+   } else {
+      OSAllocator a;
+      addr = a.allocate( size );
+   }
+   if ( addr == NULL )
+   {
+      message0 ( "I could not allocate " << size << " bytes of memory on node " << _nodeNum << ". Try setting NX_CLUSTER_NODE_MEMORY to a lower value." );
+      fatal0 ("I can not continue." );
+   }
+   uint64_t reply[] = { ( uintptr_t ) addr, args[1] };
+   sendMessage( src, MSG_MALLOC_REPLY, reply, 2 );
+}
+
+void SHMNetAPI::amPut( unsigned int src, uint64_t const *args )
+{
+   void *realAddr = ( void * ) args[0];
+   void *tmpBuffer = ( void * ) args[1];
+   std::size_t size = ( std::size_t ) args[2];
+
+   _rxBytes += size;
+   if ( realAddr != NULL ) {
+      ::memcpy( realAddr, tmpBuffer, size );
+   }
+   enqueueFreeBufferNotify( ( unsigned int ) args[8], tmpBuffer, ( WD const * ) args[4] );
+   _net->notifyPut( src, ( unsigned int ) args[3], size, 1, 0, ( uint64_t ) realAddr, ( void * ) args[6], ( reg_t ) args[7], ( unsigned int ) args[5] );
+}
+
+void SHMNetAPI::amPutStrided1D( unsigned int src, uint64_t const *args )
+{
+   void *realTag = ( void * ) args[0];
+   void *tmpBuffer = ( void * ) args[1];
+   std::size_t size = ( std::size_t ) args[2];
+   std::size_t count = ( std::size_t ) args[3];
+   std::size_t ld = ( std::size_t ) args[4];
+
+   _rxBytes += size * count;
+   Packer::unpack( ( char * ) realTag, ( char * ) tmpBuffer, size, count, ld );
+   enqueueFreeBufferNotify( ( unsigned int ) args[10], tmpBuffer, ( WD const * ) args[6] );
+   _net->notifyPut( src, ( unsigned int ) args[5], size, count, ld, ( uint64_t ) realTag, ( void * ) args[8], ( reg_t ) args[9], ( unsigned int ) args[7] );
+}
+
+void SHMNetAPI::amGet( unsigned int src, char *payload )
+{
+   SendDataGetRequestPayload *msg = ( SendDataGetRequestPayload * ) payload;
+   nanos_region_dimension_internal_t *dims = ( nanos_region_dimension_internal_t * ) ( payload + sizeof( SendDataGetRequestPayload ) );
+
+   _txBytes += msg->_len * msg->_count;
+
+   SendDataGetRequest *req = NEW SendDataGetRequest( this, msg->_seqNumber, src, msg->_destAddr, msg->_origAddr, msg->_len, msg->_count, msg->_ld, msg->_req, msg->_cd, dims );
+   _net->notifyRegionMetaData( &( req->_cd ), 0 );
+   _net->notifyGet( req );
+}
+
+void SHMNetAPI::amFreeTmpBuffer( unsigned int src, uint64_t const *args )
+{
+   void *addr = ( void * ) args[0];
+   _pinnedAllocatorsLocks[ src ]->acquire();
+   _pinnedAllocators[ src ]->free( addr );
+   _pinnedAllocatorsLocks[ src ]->release();
+}
+
+void SHMNetAPI::amSynchronizeDirectory( unsigned int src, uint64_t const *args )
+{
+   WorkDescriptor *wds[4];
+   unsigned int numWDs = 0;
+
+   wds[numWDs] = _rwgs[src][0];
+   numWDs += 1;
+
+#ifdef GPU_DEV
+   wds[numWDs] = _rwgs[src][1];
+   numWDs += 1;
+#endif
+#ifdef OpenCL_DEV
+   wds[numWDs] = _rwgs[src][2];
+   numWDs += 1;
+#endif
+#ifdef FPGA_DEV
+   wds[numWDs] = _rwgs[src][3];
+   numWDs += 1;
+#endif
+   _net->notifySynchronizeDirectory( numWDs, wds, ( void * ) args[0] );
+}
+
+void SHMNetAPI::spawnNodes()
+{
+   // Buffered output would be written once by every node
+   fflush( NULL );
+   for ( unsigned int node = 1; node < _numNodes; node += 1 ) {
+      pid_t pid = fork();
+      if ( pid < 0 ) {
+         fatal0( "Could not create cluster node " << node << ": " << strerror( errno ) );
+      } else if ( pid == 0 ) {
+         _nodeNum = node;
+         _children.clear();
+#ifdef PR_SET_PDEATHSIG
+         // Do not outlive node 0
+         prctl( PR_SET_PDEATHSIG, SIGKILL );
+#endif
+         return;
+      }
+      _children.push_back( pid );
+   }
+}
+
+bool SHMNetAPI::checkChildren()
+{
+   bool exited = false;
+   for ( unsigned int idx = 0; idx < _children.size(); idx += 1 ) {
+      int status;
+      if ( _children[idx] > 0 && waitpid( _children[idx], &status, WNOHANG ) == _children[idx] ) {
+         _children[idx] = 0;
+         exited = true;
+      }
+   }
+   return exited;
+}
+
+void SHMNetAPI::initialize ( Network *net )
+{
+   _net = net;
+
+   if ( _numNodes == 0 ) _numNodes = 1;
+
+   std::size_t ringSize = MIN_RING_SIZE;
+   while ( ringSize < _ringSize ) ringSize <<= 1;
+   _ringSize = ringSize;
+   _ringStride = sizeof( Ring ) + _ringSize;
+
+   std::size_t pageSize = ( std::size_t ) sysconf( _SC_PAGESIZE );
+   _segmentSize = ( _segmentSize + pageSize - 1 ) & ~( pageSize - 1 );
+   std::size_t segmentsOffset = sizeof( SharedHeader ) + _numNodes * _numNodes * _ringStride;
+   segmentsOffset = ( segmentsOffset + pageSize - 1 ) & ~( pageSize - 1 );
+   _mappingSize = segmentsOffset + _numNodes * _segmentSize;
+
+   // Pages are only backed once they are touched
+   _mapping = ( char * ) mmap( NULL, _mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+   if ( _mapping == MAP_FAILED ) {
+      fatal0( "Could not map " << _mappingSize << " bytes of shared memory for " << _numNodes << " cluster nodes: " << strerror( errno )
+            << ". Try setting NX_CLUSTER_SHM_SEGMENT_SIZE to a lower value." );
+   }
+   _shared = new ( _mapping ) SharedHeader();
+   _rings = _mapping + sizeof( SharedHeader );
+   _segments = _mapping + segmentsOffset;
+
+   _seqN = NEW Atomic<unsigned int>[ _numNodes ];
+   _sendLocks.reserve( _numNodes );
+   _recvLocks.reserve( _numNodes );
+   _recvBuffers.reserve( _numNodes );
+   _pinnedAllocators.reserve( _numNodes );
+   _pinnedAllocatorsLocks.reserve( _numNodes );
+   for ( unsigned int idx = 0; idx < _numNodes; idx += 1 ) {
+      new ( &_seqN[idx] ) Atomic<unsigned int >( 0 );
+      _sendLocks.push_back( NEW Lock() );
+      _recvLocks.push_back( NEW Lock() );
+      _recvBuffers.push_back( NEW char[ _ringSize ] );
+      // The first half of each segment holds the temporary buffers of the data sent to that node
+      _pinnedAllocators.push_back( NEW SimpleAllocator( ( uintptr_t ) getSegment( idx ), _segmentSize / 2 ) );
+      _pinnedAllocatorsLocks.push_back( NEW Lock() );
+   }
+   _thisNodeSegment = _pinnedAllocators[0];
+
+   spawnNodes();
+
+   _net->setNumNodes( _numNodes );
+   _net->setNodeNum( _nodeNum );
+
+   nodeBarrier();
+
+   {
+      char myHostname[256];
+      if ( gethostname( myHostname, 256 ) != 0 )
+      {
+         fprintf(stderr, "os: Error getting the hostname.\n");
+      }
+
+      if ( _nodeNum == 0 )
+      {
+         sys.getNetwork()->setMasterHostname( (char *) myHostname );
+
+         for ( unsigned int i = 1; i < _numNodes; i++ )
+         {
+            sendMyHostName( i );
+         }
+      }
+   }
+
+   nodeBarrier();
+
+   // The second half of our own segment is used to pack strided data
+   _packSegment = NEW SimpleAllocator( ( uintptr_t ) getSegment( _nodeNum ) + _segmentSize / 2, _segmentSize / 2 );
+}
+
+void SHMNetAPI::finalize ()
+{
+   nodeBarrier();
+   for ( unsigned int i = 0; i < _numNodes; i += 1 )
+   {
+      nodeBarrier();
+   }
+   if ( _nodeNum != 0 ) {
+      fflush( NULL );
+      _exit( 0 );
+   }
+   for ( unsigned int idx = 0; idx < _children.size(); idx += 1 ) {
+      if ( _children[idx] > 0 ) {
+         int status;
+         waitpid( _children[idx], &status, 0 );
+      }
+   }
+}
+
+void SHMNetAPI::finalizeNoBarrier ()
+{
+   fflush( NULL );
+   for ( unsigned int idx = 0; idx < _children.size(); idx += 1 ) {
+      if ( _children[idx] > 0 ) {
+         kill( _children[idx], SIGKILL );
+      }
+   }
+   _exit( 0 );
+}
+
+void SHMNetAPI::poll ()
+{
+   if (myThread != NULL && myThread->_gasnetAllowAM)
+   {
+      processIncoming();
+      checkForPutReqs();
+      checkForFreeBufferReqs();
+      checkWorkDoneReqs();
+   } else if ( myThread == NULL ) {
+      processIncoming();
+   }
+   // Nodes only leave after the last barrier of finalize, any earlier exit is a crash
+   if ( !_children.empty() && ( ++_pollCount & 0xfff ) == 0 && checkChildren() ) {
+      fatal0( "A cluster node exited unexpectedly." );
+   }
+}
+
+void SHMNetAPI::sendExitMsg ( unsigned int dest )
+{
+   sendMessage( dest, MSG_FINALIZE, NULL, 0 );
+}
+
+void SHMNetAPI::sendWorkMsg ( unsigned int dest, WorkDescriptor const &wd, std::size_t expectedData )
+{
+   WD2Net nwd( wd, dest, _wdTemplates );
+
+   if ( alignMessage( sizeof( MessageHeader ) + nwd.getBufferSize() ) > _ringSize ) {
+      fatal0( "Work descriptor " << wd.getId() << " needs " << nwd.getBufferSize() << " bytes to be sent to node " << dest
+            << ", more than a message ring can hold. Try setting NX_CLUSTER_SHM_RING_SIZE to a higher value." );
+   }
+
+   uint64_t args[] = { ( uint64_t ) wd.getId(), expectedData, _seqN[dest]++ };
+   if ( !_net->aggregateMessage( dest, AGGREGATED_WORK, args, sizeof( args ), nwd.getBuffer(), nwd.getBufferSize() ) ) {
+      sendMessage( dest, MSG_WORK, args, 3, nwd.getBuffer(), nwd.getBufferSize() );
+   }
+}
+
+void SHMNetAPI::sendWorkDoneMsg ( unsigned int dest, void const *remoteWdAddr )
+{
+   std::pair<void const *, unsigned int> *rwd = NEW std::pair<void const *, unsigned int> ( remoteWdAddr, dest );
+   _workDoneReqs.add( rwd );
+}
+
+void SHMNetAPI::_sendWorkDoneMsg ( unsigned int dest, void const *remoteWdAddr )
+{
+   uint64_t args[] = { ( uintptr_t ) remoteWdAddr };
+   sendMessage( dest, MSG_WORK_DONE, args, 1 );
+}
+
+void *SHMNetAPI::allocateTmpBuffer( unsigned int node, std::size_t len )
+{
+   if ( len > _segmentSize / 2 ) {
+      fatal0( "Can not send " << len << " bytes to node " << node << " at once. Try setting NX_CLUSTER_SHM_SEGMENT_SIZE to a higher value." );
+   }
+   void *tmp = NULL;
+   while ( tmp == NULL ) {
+      _pinnedAllocatorsLocks[ node ]->acquire();
+      tmp = _pinnedAllocators[ node ]->allocate( len );
+      _pinnedAllocatorsLocks[ node ]->release();
+      if ( tmp == NULL ) _net->poll(0);
+   }
+   return tmp;
+}
+
+void SHMNetAPI::_put ( unsigned int issueNode, unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, std::size_t size, void *remoteTmpBuffer, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq )
+{
+   _txBytes += size;
+   _totalBytes += size;
+   ::memcpy( remoteTmpBuffer, localAddr, size );
+   uint64_t args[] = { remoteAddr, ( uintptr_t ) remoteTmpBuffer, size, wdId, ( uintptr_t ) wd, metaSeq,
+      ( uintptr_t ) hostObject, hostRegId, issueNode };
+   sendMessage( remoteNode, MSG_PUT, args, 9 );
+}
+
+void SHMNetAPI::_putStrided1D ( unsigned int issueNode, unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, std::size_t size, std::size_t count, std::size_t ld, void *remoteTmpBuffer, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq )
+{
+   _txBytes += size * count;
+   _totalBytes += size * count;
+   Packer::pack( ( char * ) remoteTmpBuffer, ( char * ) localAddr, size, count, ld );
+   uint64_t args[] = { remoteAddr, ( uintptr_t ) remoteTmpBuffer, size, count, ld, wdId, ( uintptr_t ) wd, metaSeq,
+      ( uintptr_t ) hostObject, hostRegId, issueNode };
+   sendMessage( remoteNode, MSG_PUT_STRIDED_1D, args, 11 );
+}
+
+void SHMNetAPI::put ( unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, std::size_t size, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq )
+{
+   void *tmp = allocateTmpBuffer( remoteNode, size );
+   _put( _nodeNum, remoteNode, remoteAddr, localAddr, size, tmp, wdId, wd, hostObject, hostRegId, metaSeq );
+}
+
+void SHMNetAPI::putStrided1D ( unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, void *localPack, std::size_t size, std::size_t count, std::size_t ld, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq )
+{
+   void *tmp = allocateTmpBuffer( remoteNode, size * count );
+   _putStrided1D( _nodeNum, remoteNode, remoteAddr, localAddr, size, count, ld, tmp, wdId, wd, hostObject, hostRegId, metaSeq );
+}
+
+void SHMNetAPI::get ( void *localAddr, unsigned int remoteNode, uint64_t remoteAddr, std::size_t size, GetRequest *req, CopyData const &cd )
+{
+   unsigned int seq_number = sys.getNetwork()->getPutRequestSequenceNumber( remoteNode );
+   std::size_t buffer_size = sizeof( SendDataGetRequestPayload ) + sizeof( nanos_region_dimension_internal_t ) * cd.getNumDimensions();
+   char *buffer = (char *) alloca( buffer_size );
+   new ( buffer ) SendDataGetRequestPayload( seq_number, localAddr, (void *)remoteAddr, size, 1, 0, req, cd );
+   nanos_region_dimension_internal_t *dims = ( nanos_region_dimension_internal_t * ) ( buffer + sizeof( SendDataGetRequestPayload ) );
+   ::memcpy( dims, cd.getDimensions(), sizeof( nanos_region_dimension_internal_t ) * cd.getNumDimensions() );
+
+   sendMessage( remoteNode, MSG_GET, NULL, 0, buffer, buffer_size );
+
+   _rxBytes += size;
+   _totalBytes += size;
+}
+
+std::size_t SHMNetAPI::getMaxGetStridedLen() const {
+   // data is packed directly in the receive buffer, keep it well below the pack segment size
+   return _segmentSize / 8;
+}
+
+void SHMNetAPI::getStrided1D ( void *packedAddr, unsigned int remoteNode, uint64_t remoteTag, uint64_t remoteAddr, std::size_t size, std::size_t count, std::size_t ld, GetRequestStrided *req, CopyData const &cd )
+{
+   unsigned int seq_number = sys.getNetwork()->getPutRequestSequenceNumber( remoteNode );
+   std::size_t buffer_size = sizeof( SendDataGetRequestPayload ) + sizeof( nanos_region_dimension_internal_t ) * cd.getNumDimensions();
+   char *buffer = (char *) alloca( buffer_size );
+   new ( buffer ) SendDataGetRequestPayload( seq_number, packedAddr, (void *)remoteAddr, size, count, ld, req, cd );
+   nanos_region_dimension_internal_t *dims = ( nanos_region_dimension_internal_t * ) ( buffer + sizeof( SendDataGetRequestPayload ) );
+   ::memcpy( dims, cd.getDimensions(), sizeof( nanos_region_dimension_internal_t ) * cd.getNumDimensions() );
+
+   sendMessage( remoteNode, MSG_GET_STRIDED_1D, NULL, 0, buffer, buffer_size );
+
+   _rxBytes += size * count;
+   _totalBytes += size * count;
+}
+
+void SHMNetAPI::malloc ( unsigned int remoteNode, std::size_t size, void * waitObjAddr )
+{
+   uint64_t args[] = { size, ( uintptr_t ) waitObjAddr };
+   sendMessage( remoteNode, MSG_MALLOC, args, 2 );
+}
+
+void SHMNetAPI::memRealloc ( unsigned int remoteNode, void *oldAddr, std::size_t oldSize, void *newAddr, std::size_t newSize )
+{
+   uint64_t args[] = { ( uintptr_t ) oldAddr, oldSize, ( uintptr_t ) newAddr, newSize };
+   sendMessage( remoteNode, MSG_REALLOC, args, 4 );
+}
+
+void SHMNetAPI::memFree ( unsigned int remoteNode, void *addr )
+{
+   uint64_t args[] = { ( uintptr_t ) addr };
+   sendMessage( remoteNode, MSG_FREE, args, 1 );
+}
+
+void SHMNetAPI::nodeBarrier()
+{
+   unsigned int generation = _shared->_barrierGeneration;
+   memoryFence();
+   if ( ++( _shared->_barrierCount ) == _numNodes ) {
+      _shared->_barrierCount = 0;
+      memoryFence();
+      _shared->_barrierGeneration = generation + 1;
+   } else {
+      unsigned int spins = 0;
+      while ( _shared->_barrierGeneration == generation ) {
+         processIncoming();
+         spins += 1;
+         // A node that is gone would never arrive, it can only leave once the barrier is done
+         if ( ( spins & 0x3ff ) == 0 && checkChildren() && _shared->_barrierGeneration == generation ) {
+            fatal0( "A cluster node exited before reaching a barrier." );
+         }
+         sched_yield();
+      }
+   }
+}
+
+void SHMNetAPI::sendMyHostName( unsigned int dest )
+{
+   const char *masterHostname = sys.getNetwork()->getMasterHostname();
+
+   if ( masterHostname == NULL )
+      fprintf(stderr, "Error, master hostname not set!\n" );
+
+   sendMessage( dest, MSG_MASTER_HOSTNAME, NULL, 0, masterHostname, ::strlen( masterHostname ) + 1 ); //+1 to add the last \0 character
+}
+
+void SHMNetAPI::sendRequestPut( unsigned int dest, uint64_t origAddr, unsigned int dataDest, uint64_t dstAddr, std::size_t len, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq )
+{
+   _totalBytes += len;
+   sendWaitForRequestPut( dataDest, dstAddr, wd->getHostId() );
+
+   unsigned int seq_number = sys.getNetwork()->getPutRequestSequenceNumber( dest );
+   void *tmpBuffer = allocateTmpBuffer( dataDest, len );
+
+   SendDataPutRequestPayload msg( _nodeNum, seq_number, (void *) origAddr, (void*) dstAddr, len, 1, 0, dataDest, wdId, tmpBuffer, wd, hostObject, hostRegId, metaSeq );
+   sendMessage( dest, MSG_REQUEST_PUT, NULL, 0, &msg, sizeof( msg ) );
+}
+
+void SHMNetAPI::sendRequestPutStrided1D( unsigned int dest, uint64_t origAddr, unsigned int dataDest, uint64_t dstAddr, std::size_t len, std::size_t count, std::size_t ld, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq )
+{
+   _totalBytes += ( len * count );
+   sendWaitForRequestPut( dataDest, dstAddr, wd->getHostId() );
+
+   unsigned int seq_number = sys.getNetwork()->getPutRequestSequenceNumber( dest );
+   void *tmpBuffer = allocateTmpBuffer( dataDest, len * count );
+
+   SendDataPutRequestPayload msg( _nodeNum, seq_number, (void *) origAddr, (void *) dstAddr, len, count, ld, dataDest, wdId, tmpBuffer, wd, hostObject, hostRegId, metaSeq );
+   sendMessage( dest, MSG_REQUEST_PUT_STRIDED_1D, NULL, 0, &msg, sizeof( msg ) );
+}
+
+void SHMNetAPI::sendWaitForRequestPut( unsigned int dest, uint64_t addr, unsigned int wdId )
+{
+   unsigned int seq_number = sys.getNetwork()->getPutRequestSequenceNumber( dest );
+   uint64_t args[] = { addr, wdId, seq_number };
+   sendMessage( dest, MSG_WAIT_REQUEST_PUT, args, 3 );
+}
+
+void SHMNetAPI::sendFreeTmpBuffer( unsigned int dest, void *addr, WD const *wd )
+{
+   uint64_t args[] = { ( uintptr_t ) addr, ( uintptr_t ) wd };
+   sendMessage( dest, MSG_FREE_TMP_BUFFER, args, 2 );
+}
+
+void SHMNetAPI::sendRegionMetadata( unsigned int dest, CopyData *cd, unsigned int seq ) {
+   std::size_t data_size = sizeof(CopyData) + cd->getNumDimensions() * sizeof(nanos_region_dimension_internal_t);
+   char *buffer = (char *) alloca(data_size);
+
+   ::memcpy(buffer, cd, sizeof(CopyData) );
+   ::memcpy(buffer + sizeof(CopyData), cd->getDimensions(), cd->getNumDimensions() * sizeof(nanos_region_dimension_internal_t));
+
+   uint64_t args[] = { seq };
+   sendMessage( dest, MSG_REGION_METADATA, args, 1, buffer, data_size );
+}
+
+void SHMNetAPI::synchronizeDirectory( unsigned int dest, void *addr ) {
+   uint64_t args[] = { ( uintptr_t ) addr };
+   sendMessage( dest, MSG_SYNCHRONIZE_DIRECTORY, args, 1 );
+}
+
+void SHMNetAPI::broadcastIdle() {
+   for ( unsigned int node = 0; node < _numNodes; node += 1 )
+   {
+      if ( node != _nodeNum )
+      {
+         sendMessage( node, MSG_IDLE, NULL, 0 );
+      }
+   }
+}
+
+std::size_t SHMNetAPI::getMaxFrameSize() const {
+   // leave room in the ring for the other messages
+   return _ringSize / 4;
+}
+
+void SHMNetAPI::sendFrame( unsigned int dest, char const *frame, std::size_t len ) {
+   sendMessage( dest, MSG_FRAME, NULL, 0, frame, len );
+}
+
+void SHMNetAPI::processAggregatedMessage( unsigned int src, unsigned int type, char *data, std::size_t len ) {
+   switch ( type ) {
+      case AGGREGATED_WORK:
+         amWork( src, ( uint64_t const * ) data, data + 3 * sizeof( uint64_t ), len - 3 * sizeof( uint64_t ) );
+         break;
+      default:
+         fatal0( "Unknown aggregated message type " << type << " received from node " << src );
+   }
+}
+
+std::size_t SHMNetAPI::getRxBytes()
+{
+   return _rxBytes;
+}
+
+std::size_t SHMNetAPI::getTxBytes()
+{
+   return _txBytes;
+}
+
+std::size_t SHMNetAPI::getTotalBytes()
+{
+   return _totalBytes;
+}
+
+SimpleAllocator *SHMNetAPI::getPackSegment() const {
+   return _packSegment;
+}
+
+void *SHMNetAPI::allocateReceiveMemory( std::size_t len ) {
+   void *addr = NULL;
+   do {
+      _thisNodeSegmentLock.acquire();
+      addr = _thisNodeSegment->allocate( len );
+      _thisNodeSegmentLock.release();
+      if ( addr == NULL ) myThread->processTransfers();
+   } while (addr == NULL);
+   return addr;
+}
+
+void SHMNetAPI::freeReceiveMemory( void * addr ) {
+   _thisNodeSegmentLock.acquire();
+   _thisNodeSegment->free( addr );
+   _thisNodeSegmentLock.release();
+}
+
+unsigned int SHMNetAPI::getNumNodes() const {
+   return _numNodes;
+}
+
+unsigned int SHMNetAPI::getNodeNum() const {
+   return _nodeNum;
+}
+
+void SHMNetAPI::setNumNodes( unsigned int numNodes ) {
+   _numNodes = numNodes;
+}
+
+void SHMNetAPI::setSegmentSize( std::size_t segmentSize ) {
+   if ( segmentSize > 0 ) _segmentSize = segmentSize;
+}
+
+void SHMNetAPI::setRingSize( std::size_t ringSize ) {
+   if ( ringSize > 0 ) _ringSize = ringSize;
+}
+
+void SHMNetAPI::setUnalignedNodeMemory( bool flag ) {
+   _unalignedNodeMemory = flag;
+}
@@ -0,0 +1,321 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+
+#ifndef _SHMNETAPI_DECL
+#define _SHMNETAPI_DECL
+
+#include "basethread_decl.hpp"
+#include "networkapi.hpp"
+#include "network_decl.hpp"
+#include "simpleallocator_decl.hpp"
+#include "allocator_decl.hpp"
+#include "requestqueue_decl.hpp"
+#include "remoteworkdescriptor_decl.hpp"
+#include "netwd_decl.hpp"
+#include "atomic_decl.hpp"
+#include "lock_decl.hpp"
+#include <vector>
+#include <sys/types.h>
+
+namespace nanos {
+namespace ext {
+
+   /*! \brief Network API that runs all the cluster nodes as processes of a single host
+    *
+    *  Node 0 forks the other nodes while the network is initialized, before any other
+    *  thread has been created. All the nodes share one anonymous mapping holding a
+    *  barrier, a single-producer single-consumer message ring for every pair of nodes
+    *  and one data segment per node. The whole address space is inherited, so segment
+    *  addresses, work descriptor addresses and outlined function pointers are valid in
+    *  every node. Data is copied directly between the segments and the rings only carry
+    *  the control messages that GASNet would carry in its active messages.
+    */
+   class SHMNetAPI : public NetworkAPI
+   {
+      private:
+         static SHMNetAPI *_instance;
+         static SHMNetAPI *getInstance();
+
+         //! \brief Handlers can run nested (while a send waits for ring space), restore the previous state
+         class DisableAM {
+            bool _allowed;
+            public:
+            DisableAM() : _allowed( true ) {
+               if ( myThread != NULL ) {
+                  _allowed = myThread->_gasnetAllowAM;
+                  myThread->_gasnetAllowAM = false;
+               }
+            }
+            ~DisableAM() {
+               if ( myThread != NULL ) {
+                  myThread->_gasnetAllowAM = _allowed;
+               }
+            }
+         };
+
+         enum MessageType {
+            MSG_PAD = 0,
+            MSG_FINALIZE,
+            MSG_WORK,
+            MSG_WORK_DONE,
+            MSG_MALLOC,
+            MSG_MALLOC_REPLY,
+            MSG_FREE,
+            MSG_REALLOC,
+            MSG_MASTER_HOSTNAME,
+            MSG_PUT,
+            MSG_PUT_STRIDED_1D,
+            MSG_GET,
+            MSG_GET_STRIDED_1D,
+            MSG_GET_REPLY,
+            MSG_REQUEST_PUT,
+            MSG_REQUEST_PUT_STRIDED_1D,
+            MSG_WAIT_REQUEST_PUT,
+            MSG_FREE_TMP_BUFFER,
+            MSG_REGION_METADATA,
+            MSG_SYNCHRONIZE_DIRECTORY,
+            MSG_IDLE,
+            MSG_FRAME
+         };
+
+         //! \brief Work messages carried in aggregated frames
+         static const unsigned int AGGREGATED_WORK = Network::AGGREGATED_API_MESSAGE;
+
+         static const unsigned int MAX_MESSAGE_ARGS = 12;
+
+         //! \brief Header of every message written in a ring, the payload follows it
+         struct MessageHeader {
+            uint32_t _type;
+            uint32_t _payloadLen;
+            uint64_t _args[ MAX_MESSAGE_ARGS ];
+         };
+
+         /*! \brief Descriptor of a ring, its data area follows it
+          *
+          *  _head and _tail are ever-increasing byte counters, written only by the
+          *  producer and the consumer respectively, in different cache lines.
+          */
+         struct Ring {
+            volatile std::size_t _head;
+            char                 _pad0[ NANOS_CACHELINE - sizeof( std::size_t ) ];
+            volatile std::size_t _tail;
+            char                 _pad1[ NANOS_CACHELINE - sizeof( std::size_t ) ];
+         };
+
+         //! \brief Sense reversing barrier shared by all the nodes
+         struct SharedHeader {
+            Atomic<unsigned int>  _barrierCount;
+            volatile unsigned int _barrierGeneration;
+            char                  _pad[ NANOS_CACHELINE - sizeof( Atomic<unsigned int> ) - sizeof( unsigned int ) ];
+         };
+
+         class SHMSendDataRequest : public SendDataRequest {
+            protected:
+            SHMNetAPI *_shmApi;
+            public:
+            SHMSendDataRequest( SHMNetAPI *api, unsigned int issueNode, unsigned int seqNumber, void *origAddr,
+                  void *destAddr, std::size_t len, std::size_t count, std::size_t ld, unsigned int dst, unsigned int wdId,
+                  void *hostObject, reg_t hostRegId, unsigned int metaSeq );
+         };
+
+         struct SendDataPutRequestPayload {
+            unsigned int  _issueNode;
+            unsigned int  _seqNumber;
+            void         *_origAddr;
+            void         *_destAddr;
+            std::size_t   _len;
+            std::size_t   _count;
+            std::size_t   _ld;
+            unsigned int  _destination;
+            unsigned int  _wdId;
+
+            void         *_tmpBuffer;
+            WD const     *_wd;
+            void         *_hostObject;
+            reg_t         _hostRegId;
+            unsigned int  _metaSeq;
+
+            SendDataPutRequestPayload ( unsigned int issueNode, unsigned int seqNumber,
+                  void *origAddr, void *dstAddr, std::size_t len, std::size_t count,
+                  std::size_t ld, unsigned int dest, unsigned int wdId, void *tmpBuffer,
+                  WD const *wd, void *hostObject, reg_t hostRegId, unsigned int _metaSeq );
+         };
+
+         struct SendDataGetRequestPayload {
+            unsigned int  _seqNumber;
+            void         *_origAddr;
+            void         *_destAddr;
+            std::size_t   _len;
+            std::size_t   _count;
+            std::size_t   _ld;
+            GetRequest   *_req;
+            CopyData      _cd;
+
+            SendDataGetRequestPayload ( unsigned int seqNumber, void *origAddr, void *dstAddr, std::size_t len, std::size_t count,
+               std::size_t ld, GetRequest *req, CopyData const &cd );
+         };
+
+         class SendDataPutRequest : public SHMSendDataRequest {
+            void *_tmpBuffer;
+            WD const *_wd;
+            public:
+            SendDataPutRequest( SHMNetAPI *api, SendDataPutRequestPayload *msg );
+            virtual ~SendDataPutRequest();
+            virtual void doSingleChunk();
+            virtual void doStrided( void *localAddr );
+         };
+
+         class SendDataGetRequest : public SHMSendDataRequest {
+            GetRequest *_req;
+            public:
+            CopyData _cd;
+            SendDataGetRequest( SHMNetAPI *api, unsigned int seqNumber, unsigned int dest, void *origAddr, void *destAddr, std::size_t len,
+            std::size_t count, std::size_t ld, GetRequest *req, CopyData const &cd, nanos_region_dimension_internal_t *dims );
+            virtual ~SendDataGetRequest();
+            virtual void doSingleChunk();
+            virtual void doStrided( void *localAddr );
+         };
+
+         RequestQueue< SendDataRequest > _dataSendRequests;
+         struct FreeBufferRequest {
+            FreeBufferRequest(unsigned int dest, void *addr, WD const *w );
+            unsigned int destination;
+            void *address;
+            WD const * wd;
+         };
+         RequestQueue< FreeBufferRequest > _freeBufferReqs;
+         RequestQueue< std::pair< void const *, unsigned int > > _workDoneReqs;
+
+         Network *_net;
+         unsigned int _numNodes;
+         unsigned int _nodeNum;
+         std::vector< pid_t > _children;             /**< Pids of the forked nodes (node 0 only) */
+         unsigned int _pollCount;                    /**< Polls since the last check for exited nodes */
+
+         char *_mapping;                              /**< Shared mapping, inherited by every node */
+         std::size_t _mappingSize;
+         SharedHeader *_shared;
+         std::size_t _ringSize;                       /**< Bytes of the data area of each ring, a power of two */
+         std::size_t _ringStride;
+         char *_rings;                                /**< Ring from i to j is at index i * _numNodes + j */
+         std::size_t _segmentSize;
+         char *_segments;
+
+         std::vector< Lock * > _sendLocks;            /**< Serialize the producers of each outgoing ring */
+         std::vector< Lock * > _recvLocks;            /**< Serialize the consumers of each incoming ring */
+         std::vector< char * > _recvBuffers;          /**< Incoming message being handled, per ring */
+
+         SimpleAllocator *_thisNodeSegment;
+         Lock _thisNodeSegmentLock;
+         SimpleAllocator *_packSegment;
+         std::vector< SimpleAllocator * > _pinnedAllocators;
+         std::vector< Lock * > _pinnedAllocatorsLocks;
+         Atomic<unsigned int> *_seqN;
+
+         std::size_t _rxBytes;
+         std::size_t _txBytes;
+         std::size_t _totalBytes;
+
+         bool _unalignedNodeMemory;
+         NetWDTemplates _wdTemplates;
+
+      public:
+         typedef RemoteWorkDescriptor *ArchRWDs[4]; //0: smp, 1: cuda, 2: opencl, 3: fpga
+         ArchRWDs *_rwgs; //archs
+
+         SHMNetAPI();
+         ~SHMNetAPI();
+         void initialize ( Network *net );
+         void finalize ();
+         void finalizeNoBarrier ();
+         void poll ();
+         void sendExitMsg ( unsigned int dest );
+         void sendWorkMsg ( unsigned int dest, WorkDescriptor const &wd, std::size_t expectedData );
+         void sendWorkDoneMsg ( unsigned int dest, void const *remoteWdAddr );
+         void _sendWorkDoneMsg ( unsigned int dest, void const *remoteWdAddr );
+         void put ( unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, std::size_t size, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq );
+         void putStrided1D ( unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, void *localPack, std::size_t size, std::size_t count, std::size_t ld, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq );
+         void get ( void *localAddr, unsigned int remoteNode, uint64_t remoteAddr, std::size_t size, GetRequest *req, CopyData const &cd );
+         void getStrided1D ( void *packedAddr, unsigned int remoteNode, uint64_t remoteTag, uint64_t remoteAddr, std::size_t size, std::size_t count, std::size_t ld, GetRequestStrided *req, CopyData const &cd );
+         void malloc ( unsigned int remoteNode, std::size_t size, void *waitObjAddr );
+         void memFree ( unsigned int remoteNode, void *addr );
+         void memRealloc ( unsigned int remoteNode, void *oldAddr, std::size_t oldSize, void *newAddr, std::size_t newSize );
+         void nodeBarrier( void );
+
+         void sendMyHostName( unsigned int dest );
+         void sendRequestPut( unsigned int dest, uint64_t origAddr, unsigned int dataDest, uint64_t dstAddr, std::size_t len, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq );
+         void sendRequestPutStrided1D( unsigned int dest, uint64_t origAddr, unsigned int dataDest, uint64_t dstAddr, std::size_t len, std::size_t count, std::size_t ld, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq );
+         void sendRegionMetadata( unsigned int dest, CopyData *cd, unsigned int seq );
+
+         std::size_t getMaxGetStridedLen() const;
+         std::size_t getTotalBytes();
+         std::size_t getRxBytes();
+         std::size_t getTxBytes();
+         SimpleAllocator *getPackSegment() const;
+         void *allocateReceiveMemory( std::size_t len );
+         void freeReceiveMemory( void * addr );
+         void processSendDataRequest( SendDataRequest *req );
+         unsigned int getNumNodes() const;
+         unsigned int getNodeNum() const;
+         void synchronizeDirectory( unsigned int dest, void *addr );
+         void broadcastIdle();
+         std::size_t getMaxFrameSize() const;
+         void sendFrame( unsigned int dest, char const *frame, std::size_t len );
+         void processAggregatedMessage( unsigned int src, unsigned int type, char *data, std::size_t len );
+
+         void setNumNodes( unsigned int numNodes );
+         void setSegmentSize( std::size_t segmentSize );
+         void setRingSize( std::size_t ringSize );
+         void setUnalignedNodeMemory( bool flag );
+
+      private:
+         void spawnNodes();
+         Ring *getRing( unsigned int src, unsigned int dst ) const;
+         char *getSegment( unsigned int node ) const;
+         void sendMessage( unsigned int dest, MessageType type, uint64_t const *args, unsigned int numArgs, void const *payload = NULL, std::size_t payloadLen = 0 );
+         bool processRing( unsigned int src );
+         void processIncoming();
+         void handleMessage( unsigned int src, MessageHeader const &msg, char *payload );
+         bool checkChildren();
+
+         void *allocateTmpBuffer( unsigned int node, std::size_t len );
+         void _put ( unsigned int issueNode, unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, std::size_t size, void *remoteTmpBuffer, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq );
+         void _putStrided1D ( unsigned int issueNode, unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, std::size_t size, std::size_t count, std::size_t ld, void *remoteTmpBuffer, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq );
+         void sendFreeTmpBuffer( unsigned int dest, void *addr, WD const *wd );
+         void sendWaitForRequestPut( unsigned int dest, uint64_t addr, unsigned int wdId );
+         void enqueueFreeBufferNotify( unsigned int dest, void *bufferAddr, WD const *wd );
+         void checkForPutReqs();
+         void checkForFreeBufferReqs();
+         void checkWorkDoneReqs();
+
+         // Message handlers
+         void amWork( unsigned int src, uint64_t const *args, char *payload, std::size_t len );
+         void amWorkDone( unsigned int src, uint64_t const *args );
+         void amMalloc( unsigned int src, uint64_t const *args );
+         void amPut( unsigned int src, uint64_t const *args );
+         void amPutStrided1D( unsigned int src, uint64_t const *args );
+         void amGet( unsigned int src, char *payload );
+         void amFreeTmpBuffer( unsigned int src, uint64_t const *args );
+         void amSynchronizeDirectory( unsigned int src, uint64_t const *args );
+   };
+} // namespace ext
+} // namespace nanos
+
+#endif /* _SHMNETAPI_DECL */
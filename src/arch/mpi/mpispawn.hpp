@@ -13,6 +13,7 @@
 #include "filelock.hpp"
 
 #include "schedule.hpp"
+#include "chunkpool.hpp"
 
 #include <vector>
 
@@ -132,7 +133,7 @@ class RemoteSpawn {
 
 							// Destroy wd
 							finishedWD->~WorkDescriptor();
-							delete[] (char *)finishedWD;
+							ChunkPool::deallocate( finishedWD );
 						}
 					}
 				}
@@ -0,0 +1,138 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#include "smpcopy.hpp"
+#include <stdint.h>
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && defined(__GNUC__) && \
+    ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) || defined(__clang__) )
+#define NANOS_SMP_STREAMING_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace nanos;
+
+static void memcpyKernel( char *dst, char const *src, size_t len )
+{
+   ::memcpy( dst, src, len );
+}
+
+#ifdef NANOS_SMP_STREAMING_KERNELS
+
+//! \brief Bytes to copy with ::memcpy until dst is aligned to width
+static inline size_t alignmentPrefix( char const *dst, size_t width, size_t len )
+{
+   size_t prefix = ( width - ( (uintptr_t) dst & ( width - 1 ) ) ) & ( width - 1 );
+   return prefix < len ? prefix : len;
+}
+
+__attribute__(( target("sse2") ))
+static void sse2Kernel( char *dst, char const *src, size_t len )
+{
+   size_t prefix = alignmentPrefix( dst, 16, len );
+   ::memcpy( dst, src, prefix );
+   dst += prefix; src += prefix; len -= prefix;
+
+   for ( ; len >= 64; len -= 64, dst += 64, src += 64 ) {
+      __m128i v0 = _mm_loadu_si128( (__m128i const *) src );
+      __m128i v1 = _mm_loadu_si128( (__m128i const *) ( src + 16 ) );
+      __m128i v2 = _mm_loadu_si128( (__m128i const *) ( src + 32 ) );
+      __m128i v3 = _mm_loadu_si128( (__m128i const *) ( src + 48 ) );
+      _mm_stream_si128( (__m128i *) dst, v0 );
+      _mm_stream_si128( (__m128i *) ( dst + 16 ), v1 );
+      _mm_stream_si128( (__m128i *) ( dst + 32 ), v2 );
+      _mm_stream_si128( (__m128i *) ( dst + 48 ), v3 );
+   }
+   ::memcpy( dst, src, len );
+}
+
+__attribute__(( target("avx2") ))
+static void avx2Kernel( char *dst, char const *src, size_t len )
+{
+   size_t prefix = alignmentPrefix( dst, 32, len );
+   ::memcpy( dst, src, prefix );
+   dst += prefix; src += prefix; len -= prefix;
+
+   for ( ; len >= 128; len -= 128, dst += 128, src += 128 ) {
+      __m256i v0 = _mm256_loadu_si256( (__m256i const *) src );
+      __m256i v1 = _mm256_loadu_si256( (__m256i const *) ( src + 32 ) );
+      __m256i v2 = _mm256_loadu_si256( (__m256i const *) ( src + 64 ) );
+      __m256i v3 = _mm256_loadu_si256( (__m256i const *) ( src + 96 ) );
+      _mm256_stream_si256( (__m256i *) dst, v0 );
+      _mm256_stream_si256( (__m256i *) ( dst + 32 ), v1 );
+      _mm256_stream_si256( (__m256i *) ( dst + 64 ), v2 );
+      _mm256_stream_si256( (__m256i *) ( dst + 96 ), v3 );
+   }
+   ::memcpy( dst, src, len );
+}
+
+__attribute__(( target("avx512f") ))
+static void avx512Kernel( char *dst, char const *src, size_t len )
+{
+   size_t prefix = alignmentPrefix( dst, 64, len );
+   ::memcpy( dst, src, prefix );
+   dst += prefix; src += prefix; len -= prefix;
+
+   for ( ; len >= 256; len -= 256, dst += 256, src += 256 ) {
+      __m512i v0 = _mm512_loadu_si512( (void const *) src );
+      __m512i v1 = _mm512_loadu_si512( (void const *) ( src + 64 ) );
+      __m512i v2 = _mm512_loadu_si512( (void const *) ( src + 128 ) );
+      __m512i v3 = _mm512_loadu_si512( (void const *) ( src + 192 ) );
+      _mm512_stream_si512( (__m512i *) dst, v0 );
+      _mm512_stream_si512( (__m512i *) ( dst + 64 ), v1 );
+      _mm512_stream_si512( (__m512i *) ( dst + 128 ), v2 );
+      _mm512_stream_si512( (__m512i *) ( dst + 192 ), v3 );
+   }
+   ::memcpy( dst, src, len );
+}
+
+#endif
+
+SMPCopy::Kernel SMPCopy::_streamingKernel = memcpyKernel;
+const char *SMPCopy::_streamingKernelName = "memcpy";
+size_t SMPCopy::_streamingThreshold = ( size_t ) -1;
+
+void SMPCopy::init( size_t threshold )
+{
+   _streamingKernel = memcpyKernel;
+   _streamingKernelName = "memcpy";
+#ifdef NANOS_SMP_STREAMING_KERNELS
+   __builtin_cpu_init();
+   if ( __builtin_cpu_supports( "avx512f" ) ) {
+      _streamingKernel = avx512Kernel;
+      _streamingKernelName = "avx512";
+   } else if ( __builtin_cpu_supports( "avx2" ) ) {
+      _streamingKernel = avx2Kernel;
+      _streamingKernelName = "avx2";
+   } else if ( __builtin_cpu_supports( "sse2" ) ) {
+      _streamingKernel = sse2Kernel;
+      _streamingKernelName = "sse2";
+   }
+#endif
+   _streamingThreshold = ( threshold == 0 || _streamingKernel == memcpyKernel ) ? ( size_t ) -1 : threshold;
+}
+
+void SMPCopy::fence()
+{
+   // Non-temporal stores are weakly ordered, make them visible before the
+   // transfer is reported as completed
+#ifdef NANOS_SMP_STREAMING_KERNELS
+   _mm_sfence();
+#endif
+}
@@ -0,0 +1,69 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_SMP_COPY
+#define _NANOS_SMP_COPY
+
+#include <string.h>
+#include "smpcopy_decl.hpp"
+
+namespace nanos {
+
+inline bool SMPCopy::isStreaming( size_t size )
+{
+   return size >= _streamingThreshold;
+}
+
+inline void SMPCopy::copy( char *dst, char const *src, size_t len )
+{
+   copyStrided( dst, src, len, 1, 0, isStreaming( len ) );
+}
+
+inline void SMPCopy::copyStrided( char *dst, char const *src, size_t len, size_t count, size_t ld )
+{
+   copyStrided( dst, src, len, count, ld, isStreaming( len * count ) );
+}
+
+inline void SMPCopy::copyStrided( char *dst, char const *src, size_t len, size_t count, size_t ld, bool streaming )
+{
+   if ( !streaming ) {
+      for ( size_t row = 0; row < count; row += 1 ) {
+         ::memcpy( dst + row * ld, src + row * ld, len );
+      }
+   } else {
+      for ( size_t row = 0; row < count; row += 1 ) {
+         _streamingKernel( dst + row * ld, src + row * ld, len );
+      }
+      fence();
+   }
+}
+
+inline const char *SMPCopy::getStreamingKernelName()
+{
+   return _streamingKernelName;
+}
+
+inline size_t SMPCopy::getStreamingThreshold()
+{
+   return _streamingThreshold;
+}
+
+} // namespace nanos
+
+#endif
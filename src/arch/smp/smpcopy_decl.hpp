@@ -0,0 +1,72 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_SMP_COPY_DECL
+#define _NANOS_SMP_COPY_DECL
+
+#include <stddef.h>
+
+namespace nanos {
+
+   /*! \brief Memory copy routines used by the SMP transfers
+    *
+    *  Copies smaller than the streaming threshold use ::memcpy. Larger ones use a kernel
+    *  with non-temporal stores (the widest the CPU supports: AVX-512, AVX2 or SSE2), so
+    *  the destination lines do not evict the working set of the worker doing the copy.
+    *  The kernel is selected once, when the SMP plugin is initialized.
+    */
+   class SMPCopy
+   {
+      public:
+         typedef void (*Kernel)( char *dst, char const *src, size_t len );
+
+      private:
+         static Kernel      _streamingKernel;
+         static const char *_streamingKernelName;
+         static size_t      _streamingThreshold;
+
+         static void fence();
+
+      public:
+         /*! \brief Selects the streaming kernel and sets the size (bytes of the whole
+          *  transfer) from which it is used. A threshold of 0 disables it.
+          */
+         static void init( size_t threshold );
+
+         static const char *getStreamingKernelName();
+         static size_t getStreamingThreshold();
+
+         /*! \brief Whether a transfer of size bytes should use the streaming kernel */
+         static bool isStreaming( size_t size );
+
+         /*! \brief Copies len bytes from src to dst */
+         static void copy( char *dst, char const *src, size_t len );
+
+         /*! \brief Copies count rows of len bytes, separated ld bytes in both src and dst */
+         static void copyStrided( char *dst, char const *src, size_t len, size_t count, size_t ld );
+
+         /*! \brief Same as above, but the kernel has been chosen by the caller. Used by the
+          *  fragments of a transfer, which have to be copied as the whole transfer would.
+          */
+         static void copyStrided( char *dst, char const *src, size_t len, size_t count, size_t ld, bool streaming );
+   };
+
+} // namespace nanos
+
+#endif
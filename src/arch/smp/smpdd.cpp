@@ -26,6 +26,8 @@
 #include "smpdevice.hpp"
 #include "schedule.hpp"
 #include <string>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace nanos;
 using namespace nanos::ext;
@@ -37,6 +39,8 @@ SMPDevice &nanos::ext::getSMPDevice() {
 }
 
 size_t SMPDD::_stackSize = 256*1024;
+Lock SMPDD::_stackPoolLock;
+void * SMPDD::_freeStacks = NULL;
 
 //! \brief Registers the Device's configuration options
 //! \param reference to a configuration object.
@@ -57,6 +61,38 @@ void SMPDD::initStack ( WD *wd )
    _state = ::initContext(_stack, _stackSize, &workWrapper, wd, (void *) Scheduler::exit, 0);
 }
 
+//! \note Stacks are mmap'ed with a PROT_NONE guard page below them, so an overflow
+//! faults instead of silently corrupting the neighbour memory. They are never
+//! unmapped: once a stack has been created it is kept for the next untied WD.
+void * SMPDD::allocateStack ()
+{
+   if ( _freeStacks != NULL ) {
+      LockBlock lock( _stackPoolLock );
+      void *stack = _freeStacks;
+      if ( stack != NULL ) {
+         _freeStacks = *(void **) stack;
+         return stack;
+      }
+   }
+
+   static size_t pageSize = (size_t) sysconf( _SC_PAGESIZE );
+   size_t size = ( ( _stackSize + pageSize - 1 ) / pageSize ) * pageSize;
+
+   char *base = (char *) mmap( NULL, size + pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+   if ( base == MAP_FAILED ) fatal0( "Could not allocate a new task stack of " << _stackSize << " bytes" );
+   if ( mprotect( base, pageSize, PROT_NONE ) != 0 ) warning0( "Could not protect the guard page of a new task stack" );
+
+   verbose0("   new stack created: " << _stackSize << " bytes");
+   return (void *) ( base + pageSize );
+}
+
+void SMPDD::freeStack ( void *stack )
+{
+   LockBlock lock( _stackPoolLock );
+   *(void **) stack = _freeStacks;
+   _freeStacks = stack;
+}
+
 void SMPDD::workWrapper ( WD &wd )
 {
    SMPDD &dd = (SMPDD &) wd.getActiveDevice();
@@ -87,8 +123,7 @@ void SMPDD::lazyInit ( WD &wd, bool isUserLevelThread, WD *previous )
    verbose0("Task " << wd.getId() << " initialization"); 
    if (isUserLevelThread) {
       if (previous == NULL) {
-         _stack = (void *) NEW char[_stackSize];
-         verbose0("   new stack created: " << _stackSize << " bytes");
+         _stack = allocateStack();
       } else {
          verbose0("   reusing stacks");
          SMPDD &oldDD = (SMPDD &) previous->getActiveDevice();
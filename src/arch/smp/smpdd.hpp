@@ -24,6 +24,7 @@
 #include "smpdevice_decl.hpp"
 #include "workdescriptor_fwd.hpp"
 #include "config.hpp"
+#include "lock_decl.hpp"
 
 namespace nanos {
 namespace ext {
@@ -38,6 +39,13 @@ namespace ext {
          void               *_stack;             //!< Stack base
          void               *_state;             //!< Stack pointer
          static size_t       _stackSize;         //!< Stack size
+         static Lock         _stackPoolLock;     //!< Protects _freeStacks
+         static void        *_freeStacks;        //!< Recycled stacks (linked through their first word)
+
+         //! \brief Gets a stack of _stackSize bytes, recycled if possible
+         static void * allocateStack ();
+         //! \brief Returns a stack obtained through allocateStack() to the pool
+         static void freeStack ( void *stack );
       protected:
          SMPDD( work_fct w, Device *dd ) : DD( dd, w ),_stack( 0 ),_state( 0 ) {}
          SMPDD( Device *dd ) : DD( dd, NULL ), _stack( 0 ),_state( 0 ) {}
@@ -51,7 +59,7 @@ namespace ext {
          //! \brief Assignment operator
          const SMPDD & operator= ( const SMPDD &wd );
          //! \brief Destructor
-         virtual ~SMPDD() { if ( _stack ) delete[] (char *) _stack; }
+         virtual ~SMPDD() { if ( _stack ) freeStack( _stack ); }
 
          bool hasStack() { return _state != NULL; }
 
@@ -28,6 +28,7 @@
 #include "copydescriptor.hpp"
 #include "system_decl.hpp"
 #include "smptransferqueue.hpp"
+#include "smpcopy.hpp"
 #include "globalregt.hpp"
 
 namespace nanos {
@@ -85,7 +86,7 @@ void SMPDevice::_copyIn( uint64_t devAddr, uint64_t hostAddr, std::size_t len, S
             *myThread->_file << buff << std::endl;
          }
       }
-      ::memcpy( (void *) devAddr, (void *) hostAddr, len );
+      SMPCopy::copy( (char *) devAddr, (char *) hostAddr, len );
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseCloseBurstEvent( key, (nanos_event_value_t) 0 ); )
       ops->completeOp();
    }
@@ -107,7 +108,7 @@ void SMPDevice::_copyOut( uint64_t hostAddr, uint64_t devAddr, std::size_t len,
             //*myThread->_file << "WATCH update host: old value " << *((double *) sys._watchAddr )<< std::endl;
          }
       }
-      ::memcpy( (void *) hostAddr, (void *) devAddr, len );
+      SMPCopy::copy( (char *) hostAddr, (char *) devAddr, len );
       if (sys._watchAddr != NULL ) {
          if ((uint64_t )sys._watchAddr >= hostAddr && (uint64_t )sys._watchAddr < hostAddr + len) {
             char buff[256];
@@ -140,7 +141,7 @@ bool SMPDevice::_copyDevToDev( uint64_t devDestAddr, uint64_t devOrigAddr, std::
             *myThread->_file << buff << std::endl;
          }
       }
-      ::memcpy( (void *) devDestAddr, (void *) devOrigAddr, len );
+      SMPCopy::copy( (char *) devDestAddr, (char *) devOrigAddr, len );
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseCloseBurstEvent( key, (nanos_event_value_t) 0 ); )
       ops->completeOp();
    }
@@ -155,9 +156,7 @@ void SMPDevice::_copyInStrided1D( uint64_t devAddr, uint64_t hostAddr, std::size
       NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = sys.getInstrumentation()->getInstrumentationDictionary(); )
       NANOS_INSTRUMENT ( static nanos_event_key_t key = ID->getEventKey("cache-copy-in"); )
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseOpenBurstEvent( key, (nanos_event_value_t) 2 ); )
-      for ( std::size_t count = 0; count < numChunks; count += 1) {
-         ::memcpy( ((char *) devAddr) + count * ld, ((char *) hostAddr) + count * ld, len );
-      }
+      SMPCopy::copyStrided( (char *) devAddr, (char *) hostAddr, len, numChunks, ld );
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseCloseBurstEvent( key, (nanos_event_value_t) 0 ); )
       ops->completeOp();
    }
@@ -171,9 +170,7 @@ void SMPDevice::_copyOutStrided1D( uint64_t hostAddr, uint64_t devAddr, std::siz
       NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = sys.getInstrumentation()->getInstrumentationDictionary(); )
       NANOS_INSTRUMENT ( static nanos_event_key_t key = ID->getEventKey("cache-copy-out"); )
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseOpenBurstEvent( key, (nanos_event_value_t) 2 ); )
-      for ( std::size_t count = 0; count < numChunks; count += 1) {
-         ::memcpy( ((char *) hostAddr) + count * ld, ((char *) devAddr) + count * ld, len );
-      }
+      SMPCopy::copyStrided( (char *) hostAddr, (char *) devAddr, len, numChunks, ld );
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseCloseBurstEvent( key, (nanos_event_value_t) 0 ); )
       ops->completeOp();
    }
@@ -187,9 +184,7 @@ bool SMPDevice::_copyDevToDevStrided1D( uint64_t devDestAddr, uint64_t devOrigAd
       NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = sys.getInstrumentation()->getInstrumentationDictionary(); )
       NANOS_INSTRUMENT ( static nanos_event_key_t key = ID->getEventKey("cache-copy-in"); )
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseOpenBurstEvent( key, (nanos_event_value_t) 2 ); )
-      for ( std::size_t count = 0; count < numChunks; count += 1) {
-         ::memcpy( ((char *) devDestAddr) + count * ld, ((char *) devOrigAddr) + count * ld, len );
-      }
+      SMPCopy::copyStrided( (char *) devDestAddr, (char *) devOrigAddr, len, numChunks, ld );
       NANOS_INSTRUMENT( sys.getInstrumentation()->raiseCloseBurstEvent( key, (nanos_event_value_t) 0 ); )
       ops->completeOp();
    }
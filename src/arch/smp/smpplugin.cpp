@@ -24,6 +24,7 @@
 #include "atomic.hpp"
 #include "debug.hpp"
 #include "smpprocessor.hpp"
+#include "smpcopy.hpp"
 #include "os.hpp"
 #include "osallocator_decl.hpp"
 
@@ -68,6 +69,7 @@ nanos::PE * smpProcessorFactory ( int id, int uid )
                  , _memkindSupport( false )
                  , _memkindMemorySize( 1024*1024*1024 ) // 1Gb
                  , _asyncSMPTransfers( true )
+                 , _streamingCopyThreshold( 8 * 1024 * 1024 ) // 8Mb
    {}
 
    SMPPlugin::~SMPPlugin() {
@@ -150,6 +152,11 @@ nanos::PE * smpProcessorFactory ( int id, int uid )
             "SMP sync transfers." );
       cfg.registerArgOption( "smp-sync-transfers", "smp-sync-transfers" );
       cfg.registerEnvOption( "smp-sync-transfers", "NX_SMP_SYNC_TRANSFERS" );
+
+      cfg.registerConfigOption( "smp-streaming-copy-threshold", NEW Config::SizeVar( _streamingCopyThreshold ),
+            "Size of the SMP transfers from which non-temporal stores are used (0 disables them)." );
+      cfg.registerArgOption( "smp-streaming-copy-threshold", "smp-streaming-copy-threshold" );
+      cfg.registerEnvOption( "smp-streaming-copy-threshold", "NX_SMP_STREAMING_COPY_THRESHOLD" );
    }
 
    void SMPPlugin::init()
@@ -211,6 +218,9 @@ nanos::PE * smpProcessorFactory ( int id, int uid )
 
       loadNUMAInfo();
 
+      SMPCopy::init( _streamingCopyThreshold );
+      verbose0("SMP streaming copy kernel: " << SMPCopy::getStreamingKernelName() << " threshold: " << SMPCopy::getStreamingThreshold() );
+
       memory_space_id_t mem_id = sys.getRootMemorySpaceId();
 #ifdef MEMKIND_SUPPORT
       if ( _memkindSupport ) {
@@ -339,6 +349,8 @@ nanos::PE * smpProcessorFactory ( int id, int uid )
          std::cerr << "memkind: SMP Xfer IN bytes: " << mem.getCache().getTransferredInData() << std::endl;
          std::cerr << "memkind: SMP Xfer OUT bytes: " << mem.getCache().getTransferredOutData() << std::endl;
          std::cerr << "memkind: SMP Xfer OUT (Replacements) bytes: " << mem.getCache().getTransferredReplacedOutData() << std::endl;
+         std::cerr << "memkind: SMP replacements without scan: " << mem.getCache().getIndexedEvictionCount() << std::endl;
+         std::cerr << "memkind: SMP replacements with scan: " << mem.getCache().getScannedEvictionCount() << std::endl;
          SimpleAllocator *allocator = (SimpleAllocator *) mem.getSpecificData();
          delete allocator;
       } else if ( _smpPrivateMemory ) {
@@ -353,6 +365,8 @@ nanos::PE * smpProcessorFactory ( int id, int uid )
                   std::cerr << "PrivateMem: cpu " << (*it)->getId()  << " Xfer IN bytes: " << mem.getCache().getTransferredInData() << std::endl;
                   std::cerr << "PrivateMem: cpu " << (*it)->getId()  << " Xfer OUT bytes: " << mem.getCache().getTransferredOutData() << std::endl;
                   std::cerr << "PrivateMem: cpu " << (*it)->getId()  << " Xfer OUT (Replacements) bytes: " << mem.getCache().getTransferredReplacedOutData() << std::endl;
+                  std::cerr << "PrivateMem: cpu " << (*it)->getId()  << " replacements without scan: " << mem.getCache().getIndexedEvictionCount() << std::endl;
+                  std::cerr << "PrivateMem: cpu " << (*it)->getId()  << " replacements with scan: " << mem.getCache().getScannedEvictionCount() << std::endl;
                   total_in += mem.getCache().getTransferredInData();
                   total_out += mem.getCache().getTransferredOutData();
                }
@@ -83,6 +83,7 @@ class SMPPlugin : public SMPBasePlugin
    bool                         _memkindSupport;
    std::size_t                  _memkindMemorySize;
    bool                         _asyncSMPTransfers;
+   std::size_t                  _streamingCopyThreshold;
 
    public:
    SMPPlugin();
@@ -63,6 +63,7 @@ void SMPThread::idle( bool debug )
    if ( sys.getNetwork()->getNumNodes() > 1 ) {
       if ( this->_gasnetAllowAM ) {
       sys.getNetwork()->poll(0);
+      sys.getNetwork()->notifyThreadIdle( getId() );
 
       if ( !_pendingRequests.empty() ) {
          std::set<void *>::iterator it = _pendingRequests.begin();
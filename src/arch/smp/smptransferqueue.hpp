@@ -3,6 +3,7 @@
 #include "smptransferqueue_decl.hpp"
 #include "atomic.hpp"
 #include "deviceops.hpp"
+#include "smpcopy.hpp"
 
 namespace nanos {
 
@@ -13,13 +14,14 @@ SMPTransfer::SMPTransfer() :
    _len(133),
    _count(0),
    _ld(0),
-   _in( false ) {
+   _in( false ),
+   _streaming( false ) {
 }
 
-SMPTransfer::SMPTransfer( DeviceOps *ops, char *dst, char *src, std::size_t len, std::size_t count, std::size_t ld, bool in ) : _ops(ops), _dst(dst), _src(src), _len(len), _count(count), _ld(ld), _in( in ) {
+SMPTransfer::SMPTransfer( DeviceOps *ops, char *dst, char *src, std::size_t len, std::size_t count, std::size_t ld, bool in, bool streaming ) : _ops(ops), _dst(dst), _src(src), _len(len), _count(count), _ld(ld), _in( in ), _streaming( streaming ) {
    ops->addOp();
 }
-SMPTransfer::SMPTransfer( SMPTransfer const &s ) : _ops(s._ops), _dst(s._dst), _src(s._src), _len(s._len), _count(s._count), _ld(s._ld), _in(s._in) {
+SMPTransfer::SMPTransfer( SMPTransfer const &s ) : _ops(s._ops), _dst(s._dst), _src(s._src), _len(s._len), _count(s._count), _ld(s._ld), _in(s._in), _streaming(s._streaming) {
 }
 SMPTransfer &SMPTransfer::operator=( SMPTransfer const &s ) {
    _ops = s._ops;
@@ -29,6 +31,7 @@ SMPTransfer &SMPTransfer::operator=( SMPTransfer const &s ) {
    _count = s._count;
    _ld = s._ld;
    _in = s._in;
+   _streaming = s._streaming;
    return *this;
 }
 SMPTransfer::~SMPTransfer() {}
@@ -38,7 +41,9 @@ void SMPTransfer::execute() {
    NANOS_INSTRUMENT ( static nanos_event_key_t key_in = ID->getEventKey("cache-copy-in"); )
    NANOS_INSTRUMENT ( static nanos_event_key_t key_out = ID->getEventKey("cache-copy-out"); )
    NANOS_INSTRUMENT( sys.getInstrumentation()->raiseOpenBurstEvent( _in ? key_in : key_out , (nanos_event_value_t) _count * _len ); )
-   for ( std::size_t count = 0; count < _count; count += 1) {
+   if ( sys._watchAddr == NULL ) {
+      SMPCopy::copyStrided( _dst, _src, _len, _count, _ld, _streaming );
+   } else for ( std::size_t count = 0; count < _count; count += 1) {
       //if ( sys.getVerboseDevOps()){ 
       //   std::cerr << "memcpy( " << (void*)(_dst + count) << ", " << (void*)(_src + count *_ld) << ", " << _len << " ) [ld= " << _ld << " count= " << _count << " _dst= " << (void*)_dst << " _src= " << (void*)_src << " ]" << std::endl;
       //}
@@ -54,7 +59,7 @@ void SMPTransfer::execute() {
             *myThread->_file << buff << std::endl;
          }
       }
-      ::memcpy( _dst + count * _ld, _src + count * _ld, _len );
+      SMPCopy::copyStrided( _dst + count * _ld, _src + count * _ld, _len, 1, 0, _streaming );
       if (sys._watchAddr != NULL ) {
          if ((uint64_t )sys._watchAddr >= (uint64_t)(_dst + count *_ld ) && (uint64_t )sys._watchAddr < (uint64_t)(_dst + count * _ld + _len)) {
             char buff[256];
@@ -72,6 +77,8 @@ void SMPTransfer::execute() {
 
 SMPTransferQueue::SMPTransferQueue() : _lock(), _transfers() {}
 void SMPTransferQueue::addTransfer( DeviceOps *ops, char *dst, char *src, std::size_t len, std::size_t count, std::size_t ld, bool in ) {
+   // Fragments use the copy kernel that corresponds to the whole transfer
+   bool streaming = SMPCopy::isStreaming( len * count );
    _lock.acquire();
    // NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = sys.getInstrumentation()->getInstrumentationDictionary(); )
    // NANOS_INSTRUMENT ( static nanos_event_key_t key = ID->getEventKey("cache-copy-out"); )
@@ -81,9 +88,9 @@ void SMPTransferQueue::addTransfer( DeviceOps *ops, char *dst, char *src, std::s
          std::size_t current_chunk = CHUNK_SIZE;
          std::size_t total_processed = 0;
          while ( total_processed < len ) {
-            _transfers.push_back( SMPTransfer(ops, dst+total_processed, src+total_processed, current_chunk, 1, ld, in) );
+            _transfers.push_back( SMPTransfer(ops, dst+total_processed, src+total_processed, current_chunk, 1, ld, in, streaming) );
             total_processed += current_chunk;
-            current_chunk = total_processed + (CHUNK_SIZE*2) > len ? CHUNK_SIZE : len - total_processed;
+            current_chunk = total_processed + (CHUNK_SIZE*2) > len ? len - total_processed : CHUNK_SIZE;
          }
       } else {
          if ( len > CHUNK_SIZE*2 ) {
@@ -91,23 +98,24 @@ void SMPTransferQueue::addTransfer( DeviceOps *ops, char *dst, char *src, std::s
                std::size_t current_line_chunk = CHUNK_SIZE;
                std::size_t total_line = 0;
                while ( total_line < len ) {
-                  _transfers.push_back( SMPTransfer(ops, dst+(ld*count_idx)+total_line, src+(ld*count_idx)+total_line, current_line_chunk, 1, ld, in) );
+                  _transfers.push_back( SMPTransfer(ops, dst+(ld*count_idx)+total_line, src+(ld*count_idx)+total_line, current_line_chunk, 1, ld, in, streaming) );
                   total_line += current_line_chunk;
                   current_line_chunk = total_line + (CHUNK_SIZE*2) > len ?  len - total_line : CHUNK_SIZE;
                }
             }
          } else {
-            std::size_t current_count_chunk = CHUNK_SIZE / len;
+            std::size_t rows_per_chunk = len < CHUNK_SIZE ? CHUNK_SIZE / len : 1;
+            std::size_t current_count_chunk = rows_per_chunk;
             std::size_t total_count = 0;
             while ( total_count < count ) {
-               _transfers.push_back( SMPTransfer(ops, dst+(ld*total_count), src+(ld*total_count), len, current_count_chunk, ld, in) );
+               _transfers.push_back( SMPTransfer(ops, dst+(ld*total_count), src+(ld*total_count), len, current_count_chunk, ld, in, streaming) );
                total_count += current_count_chunk;
-               current_count_chunk = total_count + (CHUNK_SIZE/len)*2 > count ? count - total_count : (CHUNK_SIZE/len);
+               current_count_chunk = total_count + rows_per_chunk*2 > count ? count - total_count : rows_per_chunk;
             }
          }
       }
    } else {
-      _transfers.push_back( SMPTransfer(ops, dst, src, len, count, ld, in) );
+      _transfers.push_back( SMPTransfer(ops, dst, src, len, count, ld, in, streaming) );
    }
    // NANOS_INSTRUMENT( sys.getInstrumentation()->raiseCloseBurstEvent( key, (nanos_event_value_t) 0 ); )
    _lock.release();
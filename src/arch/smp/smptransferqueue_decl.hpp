@@ -15,9 +15,10 @@ class SMPTransfer {
    std::size_t  _count;
    std::size_t  _ld;
    bool         _in;
+   bool         _streaming;
    public:
    SMPTransfer();
-   SMPTransfer( DeviceOps *ops, char *dst, char *src, std::size_t len, std::size_t count, std::size_t ld, bool in );
+   SMPTransfer( DeviceOps *ops, char *dst, char *src, std::size_t len, std::size_t count, std::size_t ld, bool in, bool streaming );
    SMPTransfer( SMPTransfer const &s );
    SMPTransfer &operator=( SMPTransfer const &s );
    ~SMPTransfer();
@@ -107,6 +107,13 @@ namespace nanos {
 
          static int nanosleep ( unsigned long long nanoseconds );
 
+         /*! \brief Blocks the calling thread while *addr == value, at most for the given time
+          *  (falls back to nanosleep where futexes are not available)
+          */
+         static void futexWait ( int *addr, int value, unsigned long long nanoseconds );
+         //! \brief Wakes up to count threads blocked in futexWait on addr
+         static void futexWake ( int *addr, int count );
+
          static const InitList & getInitializationFunctions ();
          static const InitList & getPostInitializationFunctions ();
          static const ModuleList & getRequestedModules ();
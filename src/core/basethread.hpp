@@ -112,7 +112,8 @@ namespace nanos {
    inline BaseThread::BaseThread ( unsigned int osId, WD &wd, ProcessingElement *creator, ext::SMPMultiThread *parent ) :
       _id( sys.nextThreadId() ), _osId( osId ), _maxPrefetch( 1 ), _status( ), _parent( parent ), _pe( creator ), _mlock( ),
       _threadWD( wd ), _currentWD( NULL ), _heldWD( NULL ), _nextWDs( /* enableDeviceCounter */ false ), _teamData( NULL ), _nextTeamData( NULL ),
-      _name( "Thread" ), _description( "" ), _allocator( ), _steps(0), _bpCallBack( NULL ), _nextTeam( NULL ), _gasnetAllowAM( true ), _pendingRequests()
+      _name( "Thread" ), _description( "" ), _allocator( ), _steps(0), _bpCallBack( NULL ), _nextTeam( NULL ), _parkWord( 0 ), _idleSince( 0.0 ), _idleEstimate( 0.0 ),
+      _gasnetAllowAM( true ), _pendingRequests()
    {
          if ( sys.getSplitOutputForThreads() ) {
             if ( _parent != NULL ) {
@@ -264,6 +265,16 @@ namespace nanos {
 
    inline Allocator & BaseThread::getAllocator() { return _allocator; }
 
+   inline Atomic<int> & BaseThread::getParkWord() { return _parkWord; }
+
+   inline double BaseThread::getIdleSince() const { return _idleSince; }
+
+   inline void BaseThread::setIdleSince( double time ) { _idleSince = time; }
+
+   inline double BaseThread::getIdleEstimate() const { return _idleEstimate; }
+
+   inline void BaseThread::setIdleEstimate( double time ) { _idleEstimate = time; }
+
    inline void BaseThread::rename ( const char *name ) { _name = name; }
  
    inline const std::string & BaseThread::getName ( void ) const { return _name; }
@@ -200,6 +200,10 @@ namespace nanos {
          unsigned short          _steps;         //!< Number of scheduler steps (zero means infinite)
          callback_t              _bpCallBack;    //!< Break point callback. We call it after _steps scheduler ops
          ThreadTeam             *_nextTeam;      //!< If thread has no team, which team should it join
+         // Idle parking (see ThreadManager::idle):
+         Atomic<int>             _parkWord;      //!< Futex word, 1 while the thread is parked
+         double                  _idleSince;     //!< Start time of the current idle period
+         double                  _idleEstimate;  //!< Running average of the idle periods length (seconds)
 
       private:
          virtual void initializeDependent () = 0;
@@ -424,6 +428,14 @@ namespace nanos {
          ThreadTeam* getNextTeam() const;
          //! \brief Set next Team to enter
          void setNextTeam( ThreadTeam *team );
+
+         //! \brief Futex word the thread parks on when idle
+         Atomic<int> & getParkWord();
+         //! \brief Idle period bookkeeping used by the adaptive idle policy (see ThreadManager)
+         double getIdleSince() const;
+         void setIdleSince( double time );
+         double getIdleEstimate() const;
+         void setIdleEstimate( double time );
    };
 
    extern __thread BaseThread *myThread;
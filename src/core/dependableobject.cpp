@@ -148,7 +148,9 @@ void DependableObject::releaseReadDependencies ()
 
    //Decrease predecessor for sucessor tasks
    //Only decrease if they are NOT writing or reading something that we write
-   for ( DependableObject::DependableObjectVector::iterator currSucessorIt = succ.begin(); currSucessorIt != succ.end(); ) {
+   //Kept successors are compacted in place, so the whole pass does not move each edge more than once
+   DependableObject::DependableObjectVector::iterator keptIt = succ.begin();
+   for ( DependableObject::DependableObjectVector::iterator currSucessorIt = succ.begin(); currSucessorIt != succ.end(); currSucessorIt++ ) {
       DependableObject::TargetVector const &sucessorWrites = currSucessorIt->second->getWrittenTargets();
       DependableObject::TargetVector const &sucessorReads = currSucessorIt->second->getReadTargets();
       bool canRemovePredecessor=true;
@@ -170,13 +172,13 @@ void DependableObject::releaseReadDependencies ()
          //DependenciesDomain::decreaseTasksInGraph();
          NANOS_INSTRUMENT ( instrument ( *currSucessorIt->second ); ) 
          currSucessorIt->second->decreasePredecessors( NULL, this, false, false );
-         succ.erase(currSucessorIt++);
       }
       else 
       {
-         currSucessorIt++;
+         *keptIt++ = *currSucessorIt;
       }
    }
+   succ.erase( keptIt, succ.end() );
 }
 
 
@@ -194,7 +196,7 @@ DependableObject * DependableObject::releaseImmediateSuccessor ( DependableObjec
 
    {
       SyncLockBlock lock( this->getLock() );
-      // NOTE: it gets incremented in the erase
+      // NOTE: erase returns the next position
       for ( DependableObject::DependableObjectVector::iterator it = succ.begin(); it != succ.end(); ) {
          // Is this an immediate successor? 
          if ( it->second->numPredecessors() == 1 && condition(*it->second) && !(it->second->waits()) ) {
@@ -202,7 +204,7 @@ DependableObject * DependableObject::releaseImmediateSuccessor ( DependableObjec
                // remove it
                found = it->second;
                unsigned int wdId = it->first;
-               succ.erase(it++);
+               it = succ.erase(it);
                if ( found->numPredecessors() != 1 ) {
                   incorrectlyErased.insert( std::make_pair( wdId, found ) );
                   found = NULL;
@@ -26,6 +26,7 @@
 
 #include "atomic.hpp"
 #include "lock.hpp"
+#include "flatset.hpp"
 
 #include "dependableobject_decl.hpp"
 #include "basedependency_decl.hpp"
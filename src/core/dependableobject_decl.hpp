@@ -27,6 +27,7 @@
 
 #include "atomic_decl.hpp"
 #include "lock_decl.hpp"
+#include "flatset_decl.hpp"
 
 #include "dependenciesdomain_fwd.hpp"
 #include "basedependency_fwd.hpp"
@@ -87,7 +88,7 @@ namespace nanos {
    {
       public:
          typedef std::pair< unsigned int, DependableObject * > DependableObjectVectorKey;
-         typedef std::set<DependableObjectVectorKey> DependableObjectVector; /**< Type vector of successors  */
+         typedef FlatSet<DependableObjectVectorKey, 4> DependableObjectVector; /**< Type vector of successors (inline up to 4 edges) */
          typedef std::vector<BaseDependency*> TargetVector; /**< Type vector of output objects */
          
       private:
@@ -24,32 +24,31 @@
 #include "system.hpp"
 #include "instrumentation.hpp"
 #include "dataaccess.hpp"
+#include "shardedcounter.hpp"
 
 
 namespace nanos {
 
 Atomic<int> DependenciesDomain::_atomicSeed( 0 );
-Atomic<int> DependenciesDomain::_tasksInGraph( 0 );
+ShardedCounter DependenciesDomain::_tasksInGraph( 0 );
 Lock DependenciesDomain::_lock;
 
 using namespace dependencies_domain_internal;
 
 void DependenciesDomain::increaseTasksInGraph( size_t num )
 {
-   NANOS_INSTRUMENT(lock();)
+   // graph-size events report the approximate graph size, so that threads adding and
+   // removing nodes do not serialize on a global counter (or lock)
    NANOS_INSTRUMENT(nanos_event_value_t tasks = (nanos_event_value_t)(_tasksInGraph += num);)
    NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("graph-size");)
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, (nanos_event_value_t *) &tasks );)
-   NANOS_INSTRUMENT(unlock();)
 }
 
 void DependenciesDomain::decreaseTasksInGraph( size_t num )
 {
-   NANOS_INSTRUMENT(lock();)
    NANOS_INSTRUMENT(nanos_event_value_t tasks = (nanos_event_value_t)(_tasksInGraph-=num);)
    //NANOS_INSTRUMENT(int tasks = --_tasksInGraph;)
    NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("graph-size");)
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, (nanos_event_value_t *) &tasks );)
-   NANOS_INSTRUMENT(unlock();)
 }
 } // namespace nanos
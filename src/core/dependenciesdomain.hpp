@@ -77,6 +77,10 @@ inline void DependenciesDomain::finalizeAllReductions ( void )
 
 inline void DependenciesDomain::clearDependenciesDomain ( void ) { }
 
+inline void DependenciesDomain::beginGraphRegion ( const void *key ) { }
+
+inline void DependenciesDomain::endGraphRegion ( void ) { }
+
 } // namespace nanos
 
 #endif
@@ -50,6 +50,7 @@
 #ifndef _NANOS_DEPENDENCIES_DOMAIN_DECL
 #define _NANOS_DEPENDENCIES_DOMAIN_DECL
 #include "atomic_decl.hpp"
+#include "shardedcounter_decl.hpp"
 #include "recursivelock_decl.hpp"
 #include "lock_decl.hpp"
 #include "dataaccess_decl.hpp"
@@ -96,7 +97,7 @@ using namespace dependencies_domain_internal;
          static Atomic<int>   _atomicSeed;           /**< ID seed for the domains */
          int                  _id;                   /**< Domain's id */
          RecursiveLock        _instanceLock;         /**< Needed to access _addressDependencyMap */
-         static Atomic<int>   _tasksInGraph;         /**< Current number of tasks in the graph */
+         static ShardedCounter _tasksInGraph;        /**< Current number of tasks in the graph (per-thread sharded) */
          static Lock          _lock;
 
       private:
@@ -196,6 +197,16 @@ using namespace dependencies_domain_internal;
 
          //! \brief Clear all pendants references
          virtual void clearDependenciesDomain ( void ) ;
+
+         //! \brief Starts a dependence graph region identified by key
+         //!
+         //! Tasks submitted until endGraphRegion() are resolved once and their resolution is
+         //! reused by the following runs of the region, while their data accesses do not change.
+         //! Domains that do not support it run the region normally.
+         virtual void beginGraphRegion ( const void *key ) ;
+
+         //! \brief Ends the current dependence graph region
+         virtual void endGraphRegion ( void ) ;
    };
    
    /*! \class DependenciesManager.
@@ -439,6 +439,8 @@ namespace nanos {
             registerEventValue("api","in_final","nanos_in_final()");
             registerEventValue("api","set_final","nanos_set_final()");
             registerEventValue("api","dependence_release_all","nanos_dependence_release_all()");
+            registerEventValue("api","dependence_region_begin","nanos_dependence_region_begin()");
+            registerEventValue("api","dependence_region_end","nanos_dependence_region_end()");
             registerEventValue("api","set_translate_function","nanos_set_translate_function()");
             registerEventValue("api","memalign","nanos_memalign()");
             registerEventValue("api","cmalloc","nanos_cmalloc()");
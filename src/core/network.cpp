@@ -51,7 +51,9 @@ Network::Network () : _numNodes(1), _api((NetworkAPI *) 0), _nodeNum(0),
    _delayedBySeqNumberPutReqs(), _delayedBySeqNumberPutReqsLock(),
    _forwardedRegions(NULL),_gpuPresend(1), _smpPresend(1),
    _metadataSequenceNumbers(NULL), _recvMetadataSeq(1), _syncReqs(),
-   _syncReqsLock(), _nodeBarrierCounter(0), _parentWD(NULL) {}
+   _syncReqsLock(), _aggregationFrameSize(0), _aggregationTimeout(0.0),
+   _aggregationBuffers(NULL), _aggregatedMessages(0), _aggregatedFrames(0),
+   _nodeBarrierCounter(0), _parentWD(NULL) {}
 
 Network::~Network () {}
 
@@ -100,12 +102,23 @@ void Network::initialize( NetworkAPI *api )
    }
 
    _forwardedRegions = NEW RegionsForwarded[ getNumNodes()-1 ];
+
+   if ( _aggregationFrameSize > _api->getMaxFrameSize() ) {
+      _aggregationFrameSize = _api->getMaxFrameSize();
+   }
+   if ( _aggregationFrameSize > 0 && getNumNodes() > 1 ) {
+      _aggregationBuffers = NEW AggregationBuffer[ getNumNodes() ];
+      for ( unsigned int i = 0; i < getNumNodes(); i += 1 ) {
+         _aggregationBuffers[ i ]._frame = NEW char[ _aggregationFrameSize ];
+      }
+   }
 }
 
 void Network::finalize()
 {
    if ( _api != NULL )
    {
+      flushAggregatedMessages();
       _api->finalize();
    }
 }
@@ -131,6 +144,18 @@ void Network::poll( unsigned int id)
       if ( req ) {
          _api->processSendDataRequest( req );
       }
+      if ( _aggregationBuffers != NULL ) {
+         double now = -1.0;
+         for ( unsigned int dest = 0; dest < _numNodes; dest += 1 ) {
+            AggregationBuffer &buffer = _aggregationBuffers[ dest ];
+            if ( buffer._used == 0 ) continue;
+            if ( now < 0.0 ) now = OS::getMonotonicTime();
+            if ( now - buffer._firstMessageTime >= _aggregationTimeout && buffer._lock.tryAcquire() ) {
+               sendAggregatedFrame( dest, buffer );
+               buffer._lock.release();
+            }
+         }
+      }
       _api->poll();
    }
 }
@@ -140,6 +165,7 @@ void Network::sendExitMsg( unsigned int nodeNum )
    //  ensure ( _api != NULL, "No network api loaded." );
    if ( _nodeNum == MASTER_NODE_NUM )
    {
+      flushAggregatedMessages( nodeNum );
       _api->sendExitMsg( nodeNum );
    }
 }
@@ -168,7 +194,9 @@ void Network::sendWorkDoneMsg( unsigned int nodeNum, void const *remoteWdAddr )
       //NANOS_INSTRUMENT ( instr->raiseOpenPtPEventNkvs( NANOS_WD_REMOTE, id, 0, NULL, NULL, 0 ); )
       if ( _nodeNum != MASTER_NODE_NUM )
       {
-         _api->sendWorkDoneMsg( nodeNum, remoteWdAddr );
+         if ( !aggregateMessage( nodeNum, AGGREGATED_WORK_DONE, &remoteWdAddr, sizeof( remoteWdAddr ) ) ) {
+            _api->sendWorkDoneMsg( nodeNum, remoteWdAddr );
+         }
       }
    }
 }
@@ -199,13 +227,14 @@ void Network::put ( unsigned int remoteNode, uint64_t remoteAddr, void *localAdd
          cd.setHostRegionId( hostRegId );
 
          seq = getMetadataSequenceNumber( remoteNode );
-         _api->sendRegionMetadata( remoteNode, &cd, seq );
+         sendRegionMetadata( remoteNode, &cd, seq );
          seq += 1;
          _forwardedRegions[remoteNode-1].addForwardedRegion( reg );
       } else {
          seq = checkMetadataSequenceNumber( remoteNode );
       }
       //std::cerr << " send put with seq " << seq << std::endl;
+      flushAggregatedMessages( remoteNode );
       _api->put( remoteNode, remoteAddr, localAddr, size, wdId, wd, hostObject, hostRegId, seq );
    }
 }
@@ -227,12 +256,13 @@ void Network::putStrided1D ( unsigned int remoteNode, uint64_t remoteAddr, void
          cd.setHostRegionId( hostRegId );
 
          seq = getMetadataSequenceNumber( remoteNode );
-         _api->sendRegionMetadata( remoteNode, &cd, seq );
+         sendRegionMetadata( remoteNode, &cd, seq );
          seq += 1;
          _forwardedRegions[remoteNode-1].addForwardedRegion( reg );
       } else {
          seq = checkMetadataSequenceNumber( remoteNode );
       }
+      flushAggregatedMessages( remoteNode );
       _api->putStrided1D( remoteNode, remoteAddr, localAddr, localPack, size, count, ld, wdId, wd, hostObject, hostRegId, seq );
    }
 }
@@ -251,6 +281,7 @@ void Network::get ( void *localAddr, unsigned int remoteNode, uint64_t remoteAdd
       cd.setHostRegionId( hostRegId );
       _forwardedRegions[remoteNode-1].addForwardedRegion( reg );
 
+      flushAggregatedMessages( remoteNode );
       _api->get( localAddr, remoteNode, remoteAddr, size, req, cd );
    }
 }
@@ -269,6 +300,7 @@ void Network::getStrided1D ( void *packedAddr, unsigned int remoteNode, uint64_t
       cd.setHostRegionId( hostRegId );
       _forwardedRegions[remoteNode-1].addForwardedRegion( reg );
 
+      flushAggregatedMessages( remoteNode );
       _api->getStrided1D( packedAddr, remoteNode, remoteTag, remoteAddr, size, count, ld, req, cd );
    }
 }
@@ -282,6 +314,7 @@ void * Network::malloc ( unsigned int remoteNode, std::size_t size )
 
    if ( _api != NULL )
    {
+      flushAggregatedMessages( remoteNode );
       _api->malloc( remoteNode, size, ( void * ) &request );
 
 #ifdef HAVE_NEW_GCC_ATOMIC_OPS
@@ -331,6 +364,7 @@ void Network::memFree ( unsigned int remoteNode, void *addr )
 {
    if ( _api != NULL )
    {
+      flushAggregatedMessages( remoteNode );
       _api->memFree( remoteNode, addr );
    }
 }
@@ -339,6 +373,7 @@ void Network::memRealloc ( unsigned int remoteNode, void *oldAddr, std::size_t o
 {
    if ( _api != NULL )
    {
+      flushAggregatedMessages( remoteNode );
       _api->memRealloc( remoteNode, oldAddr, oldSize, newAddr, newSize );
    }
 }
@@ -354,6 +389,7 @@ void Network::nodeBarrier()
 {
    if ( _api != NULL )
    {
+      flushAggregatedMessages();
       _api->nodeBarrier();
       _nodeBarrierCounter += 1;
    }
@@ -395,13 +431,15 @@ void Network::sendRequestPut( unsigned int dest, uint64_t origAddr, unsigned int
          cd.setHostRegionId( hostRegId );
 
          seq = getMetadataSequenceNumber( dataDest );
-         _api->sendRegionMetadata( dataDest, &cd, seq );
+         sendRegionMetadata( dataDest, &cd, seq );
          seq += 1;
          _forwardedRegions[dataDest-1].addForwardedRegion( reg );
       } else {
          seq = checkMetadataSequenceNumber( dataDest );
       }
       // added
+      flushAggregatedMessages( dataDest );
+      flushAggregatedMessages( dest );
       _api->sendRequestPut( dest, origAddr, dataDest, dstAddr, len, wdId, wd, hostObject, hostRegId, 0 );
    }
 }
@@ -423,12 +461,14 @@ void Network::sendRequestPutStrided1D( unsigned int dest, uint64_t origAddr, uns
          cd.setHostRegionId( hostRegId );
 
          seq = getMetadataSequenceNumber( dataDest );
-         _api->sendRegionMetadata( dataDest, &cd, seq );
+         sendRegionMetadata( dataDest, &cd, seq );
          seq += 1;
          _forwardedRegions[dataDest-1].addForwardedRegion( reg );
       } else {
          seq = checkMetadataSequenceNumber( dataDest );
       }
+      flushAggregatedMessages( dataDest );
+      flushAggregatedMessages( dest );
       _api->sendRequestPutStrided1D( dest, origAddr, dataDest, dstAddr, len, count, ld, wdId, wd, hostObject, hostRegId, 0 );
    }
 }
@@ -749,19 +789,16 @@ void SendDataRequest::doSend() {
       doSingleChunk();
       //NANOS_INSTRUMENT( sys.getInstrumentation()->raiseCloseStateAndBurst( key ) );
    } else {
-      char *localPack, *origAddrPtr = (char*) _origAddr;
+      char *localPack;
 
       //NANOS_INSTRUMENT( InstrumentState inst2(NANOS_STRIDED_COPY_PACK); );
       _api->getPackSegment()->lock();
       localPack = ( char * ) _api->getPackSegment()->allocate( _len * _count );
       if ( localPack == NULL ) { fprintf(stderr, "ERROR!!! could not get an addr to pack strided data\n" ); }
       _api->getPackSegment()->unlock();
-
-      for ( unsigned int i = 0; i < _count; i += 1 ) {
-         memcpy( &localPack[ i * _len ], &origAddrPtr[ i * _ld ], _len );
-      }
       //NANOS_INSTRUMENT( inst2.close(); );
 
+      // doStrided gathers the rows into localPack before sending them
       doStrided( localPack );
 
       _api->getPackSegment()->lock();
@@ -919,9 +956,7 @@ GetRequestStrided::~GetRequestStrided() {
 
 void GetRequestStrided::clear() {
    //NANOS_INSTRUMENT( InstrumentState inst2(NANOS_STRIDED_COPY_UNPACK); );
-   for ( unsigned int j = 0; j < _count; j += 1 ) {
-      ::memcpy( &_hostAddr[ j  * _ld ], &_recvAddr[ j * _size ], _size );
-   }
+   Packer::unpack( _hostAddr, _recvAddr, _size, _count, _ld );
    if ( VERBOSE_COMPLETION ) {
       (*myThread->_file) << std::setprecision(std::numeric_limits<double>::digits10) << OS::getMonotonicTime() << " Completed copyOutStrided request, hostAddr="<< (void*)_hostAddr <<" ["<< *((double*) _hostAddr) <<"] ops=" << (void *) _ops << std::endl;
    }
@@ -974,6 +1009,7 @@ void Network::deleteDirectoryObject( GlobalRegionDictionary const *obj ) {
 void Network::synchronizeDirectory( void *addr ) {
    if ( this->getNodeNum() == 0 ) { //this is called by the slaves by the handler of this message, avoid the recursive call
       if ( _api != NULL ) {
+         flushAggregatedMessages();
          for (unsigned int idx = 1; idx < getNumNodes(); idx += 1) {
             _api->synchronizeDirectory( idx, addr );
          }
@@ -984,6 +1020,7 @@ void Network::synchronizeDirectory( void *addr ) {
 
 void Network::broadcastIdle() {
    if ( _api != NULL ) {
+      flushAggregatedMessages();
       _api->broadcastIdle();
    }
 }
@@ -1026,3 +1063,136 @@ void Network::setParentWD(WD *wd) {
 void Network::notifyIdle( unsigned int node ) {
    sys.notifyIdle( node );
 }
+
+namespace {
+   //! \brief Aggregated region metadata, followed by the dimensions of the region
+   struct RegionMetadataRecord {
+      uint64_t _seq;
+      CopyData _cd;
+   };
+}
+
+void Network::sendRegionMetadata( unsigned int dest, CopyData *cd, unsigned int seq ) {
+   RegionMetadataRecord record;
+   record._seq = seq;
+   ::memcpy( &record._cd, cd, sizeof( CopyData ) );
+   if ( !aggregateMessage( dest, AGGREGATED_REGION_METADATA, &record, sizeof( record ),
+            cd->getDimensions(), cd->getNumDimensions() * sizeof( nanos_region_dimension_internal_t ) ) ) {
+      _api->sendRegionMetadata( dest, cd, seq );
+   }
+}
+
+void Network::setAggregation( std::size_t frameSize, unsigned int timeoutUs ) {
+   _aggregationFrameSize = frameSize;
+   _aggregationTimeout = ( (double) timeoutUs ) / 1000000.0;
+}
+
+//! \brief Adds a message to the frame of dest, the message is made of len bytes
+//! from data followed by extraLen bytes from extra. Returns false if aggregation
+//! is disabled or the message does not fit in a frame, the caller must then
+//! send the message by itself.
+bool Network::aggregateMessage( unsigned int dest, unsigned int type, void const *data, std::size_t len, void const *extra, std::size_t extraLen ) {
+   if ( _aggregationBuffers == NULL ) return false;
+
+   std::size_t msgLen = len + extraLen;
+   std::size_t recordLen = ( sizeof( AggregatedMessageHeader ) + msgLen + 7 ) & ~( (std::size_t) 7 );
+   if ( recordLen > _aggregationFrameSize ) return false;
+
+   AggregationBuffer &buffer = _aggregationBuffers[ dest ];
+   buffer._lock.acquire();
+   if ( buffer._used + recordLen > _aggregationFrameSize ) {
+      sendAggregatedFrame( dest, buffer );
+   }
+   if ( buffer._used == 0 ) {
+      buffer._firstMessageTime = OS::getMonotonicTime();
+   }
+   char *record = &buffer._frame[ buffer._used ];
+   AggregatedMessageHeader *header = ( AggregatedMessageHeader * ) record;
+   header->_type = type;
+   header->_len = msgLen;
+   ::memcpy( record + sizeof( AggregatedMessageHeader ), data, len );
+   if ( extraLen > 0 ) {
+      ::memcpy( record + sizeof( AggregatedMessageHeader ) + len, extra, extraLen );
+   }
+   buffer._messages += 1;
+   buffer._lastWriter = ( myThread != NULL ) ? myThread->getId() : -1;
+   buffer._used += recordLen;
+   buffer._lock.release();
+   return true;
+}
+
+//! \brief Sends the frame of dest, buffer._lock must be held
+void Network::sendAggregatedFrame( unsigned int dest, AggregationBuffer &buffer ) {
+   if ( buffer._used == 0 ) return;
+   _api->sendFrame( dest, buffer._frame, buffer._used );
+   _aggregatedFrames++;
+   _aggregatedMessages += buffer._messages;
+   buffer._messages = 0;
+   buffer._used = 0;
+}
+
+void Network::flushAggregatedMessages( unsigned int dest ) {
+   if ( _aggregationBuffers != NULL && _aggregationBuffers[ dest ]._used != 0 ) {
+      AggregationBuffer &buffer = _aggregationBuffers[ dest ];
+      buffer._lock.acquire();
+      sendAggregatedFrame( dest, buffer );
+      buffer._lock.release();
+   }
+}
+
+void Network::flushAggregatedMessages() {
+   if ( _aggregationBuffers != NULL ) {
+      for ( unsigned int dest = 0; dest < _numNodes; dest += 1 ) {
+         flushAggregatedMessages( dest );
+      }
+   }
+}
+
+//! \brief A thread has nothing else to do, send the frames it was filling
+void Network::notifyThreadIdle( int threadId ) {
+   if ( _aggregationBuffers != NULL ) {
+      for ( unsigned int dest = 0; dest < _numNodes; dest += 1 ) {
+         AggregationBuffer &buffer = _aggregationBuffers[ dest ];
+         if ( buffer._used != 0 && buffer._lastWriter == threadId && buffer._lock.tryAcquire() ) {
+            sendAggregatedFrame( dest, buffer );
+            buffer._lock.release();
+         }
+      }
+   }
+}
+
+void Network::notifyAggregatedMessages( unsigned int src, char *frame, std::size_t len ) {
+   std::size_t offset = 0;
+   while ( offset < len ) {
+      AggregatedMessageHeader *header = ( AggregatedMessageHeader * ) &frame[ offset ];
+      char *data = &frame[ offset + sizeof( AggregatedMessageHeader ) ];
+      switch ( header->_type ) {
+         case AGGREGATED_WORK_DONE:
+            {
+               void *remoteWdAddr;
+               ::memcpy( &remoteWdAddr, data, sizeof( remoteWdAddr ) );
+               notifyWorkDone( src, remoteWdAddr, 0 );
+            }
+            break;
+         case AGGREGATED_REGION_METADATA:
+            {
+               RegionMetadataRecord *record = ( RegionMetadataRecord * ) data;
+               record->_cd.setDimensions( ( nanos_region_dimension_internal_t * ) ( data + sizeof( RegionMetadataRecord ) ) );
+               notifyRegionMetaData( &record->_cd, ( unsigned int ) record->_seq );
+            }
+            break;
+         default:
+            _api->processAggregatedMessage( src, header->_type, data, header->_len );
+            break;
+      }
+      offset += ( sizeof( AggregatedMessageHeader ) + header->_len + 7 ) & ~( (std::size_t) 7 );
+   }
+}
+
+unsigned int Network::getAggregatedMessagesCount() const {
+   return _aggregatedMessages.value();
+}
+
+unsigned int Network::getAggregatedFramesCount() const {
+   return _aggregatedFrames.value();
+}
@@ -237,8 +237,39 @@ namespace nanos {
          std::list<SyncWDs> _syncReqs;
          RecursiveLock _syncReqsLock;
 
+         /*! \brief Small control messages to one node waiting to be sent together in a single frame */
+         struct AggregationBuffer {
+            Lock         _lock;
+            char        *_frame;
+            std::size_t  _used;
+            unsigned int _messages;
+            double       _firstMessageTime;   /**< When the oldest message of the frame was added */
+            int          _lastWriter;         /**< Id of the last thread that added a message */
+            AggregationBuffer() : _lock(), _frame( NULL ), _used( 0 ), _messages( 0 ), _firstMessageTime( 0.0 ), _lastWriter( -1 ) {}
+         };
+         std::size_t _aggregationFrameSize;   /**< 0 when aggregation is disabled */
+         double _aggregationTimeout;          /**< Seconds a message can wait in a frame */
+         AggregationBuffer *_aggregationBuffers;
+         Atomic<unsigned int> _aggregatedMessages;
+         Atomic<unsigned int> _aggregatedFrames;
+
+         void sendAggregatedFrame( unsigned int dest, AggregationBuffer &buffer );
+         void sendRegionMetadata( unsigned int dest, CopyData *cd, unsigned int seq );
+
       public:
          static const unsigned int MASTER_NODE_NUM = 0;
+
+         //! \brief Types of the messages carried inside an aggregated frame, the
+         //! network API can define its own ones from AGGREGATED_API_MESSAGE on
+         enum AggregatedMessageType {
+            AGGREGATED_WORK_DONE = 0,
+            AGGREGATED_REGION_METADATA,
+            AGGREGATED_API_MESSAGE = 16
+         };
+         struct AggregatedMessageHeader {
+            uint32_t _type;
+            uint32_t _len;
+         };
          typedef struct {
             int complete;
             void * resultAddr;
@@ -334,6 +365,15 @@ namespace nanos {
          void broadcastIdle();
          void processSyncRequests();
          void setParentWD(WD *wd);
+
+         void setAggregation( std::size_t frameSize, unsigned int timeoutUs );
+         bool aggregateMessage( unsigned int dest, unsigned int type, void const *data, std::size_t len, void const *extra = NULL, std::size_t extraLen = 0 );
+         void flushAggregatedMessages( unsigned int dest );
+         void flushAggregatedMessages();
+         void notifyThreadIdle( int threadId );
+         void notifyAggregatedMessages( unsigned int src, char *frame, std::size_t len );
+         unsigned int getAggregatedMessagesCount() const;
+         unsigned int getAggregatedFramesCount() const;
    };
 
 } // namespace nanos
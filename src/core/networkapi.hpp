@@ -46,6 +46,8 @@ namespace nanos {
          virtual void sendWorkMsg ( unsigned int dest, WorkDescriptor const &wd, std::size_t expectedData ) = 0;
          virtual void sendWorkDoneMsg ( unsigned int dest, void const *remoteWdAddr ) = 0;
          virtual void put ( unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, std::size_t size, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq ) = 0;
+         //! \brief Sends count rows of size bytes, ld bytes apart from localAddr. localPack is a
+         //! buffer of size * count bytes where the implementation gathers the rows (Packer::pack).
          virtual void putStrided1D ( unsigned int remoteNode, uint64_t remoteAddr, void *localAddr, void *localPack, std::size_t size, std::size_t count, std::size_t ld, unsigned int wdId, WD const *wd, void *hostObject, reg_t hostRegId, unsigned int metaSeq ) = 0;
          virtual void get ( void *localAddr, unsigned int remoteNode, uint64_t remoteAddr, std::size_t size, GetRequest *req, CopyData const &cd ) = 0;
          virtual void getStrided1D ( void *packedAddr, unsigned int remoteNode, uint64_t remoteTag, uint64_t remoteAddr, std::size_t size, std::size_t count, std::size_t ld, GetRequestStrided *req, CopyData const &cd ) = 0;
@@ -68,6 +70,12 @@ namespace nanos {
          virtual void processSendDataRequest( SendDataRequest *req ) = 0;
          virtual void synchronizeDirectory( unsigned int node, void *addr ) = 0;
          virtual void broadcastIdle() = 0;
+         //! \brief Largest frame of aggregated messages that sendFrame can deliver in one message
+         virtual std::size_t getMaxFrameSize() const = 0;
+         //! \brief Sends a frame of aggregated messages, the receiver hands it to Network::notifyAggregatedMessages
+         virtual void sendFrame( unsigned int dest, char const *frame, std::size_t len ) = 0;
+         //! \brief Handles an aggregated message of a type defined by the API (>= Network::AGGREGATED_API_MESSAGE)
+         virtual void processAggregatedMessage( unsigned int src, unsigned int type, char *data, std::size_t len ) = 0;
    };
 
 } // namespace nanos
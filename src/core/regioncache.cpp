@@ -81,12 +81,14 @@ AllocatedChunk::AllocatedChunk( RegionCache &owner, uint64_t addr, uint64_t host
    _size( size ),
    _dirty( false ),
    _rooted( rooted ),
-   _lruStamp( 0 ),
    _refs( 0 ),
    _refWdId(),
    _refLoc(),
    _allocatedRegion( allocatedRegion ),
-   _flushable( false ) {
+   _flushable( false ),
+   _lruPrev( NULL ),
+   _lruNext( NULL ),
+   _lruList( NULL ) {
       //*myThread->_file << "region " << allocatedRegion.id << " addr " << (void *) addr<<" hostAddr is " << (void*)hostAddress << " key " << allocatedRegion.key << std::endl;
       _newRegions = NEW CacheRegionDictionary( *(allocatedRegion.key) );
       //*myThread->_file << "Created dictionary " << _newRegions << " w/key " << allocatedRegion.key << std::endl;
@@ -94,6 +96,7 @@ AllocatedChunk::AllocatedChunk( RegionCache &owner, uint64_t addr, uint64_t host
 }
 
 AllocatedChunk::~AllocatedChunk() {
+   _owner.removeEvictionCandidate( this );
    //*myThread->_file << "Im being released! "<< (void *) _newRegions << std::endl;
    for ( CacheRegionDictionary::citerator it = _newRegions->begin(); it != _newRegions->end(); it++ ) {
       CachedRegionStatus *entry = (CachedRegionStatus *) it->second.getData();
@@ -756,95 +759,85 @@ bool AllocatedChunk::invalidate( RegionCache *targetCache, LockedObjects &srcReg
 
 }
 
+void RegionCache::lruLink( AllocatedChunkLruList &list, AllocatedChunk *chunk ) {
+   chunk->_lruList = &list;
+   chunk->_lruPrev = list._tail;
+   chunk->_lruNext = NULL;
+   if ( list._tail != NULL ) {
+      list._tail->_lruNext = chunk;
+   } else {
+      list._head = chunk;
+   }
+   list._tail = chunk;
+}
+
+void RegionCache::lruUnlink( AllocatedChunk *chunk ) {
+   AllocatedChunkLruList &list = *chunk->_lruList;
+   if ( chunk->_lruPrev != NULL ) {
+      chunk->_lruPrev->_lruNext = chunk->_lruNext;
+   } else {
+      list._head = chunk->_lruNext;
+   }
+   if ( chunk->_lruNext != NULL ) {
+      chunk->_lruNext->_lruPrev = chunk->_lruPrev;
+   } else {
+      list._tail = chunk->_lruPrev;
+   }
+   chunk->_lruPrev = NULL;
+   chunk->_lruNext = NULL;
+   chunk->_lruList = NULL;
+}
+
+void RegionCache::addEvictionCandidate( AllocatedChunk *chunk ) {
+   if ( chunk->isRooted() ) return;
+
+   SyncLockBlock lock( _evictionLock );
+   if ( chunk->_lruList != NULL ) lruUnlink( chunk );
+   EvictionBucket &bucket = _evictionIndex[ chunk->getSize() ];
+   lruLink( chunk->isDirty() ? bucket._dirty : bucket._clean, chunk );
+}
+
+void RegionCache::removeEvictionCandidate( AllocatedChunk *chunk ) {
+   SyncLockBlock lock( _evictionLock );
+   if ( chunk->_lruList != NULL ) lruUnlink( chunk );
+}
+
 AllocatedChunk **RegionCache::selectChunkToInvalidate( std::size_t allocSize ) {
    AllocatedChunk **allocChunkPtrPtr = NULL;
-   MemoryMap<AllocatedChunk>::iterator it;
-   bool done = false;
-   int count = 0;
-   //for ( it = _chunks.begin(); it != _chunks.end() && !done; it++ ) {
-   //   *myThread->_file << "["<< count << "] this chunk: " << ((void *) it->second) << " refs: " << (int)( (it->second != NULL) ? it->second->getReferenceCount() : -1 ) << " dirty? " << (int)( (it->second != NULL) ? it->second->isDirty() : -1 )<< std::endl;
-   //   count++;
-   //}
-   //count = 0;
-   AllocatedChunk **chunkToReuseNoLruPtr = NULL;
-   MemoryMap<AllocatedChunk>::iterator itNoLru;
-   AllocatedChunk **chunkToReusePtr = NULL;
-   AllocatedChunk **chunkToReuseDirtyNoLruPtr = NULL;
-   MemoryMap<AllocatedChunk>::iterator itDirtyNoLru;
-   AllocatedChunk **chunkToReuseDirtyPtr = NULL;
-   MemoryMap<AllocatedChunk>::iterator itDirty;
-   for ( it = _chunks.begin(); it != _chunks.end() && !done; it++ ) {
-      // if ( it->second != NULL ) {
-      //    global_reg_t reg = it->second->getAllocatedRegion();
-      //    *myThread->_file << "["<< count << "] mmm this chunk: " << ((void *) it->second) << " refs " <<  it->second->getReferenceCount() << " size is " << it->second->getSize() << " vs " << allocSize << " ";
-      //    reg.key->printRegion( reg.id );
-      //    *myThread->_file << std::endl;
-      // }
-      if ( it->second != NULL && (it->second != (AllocatedChunk *) -1)
-            && (it->second != (AllocatedChunk *) -2)
-            && it->second->getReferenceCount() == 0
-            && !(it->second->isRooted())
-            && it->second->getSize() == allocSize ) {
-         if ( !it->second->isDirty() ) {
-            if ( _lruTime == it->second->getLruStamp() ) {
-               //*myThread->_file << "["<< count << "] this chunk: " << ((void *) it->second) << std::endl;
-               chunkToReusePtr = &(it->second);
-               done = true;
-               break;
-            } else if ( chunkToReuseNoLruPtr == NULL ) {
-               chunkToReuseNoLruPtr = &(it->second);
-               itNoLru = it;
-            }
-         } else {
-            if ( _lruTime == it->second->getLruStamp() ) {
-               //*myThread->_file << "["<< count << "] this chunk: " << ((void *) it->second) << std::endl;
-               chunkToReuseDirtyPtr = &(it->second);
-               itDirty = it;
-            } else if ( chunkToReuseDirtyNoLruPtr == NULL ) {
-               chunkToReuseDirtyNoLruPtr = &(it->second);
-               itDirtyNoLru = it;
-            }
+   SyncLockBlock lock( _evictionLock );
+
+   EvictionIndex::iterator bucketIt = _evictionIndex.find( allocSize );
+   if ( bucketIt == _evictionIndex.end() ) return NULL;
+   EvictionBucket &bucket = bucketIt->second;
+
+   // Clean chunks first, as they do not need to be copied back, the least recently released first
+   AllocatedChunkLruList *lists[2] = { &bucket._clean, &bucket._dirty };
+   for ( unsigned int idx = 0; idx < 2 && allocChunkPtrPtr == NULL; idx += 1 ) {
+      while ( lists[idx]->_head != NULL ) {
+         AllocatedChunk *chunk = lists[idx]->_head;
+         // The index is updated out of the cache lock: a chunk may have been referenced or
+         // written in between, discard (or move) the entries that are no longer valid
+         if ( chunk->getReferenceCount() != 0 ) {
+            lruUnlink( chunk );
+            continue;
          }
+         if ( idx == 0 && chunk->isDirty() ) {
+            lruUnlink( chunk );
+            lruLink( bucket._dirty, chunk );
+            continue;
+         }
+         MemoryMap<AllocatedChunk>::iterator it = _chunks.find( MemoryChunk( chunk->getHostAddress(), chunk->getSize() ) );
+         if ( it == _chunks.end() || it->second != chunk || it->first.getLength() != allocSize ) {
+            lruUnlink( chunk );
+            continue;
+         }
+         allocChunkPtrPtr = &(it->second);
+         break;
       }
-      count++;
-   }
-   if ( chunkToReusePtr == NULL ) {
-      if ( chunkToReuseNoLruPtr != NULL ) {
-         //*myThread->_file << "LRU clean chunk"<< std::endl;
-         chunkToReusePtr = chunkToReuseNoLruPtr;
-         done = true;
-         it = itNoLru;
-         increaseLruTime();
-      } else if ( chunkToReuseDirtyPtr != NULL ) {
-         //*myThread->_file << "Dirty chunk"<< std::endl;
-         chunkToReusePtr = chunkToReuseDirtyPtr;
-         it = itDirty;
-         done = true;
-      } else if ( chunkToReuseDirtyNoLruPtr != NULL ) {
-         //*myThread->_file << "LRU Dirty chunk"<< std::endl;
-         chunkToReusePtr = chunkToReuseDirtyNoLruPtr;
-         it = itDirtyNoLru;
-         done = true;
-         increaseLruTime();
-      }
-   } else {
-      //*myThread->_file << "clean chunk"<< std::endl;
    }
-   if ( done ) {
-      allocChunkPtrPtr = chunkToReusePtr;
-      if ( _VERBOSE_CACHE ) { fprintf(stderr, "[%s] Thd %d Im cache with id %d, I've found a chunk to free, %p (locked? %d) region %d addr=%p size=%zu\n",  __FUNCTION__, myThread->getId(), _memorySpaceId, *allocChunkPtrPtr, ((*allocChunkPtrPtr)->locked()?1:0), (*allocChunkPtrPtr)->getAllocatedRegion().id, (void*)it->first.getAddress(), it->first.getLength()); }
-      //(*allocChunkPtrPtr)->lock();
-   } else {
-      // if ( VERBOSE_INVAL ) {
-      //    count = 0;
-      //    for ( it = _chunks.begin(); it != _chunks.end() && !done; it++ ) {
-      //       if ( it->second == NULL ) *myThread->_file << "["<< count << "] this chunk: null chunk" << std::endl;
-      //       else *myThread->_file << "["<< count << "] this chunk: " << ((void *) it->second) << " refs " <<  it->second->getReferenceCount() << " size is " << it->second->getSize() << " vs " << allocSize << " " << " dirty? " << it->second->isDirty() << std::endl;
-      //       count++;
-      //    }
-      // }
-      //fatal("IVE _not_ FOUND A CHUNK TO FREE");
-      allocChunkPtrPtr = NULL;
+
+   if ( allocChunkPtrPtr != NULL && _VERBOSE_CACHE ) {
+      fprintf(stderr, "[%s] Thd %d Im cache with id %d, I've found a chunk to free, %p (locked? %d) region %d size=%zu\n",  __FUNCTION__, myThread->getId(), _memorySpaceId, *allocChunkPtrPtr, ((*allocChunkPtrPtr)->locked()?1:0), (*allocChunkPtrPtr)->getAllocatedRegion().id, allocSize);
    }
    return allocChunkPtrPtr;
 }
@@ -1071,6 +1064,7 @@ AllocatedChunk *RegionCache::invalidate( LockedObjects &srcRegions, Invalidation
 
    allocChunkPtrPtr = selectChunkToInvalidate( allocatedRegion.getDataSize() );
    if ( allocChunkPtrPtr != NULL ) {
+      _indexedEvictions++;
       allocChunkPtr = *allocChunkPtrPtr;
       invalControl._invalOps = NEW SeparateAddressSpaceOutOps( myThread->runningOn(), true, true );
       invalControl._chunksToInval.insert( std::make_pair( allocChunkPtrPtr, allocChunkPtr ) );
@@ -1096,6 +1090,7 @@ AllocatedChunk *RegionCache::invalidate( LockedObjects &srcRegions, Invalidation
          //*(myThread->_file) << "[" << myThread->getId() << "] multi chunk invalidation test:  memspace=" << _memorySpaceId <<", neededSize="<< allocatedRegion.getDataSize() << ", wd="<< wd.getId() << " ["<< (wd.getDescription() != NULL ? wd.getDescription() : "no description") << "], copyIdx="<< copyIdx << std::endl;
       //try to invalidate a set of chunks
       unsigned int other_referenced_chunks = 0;
+      _scannedEvictions++;
       selectChunksToInvalidate( allocatedRegion.getDataSize(), invalControl._chunksToInval, wd, other_referenced_chunks );
       if ( invalControl._chunksToInval.empty() ) {
          if ( other_referenced_chunks == 0 ) {
@@ -1358,7 +1353,6 @@ RegionCache::RegionCache( memory_space_id_t memSpaceId, Device &cacheArch, enum
    _memorySpaceId( memSpaceId ),
    _flags( flags ),
    _slabSize( slabSize ),
-   _lruTime( 0 ),
    _softInvalidationCount( 0 ),
    _hardInvalidationCount( 0 ),
    _inBytes( 0 ),
@@ -1370,6 +1364,10 @@ RegionCache::RegionCache( memory_space_id_t memSpaceId, Device &cacheArch, enum
    _mapVersionRequested( 0 ),
    _currentAllocations( 0 ),
    _allocatedBytes( 0 ),
+   _evictionIndex(),
+   _evictionLock(),
+   _indexedEvictions( 0 ),
+   _scannedEvictions( 0 ),
     _copyInObj( *this ), _copyOutObj( *this ) 
    {
    // FIXME : improve flags propagation from system/plugins to cache.
@@ -44,7 +44,9 @@ inline std::size_t AllocatedChunk::getSize() const {
 }
 
 inline void AllocatedChunk::addReference( WD const &wd, unsigned int loc ) {
-   _refs++;
+   if ( _refs++ == 0 ) {
+      _owner.removeEvictionCandidate( this );
+   }
    _refWdId[&wd]++;
    _refLoc[wd.getId()].insert(loc);
    //std::cerr << "add ref to chunk "<< (void*)this << " " << _refs.value() << std::endl;
@@ -55,11 +57,13 @@ inline void AllocatedChunk::removeReference( WD const &wd ) {
    if ( _refs == 0 ) {
       *myThread->_file << " removeReference ON A CHUNK WITH 0 REFS!!!" << std::endl;
    }
-   _refs--;
    _refWdId[&wd]--;
    if ( _refWdId[&wd] == 0 ) {
       _refLoc[wd.getId()].clear();
    }
+   if ( --_refs == 0 ) {
+      _owner.addEvictionCandidate( this );
+   }
    
    //std::cerr << "del ref to chunk "<< (void*)this << " " << _refs.value() << std::endl;
    //if ( _refs == (unsigned int) -1 ) {
@@ -76,14 +80,6 @@ inline bool AllocatedChunk::isDirty() const {
    return _dirty;
 }
 
-inline unsigned int AllocatedChunk::getLruStamp() const {
-   return _lruStamp;
-}
-
-inline void AllocatedChunk::increaseLruStamp() {
-   _lruStamp += 1;
-}
-
 inline global_reg_t AllocatedChunk::getAllocatedRegion() const {
    return _allocatedRegion;
 }
@@ -100,14 +96,6 @@ inline bool RegionCache::canCopyFrom( RegionCache const &from ) const {
    return _device == from._device;
 }
 
-inline unsigned int RegionCache::getLruTime() const {
-   return _lruTime;
-}
-
-inline void RegionCache::increaseLruTime() {
-   _lruTime += 1;
-}
-
 inline unsigned int RegionCache::getSoftInvalidationCount() const {
    return _softInvalidationCount.value();
 }
@@ -124,6 +112,14 @@ inline void RegionCache::increaseHardInvalidationCount(unsigned int v) {
    _hardInvalidationCount += v;
 }
 
+inline unsigned int RegionCache::getIndexedEvictionCount() const {
+   return _indexedEvictions.value();
+}
+
+inline unsigned int RegionCache::getScannedEvictionCount() const {
+   return _scannedEvictions.value();
+}
+
 inline void RegionCache::increaseTransferredInData(size_t bytes) {
    _inBytes += bytes;
 
@@ -51,7 +51,17 @@ namespace nanos {
       void releaseLockedObjects();
    };
 
+   class AllocatedChunk;
+
+   /*! \brief Unreferenced chunks of a cache, from the least to the most recently released */
+   struct AllocatedChunkLruList {
+      AllocatedChunk *_head;
+      AllocatedChunk *_tail;
+      AllocatedChunkLruList() : _head( NULL ), _tail( NULL ) {}
+   };
+
    class AllocatedChunk {
+      friend class RegionCache;
       private:
          RegionCache                      &_owner;
          RecursiveLock                     _lock;
@@ -60,12 +70,14 @@ namespace nanos {
          std::size_t                       _size;
          bool                              _dirty;
          bool                              _rooted;
-         unsigned int                      _lruStamp;
          Atomic<unsigned int>              _refs;
          std::map<WD const *, unsigned int>      _refWdId;
          std::map<int, std::set<int> >     _refLoc;
          global_reg_t                      _allocatedRegion;
          bool                              _flushable;
+         AllocatedChunk                   *_lruPrev;  /**< Previous chunk in the eviction list (less recently used) */
+         AllocatedChunk                   *_lruNext;  /**< Next chunk in the eviction list (more recently used) */
+         AllocatedChunkLruList            *_lruList;  /**< Eviction list this chunk is linked in, NULL if none */
          
          CacheRegionDictionary *_newRegions;
 
@@ -79,8 +91,6 @@ namespace nanos {
          uint64_t getHostAddress() const;
          std::size_t getSize() const;
          bool isDirty() const;
-         unsigned int getLruStamp() const;
-         void increaseLruStamp();
          void setHostAddress( uint64_t addr );
 
          void clearRegions();
@@ -130,7 +140,6 @@ namespace nanos {
          memory_space_id_t          _memorySpaceId;
          CacheOptions               _flags;
          std::size_t                _slabSize;
-         unsigned int               _lruTime;
          Atomic<unsigned int>       _softInvalidationCount;
          Atomic<unsigned int>       _hardInvalidationCount;
          Atomic<std::size_t>        _inBytes;
@@ -146,6 +155,22 @@ namespace nanos {
          typedef MemoryMap<AllocatedChunk>::MemChunkList ChunkList;
          typedef MemoryMap<AllocatedChunk>::ConstMemChunkList ConstChunkList;
 
+         /*! \brief Eviction candidates of a given size */
+         struct EvictionBucket {
+            AllocatedChunkLruList _clean;
+            AllocatedChunkLruList _dirty;
+         };
+
+         typedef std::map< std::size_t, EvictionBucket > EvictionIndex;
+
+         EvictionIndex              _evictionIndex;       /**< Unreferenced chunks by size, guarded by _evictionLock */
+         Lock                       _evictionLock;
+         Atomic<unsigned int>       _indexedEvictions;    /**< Victims found in the eviction index */
+         Atomic<unsigned int>       _scannedEvictions;    /**< Victims searched scanning all the chunks */
+
+         static void lruLink( AllocatedChunkLruList &list, AllocatedChunk *chunk );
+         static void lruUnlink( AllocatedChunk *chunk );
+
          class Op {
                RegionCache &_parent;
                std::string _name;
@@ -210,8 +235,10 @@ namespace nanos {
          bool canCopyFrom( RegionCache const &from ) const;
          Device const &getDevice() const;
          unsigned int getNodeNumber() const;
-         unsigned int getLruTime() const;
-         void increaseLruTime();
+         /*! \brief Makes an unreferenced chunk the most recently used eviction candidate of its size */
+         void addEvictionCandidate( AllocatedChunk *chunk );
+         /*! \brief Removes a chunk from the eviction candidates (it has been referenced or is being deleted) */
+         void removeEvictionCandidate( AllocatedChunk *chunk );
 
          unsigned int getVersion( global_reg_t const &hostMem, WD const &wd, unsigned int copyIdx );
          //void releaseRegion( global_reg_t const &hostMem, WD const &wd, unsigned int copyIdx, enum CachePolicy policy );
@@ -224,6 +251,8 @@ namespace nanos {
          void increaseSoftInvalidationCount(unsigned int v);
          unsigned int getHardInvalidationCount() const;
          void increaseHardInvalidationCount(unsigned int v);
+         unsigned int getIndexedEvictionCount() const;
+         unsigned int getScannedEvictionCount() const;
          bool canAllocateMemory( MemCacheCopy *memCopies, unsigned int numCopies, bool considerInvalidations, WD const &wd );
          bool canInvalidateToFit( std::size_t *sizes, unsigned int numChunks ) const;
          std::size_t getAllocatableSize( global_reg_t const &reg ) const;
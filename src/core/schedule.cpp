@@ -28,6 +28,7 @@
 #include "instrumentationmodule_decl.hpp"
 #include "os.hpp"
 #include "wddeque.hpp"
+#include "chunkpool.hpp"
 #include "smpthread.hpp"
 #include "nanos-int.h"
 
@@ -82,6 +83,7 @@ void Scheduler::_submit ( WD &wd, bool force_queue )
       } else {
          wd_tiedto->getTeam()->getSchedulePolicy().queue( wd_tiedto, wd );
       }
+      sys.getThreadManager()->wakeOne( wd_tiedto );
       return;
    }
 
@@ -100,6 +102,7 @@ void Scheduler::_submit ( WD &wd, bool force_queue )
       * it in our scheduler system. Global ready task queue will take care about task/thread
       * architecture, while local ready task queue will wait until stealing. */
       mythread->getTeam()->getSchedulePolicy().queue( mythread, wd );
+      thread_manager->wakeOne( mythread );
 
       return;
    }
@@ -118,6 +121,9 @@ void Scheduler::_submit ( WD &wd, bool force_queue )
    // And go on
    WD *next = getMyThreadSafe()->getTeam()->getSchedulePolicy().atSubmit( myThread, wd );
 
+   /* Either the task or the current one are now queued: let a parked thread pick it up */
+   thread_manager->wakeOne( mythread );
+
    /* If SchedulePolicy have returned a 'next' value, we have to context switch to
       that WorkDescriptor */
    if ( next ) {
@@ -177,6 +183,7 @@ void Scheduler::_submit ( WD ** wds, size_t numElems )
    
    // Call the scheduling policy
    mythread->getTeam()->getSchedulePolicy().queue( threadList, wds, numElems );
+   sys.getThreadManager()->wakeOne( mythread );
    
    // Release
    delete[] threadList;
@@ -257,8 +264,11 @@ inline void Scheduler::idleLoop ()
    ThreadManager *const thread_manager = sys.getThreadManager();
 
    WD *current = myThread->getCurrentWD();
+   // Publish our pending counter updates before idling, other threads may be waiting on them
+   sys.getSchedulerStats().flush();
    sys.getSchedulerStats()._idleThreads++;
    myThread->setIdle( true );
+   thread_manager->idleStart( myThread );
 
    for ( ; ; ) {
       BaseThread *thread = getMyThreadSafe();
@@ -327,7 +337,7 @@ inline void Scheduler::idleLoop ()
 
       if ( !next && thread->getTeam() != NULL ) {
          memoryFence();
-         if ( sys.getSchedulerStats()._readyTasks > 0 ) {
+         if ( sys.getSchedulerStats().hasReadyTasks() ) {
             NANOS_INSTRUMENT ( total_scheds++; )
             NANOS_INSTRUMENT ( unsigned long long begin_sched = (unsigned long long) ( OS::getMonotonicTime() * 1.0e9  ); )
             
@@ -373,14 +383,17 @@ inline void Scheduler::idleLoop ()
 
          thread->setIdle( false );
          sys.getSchedulerStats()._idleThreads--;
+         thread_manager->idleEnd( thread );
 
          behaviour::switchWD(thread, current, next);
 
          thread = getMyThreadSafe();
          thread->step();
 
+         sys.getSchedulerStats().flush();
          sys.getSchedulerStats()._idleThreads++;
          thread->setIdle( true );
+         thread_manager->idleStart( thread );
 
          NANOS_INSTRUMENT (total_spins = 0; )
          NANOS_INSTRUMENT (total_blocks = 0; )
@@ -465,7 +478,7 @@ void Scheduler::waitOnCondition (GenericSyncCond *condition)
                //! Second calling scheduler policy at block
                if ( !next ) {
                   memoryFence();
-                  if ( sys.getSchedulerStats()._readyTasks > 0 ) {
+                  if ( sys.getSchedulerStats().hasReadyTasks() ) {
                      if ( sys.getSchedulerConf().getSchedulerEnabled() )
                         next = thread->getTeam()->getSchedulePolicy().atBlock( thread, current );
             if ( next != NULL ) {
@@ -535,6 +548,7 @@ void Scheduler::wakeUp ( WD *wd )
 
          ensure( myTeam, "Trying to wake up a WD from a thread without team." );
          next = myTeam->getSchedulePolicy().atWakeUp( myThread, *wd );
+         sys.getThreadManager()->wakeOne( thread );
       }
 
       /* If SchedulePolicy have returned a 'next' value, we have to context switch to
@@ -599,7 +613,7 @@ struct AsyncWorkerBehaviour
          // do not prefetch at this point, as the thread will be always prefetching
          if ( Scheduler::inlineWorkAsync ( next, /* schedule */ false ) ) {
             next->~WorkDescriptor();
-            delete[] ( char * ) next;
+            ChunkPool::deallocate( next );
          }
       }
    }
@@ -922,6 +936,7 @@ void Scheduler::switchHelper (WD *oldWD, WD *newWD, void *arg)
       syncCond->unlock();
    } else if ( &(myThread->getThreadWD()) != oldWD ) {
       myThread->getTeam()->getSchedulePolicy().queue( myThread, *oldWD );
+      sys.getThreadManager()->wakeOne( myThread );
    }
    myThread->setCurrentWD( *newWD );
 }
@@ -960,7 +975,7 @@ void Scheduler::switchTo ( WD *to )
    } else {
       if (inlineWork(to, /*schedule*/ true)) {
          to->~WorkDescriptor();
-         delete[] (char *)to;
+         ChunkPool::deallocate( to );
       }
    }
 }
@@ -997,7 +1012,7 @@ void Scheduler::exitHelper (WD *oldWD, WD *newWD, void *arg)
     myThread->exitHelperDependent(oldWD, newWD, arg);
     myThread->setCurrentWD( *newWD );
     oldWD->~WorkDescriptor();
-    delete[] (char *)oldWD;
+    ChunkPool::deallocate( oldWD );
 }
 
 struct ExitBehaviour
@@ -1015,7 +1030,7 @@ struct ExitBehaviour
       else {
         if ( Scheduler::inlineWork ( next /*jb merge */, /*schedule*/ true ) ) {
           next->~WorkDescriptor();
-          delete[] (char *)next;
+          ChunkPool::deallocate( next );
         }
       }
    }
@@ -25,6 +25,7 @@
 #include <algorithm>
 
 #include "atomic.hpp"
+#include "shardedcounter.hpp"
 #include "synchronizedcondition_fwd.hpp"
 
 #include "schedule_decl.hpp"
@@ -169,7 +170,7 @@ inline bool SchedulePolicy::testDequeue()
 {
    // If a Scheduler does not define this method, we assume
    // that a WD can be pulled if the _readyTasks value is positive
-   return sys.getReadyNum() > 0;
+   return sys.getSchedulerStats().hasReadyTasks();
 }
 
 inline void SchedulePolicySuccessorFunctor::operator() ( DependableObject *predecessor, DependableObject *successor )
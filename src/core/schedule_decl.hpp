@@ -30,6 +30,7 @@
 
 #include "workdescriptor_decl.hpp"
 #include "atomic_decl.hpp"
+#include "shardedcounter_decl.hpp"
 #include "functors_decl.hpp"
 #include "basethread_decl.hpp"
 
@@ -137,6 +138,7 @@ namespace nanos {
    {
          friend class WDDeque;
          friend class WDLFQueue;
+         friend class WDWorkStealingDeque;
          friend class WDPriorityQueue<WD::PriorityType>;
          friend class WDPriorityQueue<double>;
          friend class Scheduler;
@@ -148,10 +150,12 @@ namespace nanos {
          friend class SlicerRepeatN;
          friend class SlicerCompoundWD;
       private:
-         Atomic<int>          _createdTasks;
-         Atomic<int>          _readyTasks;
+         // Task counters are updated on every creation, submission and completion: they are
+         // sharded per thread (see ShardedCounter) and read through approximate() on hot paths
+         ShardedCounter       _createdTasks;
+         ShardedCounter       _readyTasks;
          Atomic<int>          _idleThreads;
-         Atomic<int>          _totalTasks;
+         ShardedCounter       _totalTasks;
       private:
          /*! \brief SchedulerStats copy constructor (private)
           */
@@ -167,18 +171,32 @@ namespace nanos {
           */
          ~SchedulerStats () {}
 
+         //! \brief Exact values (sum of all the per-thread shards)
          int getCreatedTasks();
          int getReadyTasks();
-#ifdef HAVE_NEW_GCC_ATOMIC_OPS
-         int * getReadyTasksAddr( void ) { return &_readyTasks.override(); }
-#else
-         volatile int * getReadyTasksAddr( void ) { return &_readyTasks.override(); }
-#endif
          int getTotalTasks();
+
+         //! \brief Approximate values (published part only, a single load)
+         int getApproxReadyTasks() const { return _readyTasks.approximate(); }
+         int getApproxTotalTasks() const { return _totalTasks.approximate(); }
+
+         /*! \brief Returns whether there may be ready tasks
+          *
+          *  Only pays for the exact read when the approximate value says there are none,
+          *  so that pending updates of busy threads are not missed by idle ones.
+          */
+         bool hasReadyTasks() const { return _readyTasks.approximate() > 0 || _readyTasks.value() > 0; }
+
+         //! \brief Publishes the pending counter updates of the calling thread
+         void flush() { _createdTasks.flush(); _readyTasks.flush(); _totalTasks.flush(); }
+
+         //! \brief Addresses of the published (approximate) values, for condition checkers
 #ifdef HAVE_NEW_GCC_ATOMIC_OPS
-         int * getTotalTasksAddr( void ) { return &_totalTasks.override(); }
+         int * getReadyTasksAddr( void ) { return _readyTasks.getApproximateAddr(); }
+         int * getTotalTasksAddr( void ) { return _totalTasks.getApproximateAddr(); }
 #else
-         volatile int * getTotalTasksAddr( void ) { return &_totalTasks.override(); }
+         volatile int * getReadyTasksAddr( void ) { return _readyTasks.getApproximateAddr(); }
+         volatile int * getTotalTasksAddr( void ) { return _totalTasks.getApproximateAddr(); }
 #endif
    };
 
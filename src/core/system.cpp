@@ -22,6 +22,7 @@
 #include <signal.h>
 #include <set>
 #include <climits>
+#include <iomanip>
 
 #include "atomic.hpp"
 #include "system.hpp"
@@ -37,6 +38,7 @@
 #include "processingelement.hpp"
 #include "basethread.hpp"
 #include "allocator.hpp"
+#include "chunkpool.hpp"
 #include "debug.hpp"
 #include "smpthread.hpp"
 #include "regiondict.hpp"
@@ -681,7 +683,7 @@ void System::finish ()
    verbose ( "...thread has been joined" );
 
 
-   ensure( _schedStats._readyTasks == 0, "Ready task counter has an invalid value!");
+   ensure( _schedStats._readyTasks.value() == 0, "Ready task counter has an invalid value!");
 
    verbose ( "NANOS++ statistics");
    verbose ( std::dec << (unsigned int) getCreatedTasks() << " tasks has been executed" );
@@ -887,7 +889,7 @@ void System::createWD ( WD **uwd, size_t num_devices, nanos_device_t *devices, s
       total_size = NANOS_ALIGNED_MEMORY_OFFSET(offset_PMD,size_PMD,1);
    }
 
-   chunk = NEW char[total_size];
+   chunk = (char *) ChunkPool::allocate( total_size );
    if ( props != NULL ) {
       if (props->clear_chunk)
           memset(chunk, 0, sizeof(char) * total_size);
@@ -1060,7 +1062,7 @@ void System::duplicateWD ( WD **uwd, WD *wd)
       total_size = NANOS_ALIGNED_MEMORY_OFFSET(offset_PMD,size_PMD,1);
    }
 
-   chunk = NEW char[total_size];
+   chunk = (char *) ChunkPool::allocate( total_size );
 
    // allocating WD and DATA; if size_Data == 0 data keep the NULL value
    if ( *uwd == NULL ) *uwd = (WD *) chunk;
@@ -1420,6 +1422,12 @@ void System::executionSummary()
    output << "==========================================================" << std::endl;
    output << "=== Application ended in " << seconds << " seconds" << std::endl;
    output << "=== " << getCreatedTasks() << " tasks have been executed" << std::endl;
+   if ( _net.getAggregatedFramesCount() > 0 ) {
+      output << "=== " << _net.getAggregatedMessagesCount() << " cluster messages sent in "
+         << _net.getAggregatedFramesCount() << " frames ("
+         << std::setprecision( 3 ) << ( (double) _net.getAggregatedMessagesCount() / _net.getAggregatedFramesCount() )
+         << " messages per frame)" << std::endl;
+   }
    output << "==========================================================" << std::endl;
    message0( output.str() );
 }
@@ -1738,13 +1746,13 @@ void System::preSchedule() {
                   sit != it->second.end(); sit++ ) {
                WD *wd = *sit;
                memory_space_id_t target_loc = (memory_space_id_t) -1;
-               if ( !wd->_schedPredecessorLocs.empty() ) {
+               if ( !wd->getSchedPredecessorLocs().empty() ) {
                   //FIXME: elaborate
-                  std::map<memory_space_id_t, unsigned int>::const_iterator it2 = (*sit)->_schedPredecessorLocs.begin();
+                  std::map<memory_space_id_t, unsigned int>::const_iterator it2 = (*sit)->getSchedPredecessorLocs().begin();
                   memory_space_id_t selected = it2->first;
                   unsigned int max_count = it2->second;
                   it2++;
-                  while ( it2 != (*sit)->_schedPredecessorLocs.end() ) {
+                  while ( it2 != (*sit)->getSchedPredecessorLocs().end() ) {
                      if ( it2->second > max_count ) {
                         selected = it2->first;
                      }
@@ -1763,7 +1771,7 @@ void System::preSchedule() {
                (*this_slot_memspace_usage_sets[ target_loc ])[criticality].insert( wd );
                this_slot_memspace_usage[ target_loc ] += 1;
                max_wd_count = this_slot_memspace_usage[ target_loc ] > (int)max_wd_count ? this_slot_memspace_usage[ target_loc ] : max_wd_count;
-               wd->_schedValues[0] = target_loc;
+               wd->getSchedValues()[0] = target_loc;
             }
 
             /* balance */
@@ -1797,16 +1805,16 @@ void System::preSchedule() {
                            sit != this_slot_memspace_usage_sets[ idx ]->rend() && rebalance_wds > 0; sit++ ) {
                         for (std::set<WD *>::const_iterator isit = sit->second.begin(); isit != sit->second.end() && rebalance_wds > 0; isit++ ) {
                            unsigned int start_idx = (idx + 1) % (max_mem_id + 1);
-                           memory_space_id_t found_loc = (*isit)->_schedValues[0];
-                           memory_space_id_t initial_loc = (*isit)->_schedValues[0];
+                           memory_space_id_t found_loc = (*isit)->getSchedValues()[0];
+                           memory_space_id_t initial_loc = (*isit)->getSchedValues()[0];
 
                            for ( memory_space_id_t search_idx = start_idx; search_idx != initial_loc && found_loc == initial_loc; search_idx = (search_idx + 1) % (max_mem_id + 1)) {
                               if ( this_slot_memspace_usage[ search_idx ] > -1 && this_slot_memspace_usage[ search_idx ] < num_wds_per_memspace + 1 ) {
                                  found_loc = search_idx;
                               }
                            }
-                           (*isit)->_schedValues[0] = found_loc;
-                           (*isit)->_schedValues[1] = 0;
+                           (*isit)->getSchedValues()[0] = found_loc;
+                           (*isit)->getSchedValues()[1] = 0;
                            std::cerr << "SET SCHED LOC " << found_loc << " FOR WD " << (*isit)->getId() << " this idx " << idx << std::endl;
                            rebalance_wds -= 1;
                            this_slot_memspace_usage[ idx ] -= 1;
@@ -1833,7 +1841,7 @@ void System::preSchedule() {
             for (DependableObject::DependableObjectVector::const_iterator pit = d->getPredecessors().begin();
                   pit != d->getPredecessors().end(); pit++ ) {
                WD *predecessor_wd = pit->second->getWD();
-               predecessor_wd->_schedPredecessorLocs[ wd->_schedValues[0] ] += 1;
+               predecessor_wd->getSchedPredecessorLocs()[ wd->getSchedValues()[0] ] += 1;
             }
          }
 
@@ -1844,8 +1852,8 @@ void System::preSchedule() {
          std::cerr << "["<< it->first << "]: ";
          for ( std::set< WD * >::const_iterator sit = it->second.begin();
                sit != it->second.end(); sit++ ) {
-            std::cerr << "[" << (*sit)->getId() /* << ", " << (*sit)->getDOSubmit()->getNum() << ", " << (*sit)->getDOSubmit()->getLSS() << " /" */<< " " << (*sit)->_schedValues[0] << ( (*sit)->_schedValues[1] == 0 ? "*" : "" ) << " { ";
-            for (std::map<memory_space_id_t, unsigned int>::const_iterator it2 = (*sit)->_schedPredecessorLocs.begin(); it2 != (*sit)->_schedPredecessorLocs.end(); it2++)
+            std::cerr << "[" << (*sit)->getId() /* << ", " << (*sit)->getDOSubmit()->getNum() << ", " << (*sit)->getDOSubmit()->getLSS() << " /" */<< " " << (*sit)->getSchedValues()[0] << ( (*sit)->getSchedValues()[1] == 0 ? "*" : "" ) << " { ";
+            for (std::map<memory_space_id_t, unsigned int>::const_iterator it2 = (*sit)->getSchedPredecessorLocs().begin(); it2 != (*sit)->getSchedPredecessorLocs().end(); it2++)
                std::cerr << it2->first << "," << it2->second << " ";
             std::cerr << "}] ";
          }
@@ -1861,7 +1869,7 @@ void System::preSchedule() {
             WD *wd = *sit;
             wd->setPriority( this_level_prio );
             if ( sys.getNetwork()->getNodeNum() == 0 ) {
-               wd->tieToLocation( wd->_schedValues[0] );
+               wd->tieToLocation( wd->getSchedValues()[0] );
             }
             this_level_count += 1;
          }
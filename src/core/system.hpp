@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include "schedule_decl.hpp"
+#include "shardedcounter.hpp"
 #include "threadteam.hpp"
 #include "slicer.hpp"
 #include "nanos-int.h"
@@ -71,9 +72,9 @@ inline bool System::getDelayedStart () const { return _delayedStart; }
 
 inline int System::getCreatedTasks() const { return _schedStats._createdTasks.value(); }
 
-inline int System::getTaskNum() const { return _schedStats._totalTasks.value(); }
+inline int System::getTaskNum() const { return _schedStats._totalTasks.approximate(); }
 
-inline int System::getReadyNum() const { return _schedStats._readyTasks.value(); }
+inline int System::getReadyNum() const { return _schedStats._readyTasks.approximate(); }
 
 inline int System::getIdleNum() const { return _schedStats._idleThreads.value(); }
 
@@ -344,10 +344,12 @@ namespace nanos {
 
          int getCreatedTasks() const ;
 
+         //! \brief Approximate number of tasks (see SchedulerStats for the exact values)
          int getTaskNum() const;
 
          int getIdleNum() const;
 
+         //! \brief Approximate number of ready tasks (see SchedulerStats for the exact values)
          int getReadyNum() const;
 
          int getRunningTasks() const;
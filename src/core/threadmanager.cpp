@@ -31,7 +31,8 @@
 using namespace nanos;
 
 ThreadManager::ThreadManager( bool warmup, bool tie_master, unsigned int num_yields,
-      unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb ) :
+      unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb,
+      bool use_park, unsigned int park_timeout, unsigned int park_max_spin ) :
    _lock(),
    _initialized( false ),
    _maxThreads(),
@@ -43,7 +44,11 @@ ThreadManager::ThreadManager( bool warmup, bool tie_master, unsigned int num_yie
    _sleepTime( sleep_time ),
    _useSleep( use_sleep ),
    _useBlock( use_block ),
-   _useDLB( use_dlb )
+   _useDLB( use_dlb ),
+   _usePark( use_park ),
+   _parkTimeout( park_timeout ),
+   _parkMaxSpin( park_max_spin ),
+   _numParked( 0 )
 {
 }
 
@@ -75,7 +80,7 @@ void ThreadManager::init()
 #endif
 
    // Consider TM not initialized if there isn't any related flag
-   _initialized = _useSleep || _useBlock || _useDLB;
+   _initialized = _useSleep || _useBlock || _useDLB || _usePark;
 }
 
 bool ThreadManager::isGreedy()
@@ -123,6 +128,31 @@ void ThreadManager::idle( int& yields
 
    BaseThread *thread = getMyThreadSafe();
 
+   if ( _usePark ) {
+      //! \note Keep polling while the current idle period is expected to end soon, that is,
+      //!       while it is shorter than twice the usual one. Threads whose idle periods are
+      //!       usually longer than the maximum spin time park right away.
+      double idle_time = OS::getMonotonicTime() - thread->getIdleSince();
+      double estimate = thread->getIdleEstimate();
+      double max_spin = (double) _parkMaxSpin * 1e-9;
+      double spin = estimate < max_spin ? std::min( 2.0 * estimate, max_spin ) : 0.0;
+
+      if ( idle_time < spin || !thread->isRunning() ) {
+         thread->yield();
+      } else {
+#ifdef NANOS_INSTRUMENTATION_ENABLED
+         total_blocks++;
+         double begin_block = OS::getMonotonicTime();
+#endif
+         park( thread );
+#ifdef NANOS_INSTRUMENTATION_ENABLED
+         double end_block = OS::getMonotonicTime();
+         time_blocks += (unsigned long long) ( (end_block - begin_block) * 1e9 );
+#endif
+      }
+      return;
+   }
+
    if ( yields > 0 ) {
 #ifdef NANOS_INSTRUMENTATION_ENABLED
       total_yields++;
@@ -152,6 +182,76 @@ void ThreadManager::idle( int& yields
    }
 }
 
+void ThreadManager::idleStart( BaseThread *thread )
+{
+   if ( !_usePark ) return;
+   thread->setIdleSince( OS::getMonotonicTime() );
+}
+
+void ThreadManager::idleEnd( BaseThread *thread )
+{
+   if ( !_usePark ) return;
+
+   //! \note Exponential moving average (1/8 weight) of the idle period length
+   double idle_time = OS::getMonotonicTime() - thread->getIdleSince();
+   double estimate = thread->getIdleEstimate();
+   thread->setIdleEstimate( estimate + ( idle_time - estimate ) / 8.0 );
+}
+
+void ThreadManager::park( BaseThread *thread )
+{
+   Atomic<int> &word = thread->getParkWord();
+
+   word = 1;
+   _numParked++;
+   memoryFence();
+
+   //! \note Re-check for work once visible as parked: a producer either sees us parked
+   //!       or we see its work. The timeout bounds the latency of any other wake-up source
+   //!       (e.g. dependences released by remote nodes, shutdown).
+   if ( !sys.getSchedulerStats().hasReadyTasks() && !thread->hasNextWD() && thread->isRunning() ) {
+      OS::futexWait( (int *) &word.override(), 1, _parkTimeout );
+   }
+
+   word = 0;
+   _numParked--;
+}
+
+void ThreadManager::wakeOneParked( BaseThread *target )
+{
+   //! \note Pairs with the fence in park(): the work has been published before this point
+   memoryFence();
+   if ( _numParked.value() == 0 ) return;
+
+   //! \note Prefer the target thread itself (its queue got the work), then a thread in the
+   //!       same NUMA node, then any parked thread of the team
+   if ( target != NULL ) {
+      Atomic<int> &word = target->getParkWord();
+      if ( word.value() == 1 && word.cswap( 1, 0 ) ) {
+         OS::futexWake( (int *) &word.override(), 1 );
+         return;
+      }
+   }
+
+   ThreadTeam *team = target != NULL ? target->getTeam() : NULL;
+   if ( team == NULL ) return;
+
+   int node = target->runningOn()->getNumaNode();
+   unsigned int size = team->getFinalSize();
+   BaseThread *candidate = NULL;
+   for ( unsigned int i = 0; i < size; i++ ) {
+      BaseThread &thread = team->getThread( i );
+      if ( thread.getParkWord().value() != 1 ) continue;
+      candidate = &thread;
+      if ( thread.runningOn()->getNumaNode() == node ) break;
+   }
+
+   if ( candidate != NULL ) {
+      Atomic<int> &word = candidate->getParkWord();
+      if ( word.cswap( 1, 0 ) ) OS::futexWake( (int *) &word.override(), 1 );
+   }
+}
+
 void ThreadManager::blockThread( BaseThread *thread )
 {
    if ( !_initialized ) return;
@@ -358,6 +458,8 @@ void ThreadManager::poll()
 
 const unsigned int ThreadManagerConf::DEFAULT_SLEEP_NS = 20000;
 const unsigned int ThreadManagerConf::DEFAULT_YIELDS = 10;
+const unsigned int ThreadManagerConf::DEFAULT_PARK_TIMEOUT_NS = 1000000;
+const unsigned int ThreadManagerConf::DEFAULT_PARK_MAX_SPIN_NS = 100000;
 
 ThreadManagerConf::ThreadManagerConf() :
    _numYields( DEFAULT_YIELDS ),
@@ -366,7 +468,10 @@ ThreadManagerConf::ThreadManagerConf() :
    _useBlock( false ),
    _useDLB( false ),
    _forceTieMaster( false ),
-   _warmupThreads( false )
+   _warmupThreads( false ),
+   _usePark( false ),
+   _parkTimeout( DEFAULT_PARK_TIMEOUT_NS ),
+   _parkMaxSpin( DEFAULT_PARK_MAX_SPIN_NS )
 {
 }
 
@@ -398,6 +503,22 @@ void ThreadManagerConf::config( Config &cfg )
          "Tune Nanos Runtime to be used with Dynamic Load Balancing library" );
    cfg.registerArgOption( "enable-dlb", "enable-dlb" );
 
+   cfg.registerConfigOption( "enable-park", NEW Config::FlagOption( _usePark, true ),
+         "Adaptive spin-then-park of idle threads, woken up when new work is submitted" );
+   cfg.registerArgOption( "enable-park", "enable-park" );
+
+   std::ostringstream park_timeout_sstream;
+   park_timeout_sstream << "Set the maximum amount of time (in nsec) a thread stays parked (default = "
+      << DEFAULT_PARK_TIMEOUT_NS << ")";
+   cfg.registerConfigOption ( "park-timeout", NEW Config::UintVar( _parkTimeout ), park_timeout_sstream.str() );
+   cfg.registerArgOption ( "park-timeout", "park-timeout" );
+
+   std::ostringstream park_spin_sstream;
+   park_spin_sstream << "Set the maximum amount of time (in nsec) an idle thread polls before parking (default = "
+      << DEFAULT_PARK_MAX_SPIN_NS << ")";
+   cfg.registerConfigOption ( "park-max-spin", NEW Config::UintVar( _parkMaxSpin ), park_spin_sstream.str() );
+   cfg.registerArgOption ( "park-max-spin", "park-max-spin" );
+
    cfg.registerConfigOption( "force-tie-master", NEW Config::FlagOption ( _forceTieMaster ),
          "Force Master WD (user code) to run on Master Thread" );
    cfg.registerArgOption( "force-tie-master", "force-tie-master" );
@@ -423,6 +544,11 @@ ThreadManager* ThreadManagerConf::create()
       _useSleep = false;
    }
 
+   if ( _usePark && ( _useSleep || _useBlock ) ) {
+      warning0( "Option --enable-park is not compatible with --enable-sleep or --enable-block, disabling option." );
+      _usePark = false;
+   }
+
    return NEW ThreadManager( _warmupThreads, _forceTieMaster, _numYields,
-         _sleepTime, _useSleep, _useBlock, _useDLB );
+         _sleepTime, _useSleep, _useBlock, _useDLB, _usePark, _parkTimeout, _parkMaxSpin );
 }
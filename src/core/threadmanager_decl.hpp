@@ -42,10 +42,20 @@ class ThreadManager
       bool              _useSleep;
       bool              _useBlock;
       bool              _useDLB;
+      bool              _usePark;
+      unsigned int      _parkTimeout;        /* Max. time (ns) parked before polling again */
+      unsigned int      _parkMaxSpin;        /* Max. time (ns) polling before parking */
+      Atomic<int>       _numParked;          /* Number of threads currently parked */
+
+      //! \brief Parks the thread on its futex word until woken up or timed out
+      void park( BaseThread *thread );
+      //! \brief Wakes one parked thread, preferably target or one in its NUMA node
+      void wakeOneParked( BaseThread *target );
 
    public:
       ThreadManager( bool warmup, bool tie_master, unsigned int num_yields,
-            unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb );
+            unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb,
+            bool use_park, unsigned int park_timeout, unsigned int park_max_spin );
 
       ~ThreadManager();
 
@@ -58,6 +68,11 @@ class ThreadManager
             , unsigned long long& time_yields, unsigned long long& time_blocks
 #endif
             );
+      //! \brief Marks the beginning/end of an idle period of the thread (adaptive parking)
+      void idleStart( BaseThread *thread );
+      void idleEnd( BaseThread *thread );
+      //! \brief New work is available near target: wakes up one parked thread, if any
+      void wakeOne( BaseThread *target ) { if ( _usePark ) wakeOneParked( target ); }
       void blockThread( BaseThread *thread );
       void unblockThread( BaseThread *thread );
       void lendCpu( BaseThread *thread );
@@ -88,10 +103,15 @@ class ThreadManagerConf
       bool                 _useDLB;          //!< DLB library will be used
       bool                 _forceTieMaster;  //!< Force Master WD (user code) to run on Master Thread
       bool                 _warmupThreads;   //!< Force the initialization of as many threads as number of CPUs, then block them if needed
+      bool                 _usePark;         //!< Park idle threads on a futex, woken up when work is submitted
+      unsigned int         _parkTimeout;     //!< Number of nanoseconds a thread stays parked before polling again
+      unsigned int         _parkMaxSpin;     //!< Maximum number of nanoseconds a thread polls before parking
 
    public:
       static const unsigned int DEFAULT_SLEEP_NS;
       static const unsigned int DEFAULT_YIELDS;
+      static const unsigned int DEFAULT_PARK_TIMEOUT_NS;
+      static const unsigned int DEFAULT_PARK_MAX_SPIN_NS;
 
       ThreadManagerConf();
       unsigned int getNumYields ( void ) const { return _numYields; }
@@ -526,10 +526,455 @@ inline bool WDLFQueue::removeWD( BaseThread *thread, WorkDescriptor *toRem, Work
    return false;
 }
 
+/***********************
+ * WDWorkStealingDeque *
+ ***********************/
+
+inline WDWorkStealingDeque::WDArray::WDArray ( size_t size, WDArray *previous )
+   : _mask( size - 1 ), _slots( NEW WorkDescriptor * volatile[size] ), _previous( previous )
+{
+   for ( size_t i = 0; i < size; i++ ) _slots[i] = NULL;
+}
+
+inline WDWorkStealingDeque::WDArray::~WDArray ()
+{
+   delete[] _slots;
+}
+
+inline WDWorkStealingDeque::WDWorkStealingDeque( bool enableDeviceCounter, size_t initialSize )
+   : _top( 0 ), _bottom( 0 ), _array( NULL ), _owner( NULL ), _overflow(), _lock(), _nelems( 0 ),
+   _ndevs(), _deviceCounter( enableDeviceCounter )
+{
+   size_t size = 1;
+   while ( size < initialSize ) size <<= 1;
+   _array = NEW WDArray( size, NULL );
+
+   if ( _deviceCounter ) {
+      const DeviceList &devs = sys.getSupportedDevices();
+      for ( DeviceList::const_iterator it = devs.begin(); it != devs.end(); ++it ) {
+         _ndevs.insert( std::make_pair<const Device*, Atomic<unsigned int> >( *it, 0 ) );
+      }
+   }
+}
+
+inline WDWorkStealingDeque::~WDWorkStealingDeque()
+{
+   WDArray *array = _array;
+   while ( array != NULL ) {
+      WDArray *previous = array->getPrevious();
+      delete array;
+      array = previous;
+   }
+}
+
+inline bool WDWorkStealingDeque::empty ( void ) const
+{
+   return _bottom <= _top && _overflow.empty();
+}
+
+inline size_t WDWorkStealingDeque::size() const
+{
+   return _nelems.value();
+}
+
+inline void WDWorkStealingDeque::setOwner ( BaseThread *thread )
+{
+   _owner = thread;
+}
+
+inline bool WDWorkStealingDeque::isOwner ( void ) const
+{
+   return _owner != NULL && myThread == _owner;
+}
+
+inline WDWorkStealingDeque::WDArray * WDWorkStealingDeque::grow ( WDArray *array, long bottom, long top )
+{
+   WDArray *newArray = NEW WDArray( array->size() * 2, array );
+   for ( long i = top; i < bottom; i++ ) {
+      newArray->put( i, array->get( i ) );
+   }
+   memoryFence();
+   _array = newArray;
+
+   return newArray;
+}
+
+inline void WDWorkStealingDeque::pushBottom ( WorkDescriptor *wd )
+{
+   long bottom = _bottom;
+   long top = _top;
+   WDArray *array = _array;
+
+   if ( bottom - top >= (long) array->size() ) array = grow( array, bottom, top );
+
+   array->put( bottom, wd );
+   memoryFence();
+   _bottom = bottom + 1;
+}
+
+inline bool WDWorkStealingDeque::popBottom ( WorkDescriptor *&wd )
+{
+   long bottom = _bottom - 1;
+   WDArray *array = _array;
+   _bottom = bottom;
+   memoryFence();
+   long top = _top;
+
+   if ( top > bottom ) {
+      // Empty array, restore bottom
+      _bottom = top;
+      return false;
+   }
+
+   wd = array->get( bottom );
+   if ( top == bottom ) {
+      // Last element: race against thieves
+      if ( !compareAndSwap( (long *) &_top, top, top + 1 ) ) wd = NULL;
+      _bottom = top + 1;
+   }
+
+   return true;
+}
+
+inline bool WDWorkStealingDeque::popTop ( WorkDescriptor *&wd )
+{
+   while ( true ) {
+      long top = _top;
+      memoryFence();
+      long bottom = _bottom;
+
+      if ( top >= bottom ) return false;
+
+      WDArray *array = _array;
+      wd = array->get( top );
+      if ( compareAndSwap( (long *) &_top, top, top + 1 ) ) return true;
+   }
+}
+
+template <typename Constraints>
+inline WorkDescriptor * WDWorkStealingDeque::claim ( WorkDescriptor *wd, BaseThread const *thread )
+{
+   if ( wd == NULL ) return NULL;
+
+   wd->setMyQueue( NULL );
+
+   if ( Scheduler::checkBasicConstraints( *wd, *thread ) && Constraints::check( *wd, *thread ) ) {
+      decreaseDeviceCounter( wd );
+      int tasks = --( sys.getSchedulerStats()._readyTasks );
+      decreaseTasksInQueues( tasks );
+      return wd;
+   }
+
+   // This thread cannot run it: keep it in the queue, but out of the lock-free path
+   LockBlock lock( _lock );
+   pushOverflow( wd, false );
+   return NULL;
+}
+
+inline void WDWorkStealingDeque::pushOverflow ( WorkDescriptor *wd, bool front )
+{
+   wd->setMyQueue( this );
+   if ( front ) _overflow.push_front( wd );
+   else _overflow.push_back( wd );
+   memoryFence();
+}
+
+template <typename Constraints>
+inline WorkDescriptor * WDWorkStealingDeque::popOverflow ( BaseThread const *thread, bool front )
+{
+   WorkDescriptor *found = NULL;
+
+   if ( _overflow.empty() )
+      return NULL;
+
+   {
+      LockBlock lock( _lock );
+
+      memoryFence();
+
+      if ( front ) {
+         BaseContainer::iterator it;
+         for ( it = _overflow.begin(); it != _overflow.end(); it++ ) {
+            WD &wd = *(WD *)*it;
+            if ( Scheduler::checkBasicConstraints( wd, *thread ) && Constraints::check( wd, *thread ) ) {
+               if ( wd.dequeue( &found ) ) {
+                  _overflow.erase( it );
+                  decreaseDeviceCounter( found );
+                  int tasks = --( sys.getSchedulerStats()._readyTasks );
+                  decreaseTasksInQueues( tasks );
+               }
+               break;
+            }
+         }
+      } else {
+         BaseContainer::reverse_iterator rit;
+         for ( rit = _overflow.rbegin(); rit != _overflow.rend(); rit++ ) {
+            WD &wd = *(WD *)*rit;
+            if ( Scheduler::checkBasicConstraints( wd, *thread ) && Constraints::check( wd, *thread ) ) {
+               if ( wd.dequeue( &found ) ) {
+                  _overflow.erase( ( ++rit ).base() );
+                  decreaseDeviceCounter( found );
+                  int tasks = --( sys.getSchedulerStats()._readyTasks );
+                  decreaseTasksInQueues( tasks );
+               }
+               break;
+            }
+         }
+      }
+
+      if ( found != NULL ) found->setMyQueue( NULL );
+   }
+
+   return found;
+}
+
+inline bool WDWorkStealingDeque::hasTasksForThread ( BaseThread const *thread )
+{
+   if ( empty() ) return false;
+
+   if ( _deviceCounter ) {
+      std::vector<const Device *> const &pe_devices = thread->runningOn()->getDeviceTypes();
+      for ( std::vector<const Device *>::const_iterator it = pe_devices.begin(); it != pe_devices.end(); it++ ) {
+         if ( _ndevs[ *it ].value() > 0 ) return true;
+      }
+      return false;
+   }
+
+   return true;
+}
+
+inline void WDWorkStealingDeque::push_front ( WorkDescriptor *wd )
+{
+   increaseDeviceCounter( wd );
+   int tasks = ++( sys.getSchedulerStats()._readyTasks );
+   increaseTasksInQueues( tasks );
+
+   if ( isOwner() && !wd->isTied() && wd->getSlicer() == NULL ) {
+      wd->setMyQueue( this );
+      pushBottom( wd );
+   } else {
+      LockBlock lock( _lock );
+      pushOverflow( wd, true );
+   }
+}
+
+inline void WDWorkStealingDeque::push_back ( WorkDescriptor *wd )
+{
+   increaseDeviceCounter( wd );
+   int tasks = ++( sys.getSchedulerStats()._readyTasks );
+   increaseTasksInQueues( tasks );
+
+   LockBlock lock( _lock );
+   pushOverflow( wd, false );
+}
+
+inline Lock& WDWorkStealingDeque::getLock()
+{
+   return _lock;
+}
+
+inline void WDWorkStealingDeque::push_front( WD** wds, size_t numElems )
+{
+   for( size_t i = 0; i < numElems; ++i )
+   {
+      WD* wd = wds[i];
+      pushOverflow( wd, true );
+      increaseDeviceCounter( wd );
+   }
+   int tasks = sys.getSchedulerStats()._readyTasks += numElems;
+   increaseTasksInQueues(tasks,numElems);
+}
+
+inline void WDWorkStealingDeque::push_back( WD** wds, size_t numElems )
+{
+   for( size_t i = 0; i < numElems; ++i )
+   {
+      WD* wd = wds[i];
+      pushOverflow( wd, false );
+      increaseDeviceCounter( wd );
+   }
+   int tasks = sys.getSchedulerStats()._readyTasks += numElems;
+   increaseTasksInQueues(tasks,numElems);
+}
+
+inline WorkDescriptor * WDWorkStealingDeque::pop_front ( BaseThread *thread )
+{
+   return popFrontWithConstraints<NoConstraints>(thread);
+}
+
+inline WorkDescriptor * WDWorkStealingDeque::pop_back ( BaseThread *thread )
+{
+   return popBackWithConstraints<NoConstraints>(thread);
+}
+
+inline bool WDWorkStealingDeque::removeWD( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next )
+{
+   return removeWDWithConstraints<NoConstraints>(thread,toRem,next);
+}
+
+/*! \brief Pops from the owner end.
+ *  \note Threads other than the owner cannot access the lock-free front, so they steal from the back.
+ */
+template <typename Constraints>
+inline WorkDescriptor * WDWorkStealingDeque::popFrontWithConstraints ( BaseThread const *thread )
+{
+   if ( !hasTasksForThread( thread ) ) return NULL;
+
+   WorkDescriptor *candidate;
+   WorkDescriptor *found = NULL;
+
+   if ( isOwner() ) {
+      while ( found == NULL && popBottom( candidate ) ) {
+         found = claim<Constraints>( candidate, thread );
+      }
+   } else {
+      while ( found == NULL && popTop( candidate ) ) {
+         found = claim<Constraints>( candidate, thread );
+      }
+   }
+
+   if ( found == NULL ) found = popOverflow<Constraints>( thread, true );
+
+   ensure( !found || !found->isTied() || found->isTiedTo() == thread, "" );
+
+   return found;
+}
+
+template <typename Constraints>
+inline WorkDescriptor * WDWorkStealingDeque::popBackWithConstraints ( BaseThread const *thread )
+{
+   if ( !hasTasksForThread( thread ) ) return NULL;
+
+   WorkDescriptor *candidate;
+   WorkDescriptor *found = NULL;
+
+   while ( found == NULL && popTop( candidate ) ) {
+      found = claim<Constraints>( candidate, thread );
+   }
+
+   if ( found == NULL ) found = popOverflow<Constraints>( thread, false );
+
+   ensure( !found || !found->isTied() || found->isTiedTo() == thread, "" );
+
+   return found;
+}
+
+template <typename Constraints>
+inline bool WDWorkStealingDeque::removeWDWithConstraints( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next )
+{
+   if ( toRem->getMyQueue() != this ) return false;
+
+   if ( !Scheduler::checkBasicConstraints( *toRem, *thread) || !Constraints::check(*toRem, *thread) ) return false;
+
+   *next = NULL;
+
+   LockBlock lock( _lock );
+
+   memoryFence();
+
+   if ( toRem->getMyQueue() != this ) return false;
+
+   // Overflow list: same protocol as WDDeque
+   for ( BaseContainer::iterator it = _overflow.begin(); it != _overflow.end(); it++ ) {
+      if ( *it == toRem ) {
+         if ( ( *it )->dequeue( next ) ) {
+            _overflow.erase( it );
+            decreaseDeviceCounter( *next );
+            int tasks = --(sys.getSchedulerStats()._readyTasks);
+            decreaseTasksInQueues(tasks);
+         }
+         (*next)->setMyQueue( NULL );
+         return true;
+      }
+   }
+
+   // Lock-free array: the oldest WD is taken exactly like a steal, any other one belongs to the owner
+   long top = _top;
+   memoryFence();
+   if ( top < _bottom && _array->get( top ) == toRem && compareAndSwap( (long *) &_top, top, top + 1 ) ) {
+      toRem->setMyQueue( NULL );
+      *next = toRem;
+      decreaseDeviceCounter( toRem );
+      int tasks = --(sys.getSchedulerStats()._readyTasks);
+      decreaseTasksInQueues(tasks);
+      return true;
+   }
+
+   return false;
+}
+
+inline void WDWorkStealingDeque::increaseTasksInQueues( int tasks, int increment )
+{
+   NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("num-ready");)
+   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
+   NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
+   _nelems += increment;
+}
+
+inline void WDWorkStealingDeque::decreaseTasksInQueues( int tasks, int decrement )
+{
+   NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("num-ready");)
+   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
+   NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
+   _nelems -= decrement;
+}
+
+inline void WDWorkStealingDeque::increaseDeviceCounter ( WorkDescriptor *wd )
+{
+   if ( _deviceCounter ) {
+      for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
+         const Device *device = wd->getDevices()[i]->getDevice();
+         WDDeviceCounter::iterator device_counter = _ndevs.find( device );
+         ensure( device_counter != _ndevs.end(), "Device not initialized" );
+         ++device_counter->second;
+      }
+   }
+}
+
+inline void WDWorkStealingDeque::decreaseDeviceCounter ( WorkDescriptor *wd )
+{
+   if ( _deviceCounter ) {
+      for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
+         const Device *device = wd->getDevices()[i]->getDevice();
+         WDDeviceCounter::iterator device_counter = _ndevs.find( device );
+         ensure( device_counter != _ndevs.end(), "Device not initialized" );
+         --device_counter->second;
+      }
+   }
+}
+
+inline bool WDWorkStealingDeque::testDequeue()
+{
+   if ( empty() )
+      return false;
+
+   // WDs in the array cannot be inspected without claiming them
+   if ( _bottom > _top )
+      return true;
+
+   bool wd_avail = false;
+   // Skip check if there's contention in the queue
+   if ( _lock.tryAcquire() ) {
+      // Auxiliary map to count successful commutative accesses
+      std::map<WD**, WD*> comm_accesses;
+      BaseContainer::const_iterator it;
+      for ( it = _overflow.begin(); it != _overflow.end(); ++it ) {
+         const WD &wd = *(WD *)*it;
+         if ( wd.getConcurrencyLevel( comm_accesses ) > 0 ) {
+            wd_avail = true;
+            break;
+         }
+      }
+      _lock.release();
+   }
+
+   return wd_avail;
+}
+
 template <typename T>
 inline WDPriorityQueue<T>::WDPriorityQueue( bool enableDeviceCounter, bool optimise, bool reverse, PriorityValueFun getter )
-   : _dq(), _lock(), _nelems(0), _optimise( optimise ), _reverse( reverse ), _ndevs(), _deviceCounter( enableDeviceCounter ),
-     _getter( getter ), _maxPriority( 0 ), _minPriority( 0 )
+   : _buckets( WDPQ::BucketOrder<T>( reverse ) ), _lock(), _nelems(0), _optimise( optimise ), _lastBucket( _buckets.end() ),
+     _reverse( reverse ), _ndevs(), _deviceCounter( enableDeviceCounter ), _getter( getter ), _maxPriority( 0 ), _minPriority( 0 )
 {
    if ( _deviceCounter ) {
       const DeviceList &devs = sys.getSupportedDevices();
@@ -542,7 +987,7 @@ inline WDPriorityQueue<T>::WDPriorityQueue( bool enableDeviceCounter, bool optim
 template<typename T>
 inline bool WDPriorityQueue<T>::empty ( void ) const
 {
-   return _dq.empty();
+   return _buckets.empty();
 }
 
 template<typename T>
@@ -554,86 +999,72 @@ inline size_t WDPriorityQueue<T>::size() const
 template<typename T>
 inline void WDPriorityQueue<T>::insertOrdered( WorkDescriptor *wd, bool fifo )
 {
-   // Find where to insert the wd
-   WDPQ::BaseContainer::iterator it;
-   T priority = wd->getPriority();
-   
-   if ( fifo ) {
-      // #637: Insert at the back if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.back()->getPriority() >= wd->getPriority() ) ) ){
-         it = _dq.end();
-      }
-      else
-         it = upper_bound ( wd );
-   }
-   else {
-      // #637: Insert at the front if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.front()->getPriority() < wd->getPriority() ) ) )
-         it = _dq.begin();
-      else {
-         it = lower_bound( wd );
+   T priority = _getter( wd );
+   typename BucketMap::iterator bucket;
+
+   // Consecutive insertions usually share their priority
+   if ( _optimise && _lastBucket != _buckets.end() && _lastBucket->first == priority ) {
+      bucket = _lastBucket;
+   } else {
+      bucket = _buckets.lower_bound( priority );
+      if ( bucket == _buckets.end() || _buckets.key_comp()( priority, bucket->first ) ) {
+         bucket = _buckets.insert( bucket, std::make_pair( priority, WDPQ::Bucket() ) );
       }
+      _lastBucket = bucket;
    }
-   
-   _dq.insert( it, wd );
+
+   // FIFO: after the WDs with the same priority, LIFO: before them
+   if ( fifo ) bucket->second.push_back( wd );
+   else bucket->second.push_front( wd );
+
    // If the wd was inserted at the end, it has lower priority than any other
-   if( wd == _dq.back() )
-      _minPriority = priority;
+   if ( wd == _buckets.rbegin()->second.back() )
+      _minPriority = wd->getPriority();
    // If it was inserted at the start, it has more than the rest
-   if ( wd == _dq.front() )
-      _maxPriority = priority;
+   if ( wd == _buckets.begin()->second.front() )
+      _maxPriority = wd->getPriority();
 }
 
 template<typename T>
-inline void WDPriorityQueue<T>::insertOrdered( WorkDescriptor ** wds, size_t numElems, bool fifo )
+inline bool WDPriorityQueue<T>::find( WorkDescriptor *wd, typename BucketMap::iterator &bucket, WDPQ::Bucket::iterator &it )
 {
-   // Find where to insert the wd
-   WDPQ::BaseContainer::iterator it;
-   WD* first = wds[0];
-   T priority = first->getPriority();
-   
-   if ( fifo ) {
-      // #637: Insert at the back if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.back()->getPriority() >= priority ) ) ){
-         it = _dq.end();
-      }
-      else
-         it = upper_bound ( first );
+   bucket = _buckets.find( _getter( wd ) );
+   if ( bucket != _buckets.end() ) {
+      it = std::find( bucket->second.begin(), bucket->second.end(), wd );
+      if ( it != bucket->second.end() ) return true;
    }
-   else {
-      // #637: Insert at the front if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.front()->getPriority() < priority ) ) )
-         it = _dq.begin();
-      else {
-         it = lower_bound( first );
-      }
+
+   for ( bucket = _buckets.begin(); bucket != _buckets.end(); ++bucket ) {
+      it = std::find( bucket->second.begin(), bucket->second.end(), wd );
+      if ( it != bucket->second.end() ) return true;
    }
-   
-   _dq.insert( it, wds, wds + numElems );
-   // If the wd was inserted at the end, it has lower priority than any other
-   if( first == _dq.back() )
-      _minPriority = priority;
-   // If it was inserted at the start, it has more than the rest
-   if ( first == _dq.front() )
-      _maxPriority = priority;
+
+   return false;
 }
 
 template<typename T>
-inline WDPQ::BaseContainer::iterator
-WDPriorityQueue<T>::upper_bound( const WD *wd )
+inline void WDPriorityQueue<T>::erase( typename BucketMap::iterator bucket, WDPQ::Bucket::iterator it )
 {
-   if ( _reverse )
-      return std::upper_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparisonReverse<T>( _getter ) );
-   return std::upper_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparison<T>( _getter ) );
+   bucket->second.erase( it );
+   if ( bucket->second.empty() ) {
+      if ( _lastBucket == bucket ) _lastBucket = _buckets.end();
+      _buckets.erase( bucket );
+   }
 }
 
 template<typename T>
-inline WDPQ::BaseContainer::iterator
-WDPriorityQueue<T>::lower_bound( const WD *wd )
+inline void WDPriorityQueue<T>::updatePriorities()
 {
-   if ( _reverse )
-      return std::lower_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparisonReverse<T>( _getter ) );
-   return std::lower_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparison<T>( _getter ) );
+   if ( _buckets.empty() ) {
+      _maxPriority = 0;
+      _minPriority = 0;
+   }
+   // Note that, due to constraints, we might not have extracted
+   // the first element of the queue, but any other one.
+   else {
+      _maxPriority = _buckets.begin()->second.front()->getPriority();
+      _minPriority = _buckets.rbegin()->second.back()->getPriority();
+   }
 }
 
 /*!
@@ -712,7 +1143,6 @@ inline void WDPriorityQueue<T>::push_front( WD** wds, size_t numElems )
    }
    int tasks = sys.getSchedulerStats()._readyTasks += numElems;
    increaseTasksInQueues(tasks,numElems);
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size" );
 }
 
 template<typename T>
@@ -720,40 +1150,15 @@ inline void WDPriorityQueue<T>::push_back( WD** wds, size_t numElems )
 {
    LockBlock lock( _lock );
    fatal_cond( numElems == 0, "No reason to call push_back for 0 elements" );
-   // Get the priority of the first one
-  /* T firstPrio = (*wds)->getPriority();
-   bool samePrio = true;
-   // Check if all of them have the same priority
-   for( size_t i = 1; i < numElems && samePrio; ++i )
-   {
-      samePrio = wds[i]->getPriority() != firstPrio;
-   }
-   // If the have different priorities
-   if ( !samePrio )
-   {*/
-      for( size_t i = 0; i < numElems; ++i )
-      {
-         WD* wd = wds[i];
-         wd->setMyQueue( this );
-         insertOrdered( wd, true );
-         increaseDeviceCounter( wd );
-      }
-   /*}
-   // Otherwise, insert in the same position
-   else
+   for( size_t i = 0; i < numElems; ++i )
    {
-      for( size_t i = 0; i < numElems; ++i )
-      {
-         WD* wd = wds[i];
-         wd->setMyQueue( this );
-      }
-      insertOrdered( wds, numElems, true );
+      WD* wd = wds[i];
+      wd->setMyQueue( this );
+      insertOrdered( wd, true );
       increaseDeviceCounter( wd );
-
-   }*/
+   }
    int tasks = sys.getSchedulerStats()._readyTasks += numElems;
    increaseTasksInQueues(tasks,numElems);
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size" );
 }
 
 /*!
@@ -772,38 +1177,36 @@ inline WorkDescriptor * WDPriorityQueue<T>::popFrontWithConstraints ( BaseThread
 {
    WorkDescriptor *found = NULL;
 
-   if ( _dq.empty() )
+   if ( _buckets.empty() )
       return NULL;
    {
       LockBlock lock( _lock );
 
       memoryFence();
 
-      if ( !_dq.empty() ) {
-         WDPQ::BaseContainer::iterator it;
-         for ( it = _dq.begin(); it != _dq.end() ; ++it ) {
+      bool matched = false;
+      typename BucketMap::iterator bucket;
+      for ( bucket = _buckets.begin(); !matched && bucket != _buckets.end(); ) {
+         WDPQ::Bucket::iterator it;
+         for ( it = bucket->second.begin(); it != bucket->second.end(); ++it ) {
             WD &wd = *(WD *)*it;
             if ( Scheduler::checkBasicConstraints( wd, *thread) && Constraints::check(wd,*thread)) {
-               if ( wd.dequeue( &found ) ) {
-                  _dq.erase( it );
-                  decreaseDeviceCounter( found );
-                  // Update max and min
-                  if ( _dq.empty() ){
-                     _maxPriority = 0;
-                     _minPriority = 0;
-                  }
-                  // Note that, due to constraints, we might not have extracted
-                  // the first element of the queue, but the last one.
-                  else{
-                     _maxPriority = _dq.front()->getPriority();
-                     _minPriority = _dq.back()->getPriority();
-                  }
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
-               }
+               matched = true;
                break;
             }
          }
+         if ( !matched ) {
+            ++bucket;
+            continue;
+         }
+
+         if ( ( *it )->dequeue( &found ) ) {
+            erase( bucket, it );
+            decreaseDeviceCounter( found );
+            updatePriorities();
+            int tasks = --(sys.getSchedulerStats()._readyTasks);
+            decreaseTasksInQueues(tasks);
+         }
       }
 
       if ( found != NULL ) found->setMyQueue( NULL );
@@ -820,81 +1223,36 @@ template <typename Constraints>
 inline WorkDescriptor * WDPriorityQueue<T>::popBackWithConstraints ( BaseThread *thread )
 {
    // FIXME: at the moment this method is implemented as pop_front, change behaviour!!!
-   WorkDescriptor *found = NULL;
-
-   if ( _dq.empty() )
-      return NULL;
-   {
-      LockBlock lock( _lock );
-
-      memoryFence();
-
-      if ( !_dq.empty() ) {
-         WDPQ::BaseContainer::iterator it;
-
-         for ( it = _dq.begin(); it != _dq.end() ; ++it ) {
-            WD &wd = *(WD *)*it;
-            if ( Scheduler::checkBasicConstraints( wd, *thread) && Constraints::check(wd,*thread)) {
-               if ( wd.dequeue( &found ) ) {
-                  _dq.erase( it );
-                  decreaseDeviceCounter( found );
-                  // Update max and min
-                  if ( _dq.empty() ){
-                     _maxPriority = 0;
-                     _minPriority = 0;
-                  }
-                  // Note that, due to constraints, we might not have extracted
-                  // the last element of the queue, but the first one.
-                  else{
-                     _maxPriority = _dq.front()->getPriority();
-                     _minPriority = _dq.back()->getPriority();
-                  }
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
-               }
-               break;
-            }
-         }
-      }
-
-      if ( found != NULL ) found->setMyQueue( NULL );
-
-   }
-
-   ensure( !found || !found->isTied() || found->isTiedTo() == thread, "" );
-
-   return found;
+   return popFrontWithConstraints<Constraints>( thread );
 }
 
 template <typename T>
 template <typename Constraints>
 inline bool WDPriorityQueue<T>::removeWDWithConstraints( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next )
 {
-   if ( _dq.empty() ) return false;
+   if ( _buckets.empty() ) return false;
 
    if ( !Scheduler::checkBasicConstraints( *toRem, *thread) || !Constraints::check(*toRem, *thread) ) return false;
 
    *next = NULL;
-   WDPQ::BaseContainer::iterator it;
+   typename BucketMap::iterator bucket;
+   WDPQ::Bucket::iterator it;
 
    {
       LockBlock lock( _lock );
 
       memoryFence();
 
-      if ( !_dq.empty() && toRem->getMyQueue() == this ) {
-         for ( it = _dq.begin(); it != _dq.end(); it++ ) {
-            if ( *it == toRem ) {
-               if ( ( *it )->dequeue( next ) ) {
-                  _dq.erase( it );
-                  decreaseDeviceCounter( *next );
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
-               }
-               (*next)->setMyQueue( NULL );
-               return true;
-            }
+      if ( !_buckets.empty() && toRem->getMyQueue() == this && find( toRem, bucket, it ) ) {
+         if ( ( *it )->dequeue( next ) ) {
+            erase( bucket, it );
+            decreaseDeviceCounter( *next );
+            updatePriorities();
+            int tasks = --(sys.getSchedulerStats()._readyTasks);
+            decreaseTasksInQueues(tasks);
          }
+         (*next)->setMyQueue( NULL );
+         return true;
       }
    }
 
@@ -907,16 +1265,17 @@ inline bool WDPriorityQueue<T>::reorderWD( WorkDescriptor *wd )
    LockBlock l( _lock );
    
    // Find the WD
-   WDPQ::BaseContainer::iterator it =
-      std::find( _dq.begin(), _dq.end(), wd );
+   typename BucketMap::iterator bucket;
+   WDPQ::Bucket::iterator it;
 
    // If the WD was not found, return false
-   if( it == _dq.end() ){
+   if( !find( wd, bucket, it ) ){
       return false;
    }
 
    // Otherwise, reorder it
-   _dq.erase( it );
+   erase( bucket, it );
+   updatePriorities();
    insertOrdered( wd );
 
    return true;
@@ -941,7 +1300,6 @@ inline void WDPriorityQueue<T>::increaseTasksInQueues( int tasks, int increment
    NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
    _nelems += increment;
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size (increase)" );
 }
 
 template<typename T>
@@ -951,7 +1309,7 @@ inline void WDPriorityQueue<T>::decreaseTasksInQueues( int tasks, int decrement
    NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
    _nelems -= decrement;
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size (decrease)" );
+   fatal_cond( _buckets.empty() != ( _nelems == 0 ), "Bucket count does not match queue size (decrease)" );
 }
 
 template<typename T>
@@ -983,7 +1341,7 @@ inline void WDPriorityQueue<T>::decreaseDeviceCounter ( WorkDescriptor *wd )
 template<typename T>
 inline bool WDPriorityQueue<T>::testDequeue()
 {
-   if ( _dq.empty() )
+   if ( _buckets.empty() )
       return false;
 
    bool wd_avail = false;
@@ -992,12 +1350,15 @@ inline bool WDPriorityQueue<T>::testDequeue()
       // Auxiliary map to count successful commutative accesses
       std::map<WD**, WD*> comm_accesses;
       // ReadyQueue iterator
-      WDPQ::BaseContainer::const_iterator it;
-      for ( it = _dq.begin(); it != _dq.end(); ++it ) {
-         const WD &wd = *(WD *)*it;
-         if ( wd.getConcurrencyLevel( comm_accesses ) > 0 ) {
-            wd_avail = true;
-            break;
+      typename BucketMap::const_iterator bucket;
+      for ( bucket = _buckets.begin(); !wd_avail && bucket != _buckets.end(); ++bucket ) {
+         WDPQ::Bucket::const_iterator it;
+         for ( it = bucket->second.begin(); it != bucket->second.end(); ++it ) {
+            const WD &wd = *(WD *)*it;
+            if ( wd.getConcurrencyLevel( comm_accesses ) > 0 ) {
+               wd_avail = true;
+               break;
+            }
          }
       }
       _lock.release();
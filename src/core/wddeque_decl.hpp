@@ -21,12 +21,14 @@
 #define _NANOS_LIB_WDDEQUE_DECL_H
 
 #include <list>
+#include <deque>
 #include <functional>
 #include <map>
 
 #include "debug.hpp"
 #include "atomic_decl.hpp"
 #include "lock_decl.hpp"
+#include "allocator_decl.hpp"
 
 #include "basethread_fwd.hpp"
 
@@ -104,6 +106,12 @@ namespace nanos {
           */
 
          virtual bool testDequeue() { return !empty(); }
+
+         /*! \brief Sets the thread owning this pool
+          *  Pools with an owner-only fast path (e.g. WDWorkStealingDeque) use it,
+          *  the rest just ignore it.
+          */
+         virtual void setOwner ( BaseThread *thread ) {}
    };
 
    class WDDeque : public WDPool
@@ -244,56 +252,166 @@ namespace nanos {
 
    };
    
-   /*! \brief Class used to compare WDs by priority.
-    *  \see WDPriorityQueue::push
-    */
-   template <typename T>
-   struct WDPriorityComparisonBase : public std::binary_function< WD*, WD*, bool>
-   {
-      /*! \brief Type of the functor */
-      typedef std::const_mem_fun_t<T, WD> PriorityValueFun;
-      
-      PriorityValueFun _getter;
-      
-      WDPriorityComparisonBase( PriorityValueFun functor ) : _getter( functor ) {}
-   };
-   
-   /*! \brief Class used to compare WDs by priority.
-    */
-   template <typename T>
-   struct WDPriorityComparison : public WDPriorityComparisonBase<T>
-   {
-      typedef WDPriorityComparisonBase<T> Base;
-      
-      WDPriorityComparison( typename Base::PriorityValueFun functor ) 
-         : Base( functor ) {}
-      
-      bool operator() ( const WD *wd1, const WD *wd2 ) const
-      {
-         return this->_getter( wd1 ) > this->_getter( wd2 );
-      }
-   };
-   
-   /*! \brief Class used to compare WDs by priority reversely.
+   /*! \brief Lock-free work-stealing deque (Chase-Lev)
+    *
+    *  The owner thread pushes and pops at the front (bottom) of a growable
+    *  circular array without taking any lock, while other threads steal from
+    *  the back (top) with a single CAS. removeWD() can only take a WD from the
+    *  array when it is the oldest one, using the same CAS as a steal.
+    *
+    *  WDs that need the generic treatment (tied or sliced WDs, pushes from a
+    *  thread other than the owner, batch insertions and WDs that a thread could
+    *  not run after claiming them) are kept in a lock-protected overflow list,
+    *  which is checked once the array is empty.
     */
-   template <typename T>
-   struct WDPriorityComparisonReverse : public WDPriorityComparisonBase<T>
+   class WDWorkStealingDeque : public WDPool
    {
-      typedef WDPriorityComparisonBase<T> Base;
-      
-      WDPriorityComparisonReverse( typename Base::PriorityValueFun functor ) 
-         : Base( functor ) {}
-      bool operator() ( const WD *wd1, const WD *wd2 ) const
-      {
-         return this->_getter( wd1 ) <= this->_getter( wd2 );
-      }
+      private:
+         class WDArray
+         {
+            private:
+               size_t                      _mask;     /**< Capacity - 1 (capacity is a power of two) */
+               WorkDescriptor * volatile  *_slots;    /**< Circular buffer */
+               WDArray                    *_previous; /**< Retired array, only freed with the deque */
+            private:
+              /*! \brief WDArray copy constructor (private)
+               */
+               WDArray ( const WDArray & );
+              /*! \brief WDArray copy assignment operator (private)
+               */
+               const WDArray & operator= ( const WDArray & );
+            public:
+              /*! \brief WDArray constructor
+               */
+               WDArray ( size_t size, WDArray *previous );
+              /*! \brief WDArray destructor
+               */
+               ~WDArray ();
+
+               size_t size ( void ) const { return _mask + 1; }
+               WorkDescriptor * get ( long i ) const { return _slots[i & _mask]; }
+               void put ( long i, WorkDescriptor *wd ) { _slots[i & _mask] = wd; }
+               WDArray * getPrevious ( void ) const { return _previous; }
+         }; // end: class WDArray
+
+         typedef std::list<WorkDescriptor *> BaseContainer;
+         typedef std::map< const Device *, Atomic<unsigned int> > WDDeviceCounter;
+
+         volatile long        _top;          /**< Steal end, only advanced by CAS */
+         char                 _pad0[NANOS_CACHELINE];
+         volatile long        _bottom;       /**< Owner end, only written by the owner */
+         WDArray * volatile   _array;        /**< Current circular buffer */
+         BaseThread          *_owner;        /**< Thread allowed to use the lock-free front */
+         char                 _pad1[NANOS_CACHELINE];
+         BaseContainer        _overflow;     /**< WDs that cannot use the lock-free path */
+         Lock                 _lock;         /**< Protects _overflow */
+         Atomic<size_t>       _nelems;
+         WDDeviceCounter      _ndevs;
+         bool                 _deviceCounter;
+
+      private:
+         /*! \brief WDWorkStealingDeque copy constructor (private)
+          */
+         WDWorkStealingDeque ( const WDWorkStealingDeque & );
+         /*! \brief WDWorkStealingDeque copy assignment operator (private)
+          */
+         const WDWorkStealingDeque & operator= ( const WDWorkStealingDeque & );
+
+         bool isOwner ( void ) const;
+
+         /*! \brief Owner-only push to the front of the array */
+         void pushBottom ( WorkDescriptor *wd );
+         /*! \brief Owner-only pop from the front of the array
+          *  \param [out] wd Popped WD, NULL if a thief won the last one
+          *  \return false if the array was empty
+          */
+         bool popBottom ( WorkDescriptor *&wd );
+         /*! \brief Steals from the back of the array
+          *  \param [out] wd Stolen WD
+          *  \return false if the array was empty
+          */
+         bool popTop ( WorkDescriptor *&wd );
+         /*! \brief Doubles the array capacity (owner only)
+          */
+         WDArray * grow ( WDArray *array, long bottom, long top );
+
+         /*! \brief Checks a WD extracted from the array against thread
+          *  \return the WD if it can run in thread, NULL if it was moved to the overflow list
+          */
+         template <typename Constraints>
+         WorkDescriptor * claim ( WorkDescriptor *wd, BaseThread const *thread );
+
+         /*! \brief Inserts a WD in the overflow list.
+          *  \note The lock must be held by the caller.
+          */
+         void pushOverflow ( WorkDescriptor *wd, bool front );
+         template <typename Constraints>
+         WorkDescriptor * popOverflow ( BaseThread const *thread, bool front );
+
+         bool hasTasksForThread ( BaseThread const *thread );
+
+         void increaseTasksInQueues( int tasks, int increment = 1 );
+         void decreaseTasksInQueues( int tasks, int decrement = 1 );
+
+         void increaseDeviceCounter ( WorkDescriptor *wd );
+         void decreaseDeviceCounter ( WorkDescriptor *wd );
+
+      public:
+         /*! \brief WDWorkStealingDeque default constructor
+          *  \param initialSize Initial capacity of the lock-free array, rounded up to a power of two
+          */
+         WDWorkStealingDeque( bool enableDeviceCounter = true, size_t initialSize = 1024 );
+         /*! \brief WDWorkStealingDeque destructor
+          */
+         ~WDWorkStealingDeque();
+
+         bool empty ( void ) const;
+         size_t size() const;
+
+         void setOwner ( BaseThread *thread );
+
+         void push_front ( WorkDescriptor *wd );
+         void push_back( WorkDescriptor *wd );
+
+         Lock& getLock();
+         void push_front( WD** wds, size_t numElems );
+         void push_back( WD** wds, size_t numElems );
+
+         template <typename Constraints>
+         WorkDescriptor * popFrontWithConstraints ( BaseThread const *thread );
+         template <typename Constraints>
+         WorkDescriptor * popBackWithConstraints ( BaseThread const *thread );
+         template <typename Constraints>
+         bool removeWDWithConstraints( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next );
+
+         WorkDescriptor * pop_front ( BaseThread *thread );
+         WorkDescriptor * pop_back ( BaseThread *thread );
+
+         bool removeWD( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next );
+
+         bool testDequeue();
    };
 
-   /*! \brief Namespace used to refer WDPriorityQueue BaseContainer.
+   /*! \brief Namespace used to refer WDPriorityQueue containers.
     */
    namespace WDPQ
    {
-       typedef std::list<WorkDescriptor *> BaseContainer;
+       /*! \brief WDs sharing the same priority, in queue order */
+       typedef std::deque<WorkDescriptor *> Bucket;
+
+       /*! \brief Order of the priority buckets: highest priority first, unless reversed */
+       template <typename T>
+       struct BucketOrder
+       {
+          bool _reverse;
+
+          BucketOrder( bool reverse = false ) : _reverse( reverse ) {}
+
+          bool operator() ( const T &p1, const T &p2 ) const
+          {
+             return _reverse ? p1 < p2 : p1 > p2;
+          }
+       };
    }
 
    template<typename T = WD::PriorityType>
@@ -305,16 +423,19 @@ namespace nanos {
          typedef std::map< const Device *, Atomic<unsigned int> > WDDeviceCounter;
 
       private:
-         // TODO (gmiranda): Measure if vector is better as a container
-         WDPQ::BaseContainer _dq;
+         typedef std::map< T, WDPQ::Bucket, WDPQ::BucketOrder<T> > BucketMap;
+
+         /*! \brief WDs grouped by priority. Buckets are kept in priority order and are
+          *  never empty, so the first WD of the first bucket is the next one to run.
+          */
+         BucketMap           _buckets;
          Lock                _lock;
          size_t              _nelems;
-         /*! \brief When this is enabled, elements with the same priority
-          * as the one in the back will be inserted at the back.
-          * \note When this is enabled, it will override the LIFO behaviour
-          * in the above case.
+         /*! \brief When this is enabled, the bucket used by the last insertion is
+          * remembered and reused while the inserted priorities do not change.
           */
          bool              _optimise;
+         typename BucketMap::iterator _lastBucket;
          
          /*! \brief Revert insertion */
          bool              _reverse;
@@ -343,14 +464,18 @@ namespace nanos {
           *  \param fifo Insert WDs with the same after the current ones?
           */
          void insertOrdered ( WorkDescriptor *wd, bool fifo = true );
-         void insertOrdered ( WorkDescriptor ** wds, size_t numElems, bool fifo = true );
-         
-         /*! \brief Performs upper bound reversely or not depending on the settings */
-         WDPQ::BaseContainer::iterator upper_bound( const WD *wd );
-        
-         /*! \brief Performs lower bound reversely or not depending on the settings */
-         WDPQ::BaseContainer::iterator lower_bound( const WD *wd );
 
+         /*! \brief Finds a WD in the queue. The bucket of its current priority is
+          *  tried first, then the whole queue (its priority may have changed).
+          *  \return If the WD was found or not.
+          */
+         bool find ( WorkDescriptor *wd, typename BucketMap::iterator &bucket, WDPQ::Bucket::iterator &it );
+
+         /*! \brief Removes an element of a bucket, dropping the bucket if it becomes empty */
+         void erase ( typename BucketMap::iterator bucket, WDPQ::Bucket::iterator it );
+
+         /*! \brief Updates max and min priorities after a removal */
+         void updatePriorities ();
 
          void increaseTasksInQueues( int tasks, int increment = 1 );
          void decreaseTasksInQueues( int tasks, int decrement = 1 );
@@ -393,7 +518,7 @@ namespace nanos {
 
          /*! \brief Reorders the list a WD in the current queue.
           * It is needed when the priority of a WD is changed.
-          * \note This just removes and pushes the WD into the list.
+          * \note This just removes and pushes the WD into the queue.
           * \return If the WD was found or not.
           * \note This method sets the lock upon entry (using LockBlock).
           */
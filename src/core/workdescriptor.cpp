@@ -79,7 +79,7 @@ void WorkDescriptor::initWithPE ( ProcessingElement &pe )
       //   }
       //}
 
-      _notifyThread = pe.getFirstThread();
+      if ( _coldData != NULL ) _coldData->_notifyThread = pe.getFirstThread();
       pe.copyDataIn( *this );
       //this->notifyCopy();
 
@@ -93,9 +93,8 @@ void WorkDescriptor::initWithPE ( ProcessingElement &pe )
 
 void WorkDescriptor::notifyCopy()
 {
-   if ( _notifyCopy != NULL ) {
-      //std::cerr << " WD " << getId() << " GONNA CALL THIS SHIT IF POSSIBLE: " << (void *)_notifyCopy << " ARG IS THD "<< _notifyThread->getId() << std::endl;
-      _notifyCopy( *this, *_notifyThread );
+   if ( _coldData != NULL && _coldData->_notifyCopy != NULL ) {
+      _coldData->_notifyCopy( *this, *_coldData->_notifyThread );
    }
 }
 
@@ -348,8 +347,8 @@ void WorkDescriptor::done ()
 
    #ifdef NANOX_TASK_CALLBACK
    typedef void (* notify_t) ( void * );
-   notify_t notify = (notify_t) _callback;
-   if (notify ) notify(_arguments);
+   notify_t notify = _coldData != NULL ? (notify_t) _coldData->_callback : NULL;
+   if (notify ) notify(_coldData->_arguments);
    #endif
 }
 
@@ -419,7 +418,7 @@ void WorkDescriptor::printCopies()
 
 }
 void WorkDescriptor::setNotifyCopyFunc( void (*func)(WD &, BaseThread const&) ) {
-   _notifyCopy = func;
+   getColdData()._notifyCopy = func;
 }
 void WorkDescriptor::initCommutativeAccesses( WorkDescriptor &wd, size_t numDeps, DataAccess* deps )
 {
@@ -548,18 +547,20 @@ void WorkDescriptor::exitWork ( WorkDescriptor &work )
 void WorkDescriptor::registerTaskReduction( void *p_orig, size_t p_size, size_t p_el_size,
       void (*p_init)( void *, void * ), void (*p_reducer)( void *, void * ) )
 {
+   task_reduction_vector_t &taskReductions = getColdData()._taskReductions;
+
    //! Check if we have registered a reduction with this address
    task_reduction_vector_t::reverse_iterator it;
-   for ( it = _taskReductions.rbegin(); it != _taskReductions.rend(); it++) {
+   for ( it = taskReductions.rbegin(); it != taskReductions.rend(); it++) {
       if ( (*it)->has( p_orig) )
       {
     	  return;
       }
    }
 
-   if ( it == _taskReductions.rend() ) {
+   if ( it == taskReductions.rend() ) {
        //! We must register p_orig as a new reduction
-       _taskReductions.push_back(
+       taskReductions.push_back(
                new TaskReduction(
             		   p_orig,
 					   p_init,
@@ -577,15 +578,17 @@ void WorkDescriptor::registerTaskReduction( void *p_orig, size_t p_size, size_t
 void WorkDescriptor::registerFortranArrayTaskReduction( void *p_orig, void *p_dep, size_t array_descriptor_size,
       void (*p_init)( void *, void * ), void (*p_reducer)( void *, void * ), void (*p_reducer_orig_var)( void *, void * ) )
 {
+   task_reduction_vector_t &taskReductions = getColdData()._taskReductions;
+
    //! Check if we have registered a reduction with this address
    task_reduction_vector_t::reverse_iterator it;
-   for ( it = _taskReductions.rbegin(); it != _taskReductions.rend(); it++) {
+   for ( it = taskReductions.rbegin(); it != taskReductions.rend(); it++) {
       if ( (*it)->has( p_dep) ) break;
    }
 
-   if ( it == _taskReductions.rend() ) {
+   if ( it == taskReductions.rend() ) {
       //! We must register p_orig as a new reduction
-     _taskReductions.push_back(
+     taskReductions.push_back(
             new TaskReduction(
             		p_orig,
 					p_dep,
@@ -603,16 +606,19 @@ void WorkDescriptor::registerFortranArrayTaskReduction( void *p_orig, void *p_de
 
 void * WorkDescriptor::getTaskReductionThreadStorage( void *p_addr, size_t id )
 {
+   if ( _coldData == NULL ) return NULL;
+   task_reduction_vector_t &taskReductions = _coldData->_taskReductions;
+
    //! Check if we have registered a reduction with this address
    task_reduction_vector_t::reverse_iterator it;
-   for ( it = _taskReductions.rbegin(); it != _taskReductions.rend(); it++) {
+   for ( it = taskReductions.rbegin(); it != taskReductions.rend(); it++) {
       if((*it)->has( p_addr )) break;
    }
 
    // If 'p_addr' is not registered as a reduction we should return NULL
    void *storage = NULL;
 
-   if ( it != _taskReductions.rend() ) {
+   if ( it != taskReductions.rend() ) {
       storage = (*it)->get(id);
 
       if ( storage == NULL )
@@ -626,21 +632,27 @@ void * WorkDescriptor::getTaskReductionThreadStorage( void *p_addr, size_t id )
 
 void WorkDescriptor::removeAllTaskReductions( void )
 {
+   if ( _coldData == NULL ) return;
+   task_reduction_vector_t &taskReductions = _coldData->_taskReductions;
+
    task_reduction_vector_t::reverse_iterator it;
-   for ( it = _taskReductions.rbegin(); it != _taskReductions.rend(); it++) {
+   for ( it = taskReductions.rbegin(); it != taskReductions.rend(); it++) {
       // Am I the owner of this reduction?
       if (_depth == (*it)->getDepth()) {
          delete (*it);
-         _taskReductions.erase( --(it.base()) );
+         taskReductions.erase( --(it.base()) );
       }
    }
 }
 
 TaskReduction * WorkDescriptor::getTaskReduction( const void *p_dep )
 {
+   if ( _coldData == NULL ) return NULL;
+   task_reduction_vector_t &taskReductions = _coldData->_taskReductions;
+
    // Check if we have registered a reduction with this address
    task_reduction_vector_t::reverse_iterator it;
-   for ( it = _taskReductions.rbegin(); it != _taskReductions.rend(); it++) {
+   for ( it = taskReductions.rbegin(); it != taskReductions.rend(); it++) {
 	   if ( (*it)->has( p_dep ) ) return (*it);
    }
    return NULL;
@@ -40,25 +40,24 @@ namespace nanos {
 
 inline WorkDescriptor::WorkDescriptor ( int ndevices, DeviceData **devs, size_t data_size, size_t data_align, void *wdata,
                                  size_t numCopies, CopyData *copies, nanos_translate_args_t translate_args, const char *description )
-                               : _id( sys.getWorkDescriptorId() ), _hostId(0), _components( 0 ),
-                                 _componentsSyncCond( EqualConditionChecker<int>( &_components.override(), 0 ) ), _parent(NULL), _forcedParent(NULL),
-                                 _data_size ( data_size ), _data_align( data_align ),  _data ( wdata ), _totalSize(0),
-                                 _wdData ( NULL ), _scheduleData( NULL ),
-                                 _flags(), _tiedTo ( NULL ), _tiedToLocation( (memory_space_id_t) -1 ),
-                                 _state( INIT ), _syncCond( NULL ),  _myQueue ( NULL ), _depth ( 0 ),
-                                 _numDevices ( ndevices ), _devices ( devs ), _activeDeviceIdx( ndevices == 1 ? 0 : ndevices ),
+                               : _id( sys.getWorkDescriptorId() ), _state( INIT ), _flags(),
+                                 _numDevices ( ndevices ), _activeDeviceIdx( ndevices == 1 ? 0 : ndevices ),
+                                 _components( 0 ), _priority( 0 ), _depth ( 0 ), _tiedToLocation( (memory_space_id_t) -1 ),
+                                 _parent(NULL), _data ( wdata ), _myQueue ( NULL ), _tiedTo ( NULL ), _devices ( devs ), _slicer(NULL),
+                                 _scheduleData( NULL ), _wdData ( NULL ),
+                                 _doSubmit(NULL), _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
+                                 _commutativeOwners(NULL), _numCopies( numCopies ), _copies( copies ),
+                                 _coldData( NULL ),
+                                 _syncCond( NULL ), _translateArgs( translate_args ), _numaNode( 0 ),
+                                 _hostId(0), _copiesNotInChunk(false), _reachedTaskwait( false ),
+                                 _componentsSyncCond( EqualConditionChecker<int>( &_components.override(), 0 ) ), _forcedParent(NULL),
+                                 _data_size ( data_size ), _data_align( data_align ), _totalSize(0),
 #ifdef GPU_DEV
                                  _cudaStreamIdx( -1 ),
 #endif
-                                 _numCopies( numCopies ), _copies( copies ), _paramsSize( 0 ),
-                                 _versionGroupId( 0 ), _executionTime( 0.0 ), _estimatedExecTime( 0.0 ),
-                                 _doSubmit(NULL), _doWait(), _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
-                                 _translateArgs( translate_args ),
-                                 _priority( 0 ), _commutativeOwnerMap(NULL), _commutativeOwners(NULL),
-                                 _copiesNotInChunk(false), _description(description), _instrumentationContextData(), _slicer(NULL),
-                                 _taskReductions(),
-                                 _notifyCopy( NULL ), _notifyThread( NULL ), _remoteAddr( NULL ), _callback(0), _arguments(0),
-                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _schedPredecessorLocs(),
+                                 _paramsSize( 0 ), _versionGroupId( 0 ), _executionTime( 0.0 ), _estimatedExecTime( 0.0 ),
+                                 _doWait(), _commutativeOwnerMap(NULL), _description(description), _instrumentationContextData(),
+                                 _criticality( 0 ), _submittedWDs( NULL ),
                                  _mcontrol( this, numCopies )
                                  {
                                     _flags.is_final = 0;
@@ -71,31 +70,28 @@ inline WorkDescriptor::WorkDescriptor ( int ndevices, DeviceData **devs, size_t
                                           copies[i].setRemoteHost( false );
                                        }
                                     }
-                                    for (unsigned int __i=0; __i<8;__i+=1) {
-                                       _schedValues[__i]=-1;
-                                    }
                                  }
 
 inline WorkDescriptor::WorkDescriptor ( DeviceData *device, size_t data_size, size_t data_align, void *wdata,
                                  size_t numCopies, CopyData *copies, nanos_translate_args_t translate_args, const char *description )
-                               : _id( sys.getWorkDescriptorId() ), _hostId( 0 ), _components( 0 ),
-                                 _componentsSyncCond( EqualConditionChecker<int>( &_components.override(), 0 ) ), _parent(NULL), _forcedParent(NULL),
-                                 _data_size ( data_size ), _data_align ( data_align ), _data ( wdata ), _totalSize(0),
-                                 _wdData ( NULL ), _scheduleData( NULL ),
-                                 _flags(), _tiedTo ( NULL ), _tiedToLocation( (memory_space_id_t) -1 ),
-                                 _state( INIT ), _syncCond( NULL ), _myQueue ( NULL ), _depth ( 0 ),
-                                 _numDevices ( 1 ), _devices ( NULL ), _activeDeviceIdx( 0 ),
+                               : _id( sys.getWorkDescriptorId() ), _state( INIT ), _flags(),
+                                 _numDevices ( 1 ), _activeDeviceIdx( 0 ),
+                                 _components( 0 ), _priority( 0 ), _depth ( 0 ), _tiedToLocation( (memory_space_id_t) -1 ),
+                                 _parent(NULL), _data ( wdata ), _myQueue ( NULL ), _tiedTo ( NULL ), _devices ( NULL ), _slicer(NULL),
+                                 _scheduleData( NULL ), _wdData ( NULL ),
+                                 _doSubmit(NULL), _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
+                                 _commutativeOwners(NULL), _numCopies( numCopies ), _copies( copies ),
+                                 _coldData( NULL ),
+                                 _syncCond( NULL ), _translateArgs( translate_args ), _numaNode( 0 ),
+                                 _hostId( 0 ), _copiesNotInChunk(false), _reachedTaskwait( false ),
+                                 _componentsSyncCond( EqualConditionChecker<int>( &_components.override(), 0 ) ), _forcedParent(NULL),
+                                 _data_size ( data_size ), _data_align ( data_align ), _totalSize(0),
 #ifdef GPU_DEV
                                  _cudaStreamIdx( -1 ),
 #endif
-                                 _numCopies( numCopies ), _copies( copies ), _paramsSize( 0 ),
-                                 _versionGroupId( 0 ), _executionTime( 0.0 ), _estimatedExecTime( 0.0 ),
-                                 _doSubmit(NULL), _doWait(), _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
-                                 _translateArgs( translate_args ),
-                                 _priority( 0 ),  _commutativeOwnerMap(NULL), _commutativeOwners(NULL),
-                                 _copiesNotInChunk(false), _description(description), _instrumentationContextData(), _slicer(NULL), _taskReductions(),
-                                 _notifyCopy( NULL ), _notifyThread( NULL ), _remoteAddr( NULL ), _callback(0), _arguments(0),
-                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _schedPredecessorLocs(),
+                                 _paramsSize( 0 ), _versionGroupId( 0 ), _executionTime( 0.0 ), _estimatedExecTime( 0.0 ),
+                                 _doWait(), _commutativeOwnerMap(NULL), _description(description), _instrumentationContextData(),
+                                 _criticality( 0 ), _submittedWDs( NULL ),
                                  _mcontrol( this, numCopies )
                                  {
                                      _devices = new DeviceData*[1];
@@ -110,31 +106,29 @@ inline WorkDescriptor::WorkDescriptor ( DeviceData *device, size_t data_size, si
                                           copies[i].setRemoteHost( false );
                                        }
                                     }
-                                    for (unsigned int __i=0; __i<8;__i+=1) {
-                                       _schedValues[__i]=-1;
-                                    }
                                  }
 
 inline WorkDescriptor::WorkDescriptor ( const WorkDescriptor &wd, DeviceData **devs, CopyData * copies, void *data, const char *description )
-                               : _id( sys.getWorkDescriptorId() ), _hostId( 0 ), _components( 0 ),
-                                 _componentsSyncCond( EqualConditionChecker<int>(&_components.override(), 0 ) ), _parent(NULL), _forcedParent(wd._forcedParent),
-                                 _data_size( wd._data_size ), _data_align( wd._data_align ), _data ( data ), _totalSize(0),
-                                 _wdData ( NULL ), _scheduleData( NULL ),
-                                 _flags(), _tiedTo ( wd._tiedTo ), _tiedToLocation( wd._tiedToLocation ),
-                                 _state ( INIT ), _syncCond( NULL ), _myQueue ( NULL ), _depth ( wd._depth ),
-                                 _numDevices ( wd._numDevices ), _devices ( devs ), _activeDeviceIdx( wd._numDevices == 1 ? 0 : wd._numDevices ),
+                               : _id( sys.getWorkDescriptorId() ), _state ( INIT ), _flags(),
+                                 _numDevices ( wd._numDevices ), _activeDeviceIdx( wd._numDevices == 1 ? 0 : wd._numDevices ),
+                                 _components( 0 ), _priority( wd._priority ), _depth ( wd._depth ), _tiedToLocation( wd._tiedToLocation ),
+                                 _parent(NULL), _data ( data ), _myQueue ( NULL ), _tiedTo ( wd._tiedTo ), _devices ( devs ), _slicer(wd._slicer),
+                                 _scheduleData( NULL ), _wdData ( NULL ),
+                                 _doSubmit(NULL), _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
+                                 _commutativeOwners(NULL),
+                                 _numCopies( wd._numCopies ), _copies( wd._numCopies == 0 ? NULL : copies ),
+                                 _coldData( NULL ),
+                                 _syncCond( NULL ), _translateArgs( wd._translateArgs ), _numaNode( wd._numaNode ),
+                                 _hostId( 0 ), _copiesNotInChunk( wd._copiesNotInChunk), _reachedTaskwait( false ),
+                                 _componentsSyncCond( EqualConditionChecker<int>(&_components.override(), 0 ) ), _forcedParent(wd._forcedParent),
+                                 _data_size( wd._data_size ), _data_align( wd._data_align ), _totalSize(0),
 #ifdef GPU_DEV
                                  _cudaStreamIdx( wd._cudaStreamIdx ),
 #endif
-                                 _numCopies( wd._numCopies ), _copies( wd._numCopies == 0 ? NULL : copies ), _paramsSize( wd._paramsSize ),
-                                 _versionGroupId( wd._versionGroupId ), _executionTime( wd._executionTime ),
-                                 _estimatedExecTime( wd._estimatedExecTime ), _doSubmit(NULL), _doWait(),
-                                 _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
-                                 _translateArgs( wd._translateArgs ),
-                                 _priority( wd._priority ), _commutativeOwnerMap(NULL), _commutativeOwners(NULL),
-                                 _copiesNotInChunk( wd._copiesNotInChunk), _description(description), _instrumentationContextData(), _slicer(wd._slicer), _taskReductions(),
-                                 _notifyCopy( NULL ), _notifyThread( NULL ), _remoteAddr( NULL ), _callback(0), _arguments(0),
-                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _schedPredecessorLocs(),
+                                 _paramsSize( wd._paramsSize ), _versionGroupId( wd._versionGroupId ), _executionTime( wd._executionTime ),
+                                 _estimatedExecTime( wd._estimatedExecTime ), _doWait(),
+                                 _commutativeOwnerMap(NULL), _description(description), _instrumentationContextData(),
+                                 _criticality( wd._criticality ), _submittedWDs( NULL ),
                                  _mcontrol( this, wd._numCopies )
                                  {
                                     if ( wd._parent != NULL ) wd._parent->addWork(*this);
@@ -148,9 +142,6 @@ inline WorkDescriptor::WorkDescriptor ( const WorkDescriptor &wd, DeviceData **d
                                     _flags.is_runtime_task = wd._flags.is_runtime_task;
 
                                     _mcontrol.preInit();
-                                    for (unsigned int __i=0; __i<8;__i+=1) {
-                                       _schedValues[__i]=-1;
-                                    }
                                  }
 
 inline WorkDescriptor::~WorkDescriptor()
@@ -180,6 +171,8 @@ inline WorkDescriptor::~WorkDescriptor()
 
     if (_copiesNotInChunk)
         delete[] _copies;
+
+    delete _coldData;
 }
 
 /* DeviceData inlined functions */
@@ -527,7 +520,11 @@ inline void WorkDescriptor::convertToRegularWD()
 
 inline void WorkDescriptor::copyReductions(WorkDescriptor *parent)
 {
-	_taskReductions = parent->_taskReductions;
+   if ( parent->_coldData == NULL || parent->_coldData->_taskReductions.empty() ) {
+      if ( _coldData != NULL ) _coldData->_taskReductions.clear();
+      return;
+   }
+   getColdData()._taskReductions = parent->_coldData->_taskReductions;
 }
 
 inline void WorkDescriptor::setId( unsigned int id ) {
@@ -535,11 +532,26 @@ inline void WorkDescriptor::setId( unsigned int id ) {
 }
 
 inline void WorkDescriptor::setRemoteAddr( void const *addr ) {
-   _remoteAddr = addr;
+   getColdData()._remoteAddr = addr;
 }
 
 inline void const *WorkDescriptor::getRemoteAddr() const {
-   return _remoteAddr;
+   return _coldData != NULL ? _coldData->_remoteAddr : NULL;
+}
+
+inline WorkDescriptor::ColdData & WorkDescriptor::getColdData ()
+{
+   if ( _coldData == NULL ) _coldData = NEW ColdData();
+   return *_coldData;
+}
+
+inline int * WorkDescriptor::getSchedValues () { return getColdData()._schedValues; }
+
+inline std::map<memory_space_id_t,unsigned int> & WorkDescriptor::getSchedPredecessorLocs () { return getColdData()._schedPredecessorLocs; }
+
+inline size_t WorkDescriptor::getHotDataSize () const
+{
+   return (size_t) ( (const char *) &_syncCond - (const char *) this );
 }
 
 inline bool WorkDescriptor::setInvalid ( bool flag )
@@ -580,9 +592,9 @@ inline void WorkDescriptor::setCriticality ( int cr ) { _criticality = cr; }
 
 inline int  WorkDescriptor::getCriticality () const { return _criticality; }
 
-inline void WorkDescriptor::setCallback ( void *cb ) { _callback = cb; }
+inline void WorkDescriptor::setCallback ( void *cb ) { if ( cb != NULL || _coldData != NULL ) getColdData()._callback = cb; }
 
-inline void WorkDescriptor::setArguments ( void *a ) { _arguments = a; }
+inline void WorkDescriptor::setArguments ( void *a ) { if ( a != NULL || _coldData != NULL ) getColdData()._arguments = a; }
 
 } // namespace nanos
 
@@ -220,64 +220,80 @@ typedef std::set<const Device *>  DeviceList;
          typedef int PriorityType;
          typedef SingleSyncCond<EqualConditionChecker<int> >  components_sync_cond_t;
          typedef std::vector<TaskReduction *>        task_reduction_vector_t;  //< List of task reductions type
+         /*! \brief Fields of rarely used subsystems (cluster, reductions, task callbacks and
+          *  cluster locality scheduling), allocated the first time one of them is written.
+          */
+         struct ColdData {
+            task_reduction_vector_t       _taskReductions;         //!< Vector of task reductions
+            void                        (*_notifyCopy)( WD &wd, BaseThread const &thread);
+            BaseThread const             *_notifyThread;
+            void const                   *_remoteAddr;
+            void                         *_callback;
+            void                         *_arguments;
+            int                           _schedValues[8];
+            std::map<memory_space_id_t,unsigned int>   _schedPredecessorLocs;
+
+            ColdData () : _taskReductions(), _notifyCopy( NULL ), _notifyThread( NULL ), _remoteAddr( NULL ),
+               _callback( NULL ), _arguments( NULL ), _schedPredecessorLocs()
+            {
+               for ( unsigned int i = 0; i < 8; i++ ) _schedValues[i] = -1;
+            }
+         };
       private: /* data members */
+         //! \note Hot fields first: the ones touched on the submit, dequeue, execute and
+         //! finish path of a plain task are packed at the beginning of the object (see
+         //! getHotDataSize() and the 02_core/sizeof_classes test).
          int                           _id;                     //!< Work descriptor identifier
-         int                           _hostId;                 //!< Work descriptor identifier @ host
+         State                         _state;                  //!< Workdescriptor current state
+         WDFlags                       _flags;                  //!< WD Flags
+         unsigned char                 _numDevices;             //!< Number of suported devices for this workdescriptor
+         unsigned char                 _activeDeviceIdx;        //!< In _devices, index where we can find the current active DeviceData (if any)
          Atomic<int>                   _components;             //!< Number of components (children, direct descendants)
-         components_sync_cond_t        _componentsSyncCond;     //!< Synchronize condition on components
+         PriorityType                  _priority;               //!< Task priority
+         unsigned                      _depth;                  //!< Level (depth) of the task
+         memory_space_id_t             _tiedToLocation;         //!< Thread is tied to a memory location
          WorkDescriptor               *_parent;                 //!< Parent WD in task hierarchy
+         void                         *_data;                   //!< WD data
+         WDPool                       *_myQueue;                //!< Allows dequeuing from third party (e.g. Cilk schedulers)
+         BaseThread                   *_tiedTo;                 //!< Thread is tied to base thread
+         DeviceData                  **_devices;                //!< Supported devices for this workdescriptor
+         Slicer                       *_slicer;                 //! Related slicer (NULL if does'nt apply)
+         ScheduleWDData               *_scheduleData;           //!< Data set by the scheduling policy
+         void                         *_wdData;                 //!< Internal WD data. Allowing higher layer to associate data to WD
+         DOSubmit                     *_doSubmit;               //!< DependableObject representing this WD in its parent's depsendencies domain
+         DependenciesDomain           *_depsDomain;             //!< Dependences domain. Each WD has one where DependableObjects can be submitted            //!< Directory to mantain cache coherence
+         WorkDescriptorPtrList        *_commutativeOwners;      //!< Array of commutative target owners
+         size_t                        _numCopies;              //!< Copy-in / Copy-out data
+         CopyData                     *_copies;                 //!< Copy-in / Copy-out data
+         ColdData                     *_coldData;               //!< Rarely used fields (NULL until first needed)
+         /* Cold fields */
+         GenericSyncCond              *_syncCond;               //!< Generic synchronize condition
+         nanos_translate_args_t        _translateArgs;          //!< Translates the addresses in _data to the ones obtained by get_address()
+         int                           _numaNode;               //!< FIXME:scheduler data. The NUMA node this WD was assigned to
+         int                           _hostId;                 //!< Work descriptor identifier @ host
+         bool                          _copiesNotInChunk;       //!< States whether the buffer of the copies is allocated in the chunk of the WD
+         bool                          _reachedTaskwait;
+         components_sync_cond_t        _componentsSyncCond;     //!< Synchronize condition on components
          WorkDescriptor               *_forcedParent;           //!< Forced parent, it will be not notified when finishing
          size_t                        _data_size;              //!< WD data size
          size_t                        _data_align;             //!< WD data alignment
-         void                         *_data;                   //!< WD data
          size_t                        _totalSize;              //!< Chunk total size, when allocating WD + extra data
-         void                         *_wdData;                 //!< Internal WD data. Allowing higher layer to associate data to WD
-         ScheduleWDData               *_scheduleData;           //!< Data set by the scheduling policy
-         WDFlags                       _flags;                  //!< WD Flags
-         BaseThread                   *_tiedTo;                 //!< Thread is tied to base thread
-         memory_space_id_t             _tiedToLocation;         //!< Thread is tied to a memory location
-         State                         _state;                  //!< Workdescriptor current state
-         GenericSyncCond              *_syncCond;               //!< Generic synchronize condition
-         WDPool                       *_myQueue;                //!< Allows dequeuing from third party (e.g. Cilk schedulers)
-         unsigned                      _depth;                  //!< Level (depth) of the task
-         unsigned char                 _numDevices;             //!< Number of suported devices for this workdescriptor
-         DeviceData                  **_devices;                //!< Supported devices for this workdescriptor
-         unsigned char                 _activeDeviceIdx;        //!< In _devices, index where we can find the current active DeviceData (if any)
 #ifdef GPU_DEV
          int                           _cudaStreamIdx;          //!< FIXME: Only used in CUDA tasks, should not be here...
 #endif
-         size_t                        _numCopies;              //!< Copy-in / Copy-out data
-         CopyData                     *_copies;                 //!< Copy-in / Copy-out data
          size_t                        _paramsSize;             //!< Total size of WD's parameters
          unsigned long                 _versionGroupId;         //!< The way to link different implementations of a task into the same group
          double                        _executionTime;          //!< FIXME:scheduler data. WD starting wall-clock time, accounting data transfers
          double                        _estimatedExecTime;      //!< FIXME:scheduler data. WD estimated execution time, accounting data transfers
-         DOSubmit                     *_doSubmit;               //!< DependableObject representing this WD in its parent's depsendencies domain
          LazyInit<DOWait>              _doWait;                 //!< DependableObject used by this task to wait on dependencies
-         DependenciesDomain           *_depsDomain;             //!< Dependences domain. Each WD has one where DependableObjects can be submitted            //!< Directory to mantain cache coherence
-         nanos_translate_args_t        _translateArgs;          //!< Translates the addresses in _data to the ones obtained by get_address()
-         PriorityType                  _priority;               //!< Task priority
          CommutativeOwnerMap          *_commutativeOwnerMap;    //!< Map from commutative target address to owner pointer
-         WorkDescriptorPtrList        *_commutativeOwners;      //!< Array of commutative target owners
-         int                           _numaNode;               //!< FIXME:scheduler data. The NUMA node this WD was assigned to
-         bool                          _copiesNotInChunk;       //!< States whether the buffer of the copies is allocated in the chunk of the WD
          const char                   *_description;            //!< WorkDescriptor description, usually user function name
          InstrumentationContextData    _instrumentationContextData; //!< Instrumentation Context Data (empty if no instr. enabled)
-         Slicer                       *_slicer;                 //! Related slicer (NULL if does'nt apply)
-         task_reduction_vector_t       _taskReductions;         //< Vector of task reductions
          int                           _criticality;
          //Atomic< std::list<GraphEntry *> * > _myGraphRepList;
          //bool _listed;
-         void                        (*_notifyCopy)( WD &wd, BaseThread const &thread);
-         BaseThread const             *_notifyThread;
-         void const                   *_remoteAddr;
-         void                         *_callback;
-         void                         *_arguments;
          std::vector<WorkDescriptor *>*_submittedWDs;
-         bool                          _reachedTaskwait;
       public:
-         int                           _schedValues[8];
-         std::map<memory_space_id_t,unsigned int>   _schedPredecessorLocs;
          MemController                 _mcontrol;
       private: /* private methods */
          /*! \brief WorkDescriptor copy assignment operator (private)
@@ -289,6 +305,9 @@ typedef std::set<const Device *>  DeviceList;
 
          //! \brief Adding current WD as descendant of parent (private method)
          void addToGroup ( WorkDescriptor &parent );
+
+         //! \brief Returns the cold data, allocating it on first use
+         ColdData & getColdData ();
       public: /* public methods */
          /*! \brief WorkDescriptor constructor - 1
           */
@@ -718,6 +737,14 @@ typedef std::set<const Device *>  DeviceList;
          void setRemoteAddr( void const *addr );
          void const *getRemoteAddr() const;
 
+         //! \brief Cluster locality scheduling values (allocates the cold data if needed)
+         int * getSchedValues ();
+         //! \brief Locations of the predecessors, used by the cluster locality scheduling (allocates the cold data if needed)
+         std::map<memory_space_id_t,unsigned int> & getSchedPredecessorLocs ();
+
+         //! \brief Returns the size of the hot part of the WorkDescriptor layout
+         size_t getHotDataSize () const;
+
          /*! \brief Sets a WorkDescriptor to an invalid state or not depending on the flag value.
              If invalid (flag = true) it propagates upwards to the ancestors until
              no more ancestors exist or a recoverable task is found.
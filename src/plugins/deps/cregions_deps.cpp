@@ -22,167 +22,62 @@
 #include "system.hpp"
 #include "config.hpp"
 #include "depsregion.hpp"
+#include "intervaltree.hpp"
 #include "compatibility.hpp"
 #include <vector>
-#include <map>
 
 namespace nanos {
    namespace ext {
-       
-       
-      class CRegionsPair {
-          private:
-          
-            std::vector< TrackableObject* > * _trackableObjs;
-            unsigned int _itNum;
-          
-          public:
-
-            CRegionsPair(std::vector< TrackableObject* > * trackableObjs, unsigned int itNum):
-             _trackableObjs(trackableObjs) , _itNum(itNum){}
-              
-            unsigned int getItNum() const {
-                return _itNum;
-            }
-
-            void setItNum(unsigned int itNum) {
-                this->_itNum = itNum;
-            }
-
-            std::vector<TrackableObject*>* getTrackableObjs() const {
-                return _trackableObjs;
-            }
-
-            void setTrackableObjs(std::vector<TrackableObject*>* trackableObjs) {
-                this->_trackableObjs = trackableObjs;
-            } 
-
-          
-      };
 
       class CRegionsDependenciesDomain : public BaseDependenciesDomain
       {
          private:
-            typedef std::vector< std::pair < DepsRegion, TrackableObject*> > DepsVector; /**< Maps addresses to Trackable objects */
-            typedef std::map< DepsRegion, CRegionsPair* > DepsCacheMap; /**< Maps addresses to Trackable objects */
-            typedef std::map< DepsRegion, TrackableObject* > TrackablesMap; /**< Maps addresses to Trackable objects */
-            typedef std::map< DepsRegion, TrackableObject* > SizesMap; /**< Maps addresses to Trackable objects */
+            typedef IntervalTree< DepsRegion::TargetType, TrackableObject* > DepsTree; /**< Maps regions to Trackable objects */
+
+            /*! \brief Deletes the TrackableObjects of a DepsTree */
+            struct DeleteTrackable {
+               void operator() ( DepsRegion::TargetType low, DepsRegion::TargetType high, TrackableObject *status ) { delete status; }
+            };
+
+            /*! \brief Inserts the regions of a DepsTree in another one */
+            struct CopyRegion {
+               DepsTree &_regions;
+               CopyRegion ( DepsTree &regions ) : _regions( regions ) {}
+               void operator() ( DepsRegion::TargetType low, DepsRegion::TargetType high, TrackableObject *status ) { _regions.insert( low, high, status ); }
+            };
 
          private:
-            DepsVector _addressDependencyVector; /**< Used to track dependencies between DependableObject */
-            DepsCacheMap _addressDependencyCache; /**< Used to track dependencies between DependableObject */
-            SizesMap _addressDependencySmall;
-            SizesMap _addressDependencyMid;
-            const size_t _sizeThresholdSmall;
-            const size_t _sizeThresholdMid;
+            DepsTree _regions; /**< Used to track dependencies between DependableObject, one TrackableObject per distinct region */
          private:
-            /*! \brief Looks for the dependency's address in the domain and returns the trackableObject associated.
-             *  \param dep Dependency to be checked.
+            /*! \brief Looks for the region in the domain and returns the trackableObjects associated.
+             *  \param target Region to be checked.
+             *  \param result The TrackableObject of the region itself followed by the ones of every other overlapping region.
              *  \sa Dependency TrackableObject
              */
             void lookupDependency ( const DepsRegion& target, std::vector<TrackableObject* > * result  )
             {
-               
-//               DepsMap::iterator it = _addressDependencyMap.find( target ); 
-//               if ( it == _addressDependencyMap.end() ) {
-//               } else {
-//                  status = it->second;
-//               }               unsigned int vectorIdx = 0;
-               unsigned int vectorIdx = 0;
-               
-               DepsCacheMap::iterator itCache = _addressDependencyCache.find( target ); 
-               std::vector<TrackableObject* > * objs;
-               unsigned int vectorEnd=_addressDependencyVector.size();
-               //If object not in cache, its new, initialize empty cache
-               //And address Maps
-               TrackableObject* currStatus = NULL;
-               bool hasToInsert=itCache == _addressDependencyCache.end();
-               if ( hasToInsert ) { 
-                   std::vector<TrackableObject*>* new_objs=NEW std::vector<TrackableObject*>();
-                   currStatus = NEW TrackableObject();
-                   new_objs->push_back(currStatus);
-                   if (target.getSize() > _sizeThresholdMid ) {
-                      _addressDependencyVector.push_back( std::make_pair( target, currStatus ) );
-                   }
-                   CRegionsPair* pair=NEW CRegionsPair(new_objs, 0);
-                   itCache=_addressDependencyCache.insert( std::make_pair( target, pair ) ).first;
-               }
-               CRegionsPair* cacheItem= itCache->second;
-               objs=cacheItem->getTrackableObjs();
-               vectorIdx=cacheItem->getItNum();
-               //Update cache position marker to the end of the vector
-               cacheItem->setItNum(_addressDependencyVector.size());
-               
-               //Search in dependency vector
-               for ( ; vectorIdx < vectorEnd ; ++vectorIdx ) {
-                   std::pair < DepsRegion, TrackableObject*> item=_addressDependencyVector.at(vectorIdx);
-                   if ( item.first.overlap(target) ) {
-                        objs->push_back(item.second); 
-                   } 
+               TrackableObject **found = _regions.find( target.getAddress(), target.getEndAddress() );
+               TrackableObject *status;
+               if ( found == NULL ) {
+                  status = NEW TrackableObject();
+                  _regions.insert( target.getAddress(), target.getEndAddress(), status );
+               } else {
+                  status = *found;
                }
-               (*result)=*objs;
-               //std::cout << _addressDependencyVector.size() << "," << target.getSize() << "\n";
-               
-               //return *objs;
-                if (target.getSize() <= _sizeThresholdSmall ) {
-                    if ( hasToInsert ){
-                       _addressDependencySmall.insert( std::make_pair( target, currStatus ) );
-                    }
-                }
 
-                if (target.getSize() > _sizeThresholdSmall && target.getSize() <= _sizeThresholdMid ) {
-                    if ( hasToInsert ){
-                       _addressDependencyMid.insert( std::make_pair( target, currStatus ) );
-                    }
-                }
-                
-                {
-                    
-                    //result contains the matches with the "big "arrays"
-                    //Now deal with the small ones
-                    //All the addresses starting lower than startAddr-threshold do not collide
-                    void* startAddress=(void*)(((uint64_t)target.getAddress())-(_sizeThresholdSmall+1));
-                    DepsRegion startAddr(startAddress,startAddress);
-                    //All the addresses starting higher than endAddr do not collide
-                    DepsRegion finalAddr(target.getEndAddress(),target.getEndAddress());
-                    SizesMap::iterator startingIter=_addressDependencySmall.lower_bound(startAddr);
-                    SizesMap::iterator endIter=_addressDependencySmall.upper_bound(finalAddr);
-                    for ( ; startingIter!=_addressDependencySmall.end() && startingIter != endIter; ++startingIter ) {
-                        if ( startingIter->first.overlap(target) ) {
-                             result->push_back(startingIter->second); 
-                        } 
-                    }
-                }
+               result->clear();
+               result->push_back( status );
+               _regions.findOverlaps( target.getAddress(), target.getEndAddress(), *result );
 
-                {
-                    //result contains the matches with the "small and big "arrays"
-                    //Now deal with the mid ones
-                    //All the addresses starting lower than startAddr-threshold do not collide
-                    void* startAddress=(void*)(((uint64_t)target.getAddress())-(_sizeThresholdMid+1));
-                    DepsRegion startAddr(startAddress,startAddress);
-                    //All the addresses starting higher than endAddr do not collide
-                    DepsRegion finalAddr(target.getEndAddress(),target.getEndAddress());
-                    SizesMap::iterator startingIter=_addressDependencyMid.lower_bound(startAddr);
-                    SizesMap::iterator endIter=_addressDependencyMid.upper_bound(finalAddr);
-                    for ( ; startingIter!=_addressDependencyMid.end() && startingIter != endIter; ++startingIter ) {
-                        if ( startingIter->first.overlap(target) ) {
-                             result->push_back(startingIter->second); 
-                        } 
-                    }
-                }
-            }
-            /**
-             * Iterate over addresses... this method is rarely used
-             * @param target
-             * @return 
-             */
-            DepsVector::iterator findAddrInAddressDependencyMap( const DepsRegion& target ) {   
-               for ( DepsVector::iterator it = _addressDependencyVector.begin(); it != _addressDependencyVector.end(); ++it ) {
-                   if (it->first==target) return it;
+               // The region overlaps itself, leave it only in the first position
+               for ( std::vector<TrackableObject*>::iterator it = result->begin() + 1; it != result->end(); ++it ) {
+                  if ( *it == status ) {
+                     result->erase( it );
+                     break;
+                  }
                }
-               return _addressDependencyVector.end();
             }
-            
+
          protected:
             /*! \brief Assigns the DependableObject depObj an id in this domain and adds it to the domains dependency system.
              *  \param depObj DependableObject to be added to the domain.
@@ -362,26 +257,29 @@ namespace nanos {
             }
 
          public: 
-            CRegionsDependenciesDomain() : BaseDependenciesDomain(), _addressDependencyVector(), _addressDependencyCache(),
-                    _addressDependencySmall(), _addressDependencyMid() ,_sizeThresholdSmall( 500 ),
-            _sizeThresholdMid( 200000 ){
-                _addressDependencyVector.reserve(5000);
-            }
+            CRegionsDependenciesDomain() : BaseDependenciesDomain(), _regions() {}
             CRegionsDependenciesDomain ( const CRegionsDependenciesDomain &depDomain )
-               : BaseDependenciesDomain( depDomain ),
-               _addressDependencyVector ( depDomain._addressDependencyVector ), _addressDependencyCache( depDomain._addressDependencyCache ),
-               _addressDependencySmall( depDomain._addressDependencySmall ), _addressDependencyMid( depDomain._addressDependencyMid ),
-               _sizeThresholdSmall ( depDomain._sizeThresholdSmall ),_sizeThresholdMid ( depDomain._sizeThresholdMid ) {}
+               : BaseDependenciesDomain( depDomain ), _regions()
+            {
+               CopyRegion copy( _regions );
+               depDomain._regions.forEach( copy );
+            }
             
             ~CRegionsDependenciesDomain()
             {
-               for ( DepsCacheMap::iterator it = _addressDependencyCache.begin(); it != _addressDependencyCache.end(); it++ ) {
-                  delete it->second->getTrackableObjs();
-                  delete it->second;
-               }
-               for ( DepsVector::iterator it = _addressDependencyVector.begin(); it != _addressDependencyVector.end(); it++ ) {
-                  delete it->second;
-               }
+               DeleteTrackable deleteTrackable;
+               _regions.forEach( deleteTrackable );
+            }
+
+            //! \brief Clear current dependencies domain
+            //!
+            //! This function should be called withing a thread safe area. It is, when other
+            //! tasks can not update the domain: after a taskwait and before any task submission.
+            void clearDependenciesDomain ( void )
+            {
+               DeleteTrackable deleteTrackable;
+               _regions.forEach( deleteTrackable );
+               _regions.clear();
             }
             
             /*!
@@ -407,15 +305,8 @@ namespace nanos {
             bool haveDependencePendantWrites ( void *addr )
             {
                SyncRecursiveLockBlock lock1( getInstanceLock() );                
-               DepsRegion address( addr, addr );
-               DepsVector::iterator it = findAddrInAddressDependencyMap( address );
-               if ( it == _addressDependencyVector.end() ) {
-                  return false;
-               } else {
-                  TrackableObject* status = it->second;
-                  DependableObject *lastWriter = status->getLastWriter();
-                  return (lastWriter != NULL);
-               }
+               TrackableObject **status = _regions.find( addr, addr );
+               return status != NULL && (*status)->getLastWriter() != NULL;
             }
             
          
@@ -24,25 +24,207 @@
 #include "address.hpp"
 #include "compatibility.hpp"
 
+#include <vector>
+#include <map>
+#include <set>
+
 namespace nanos {
    namespace ext {
 
+      /*! \brief Pool of TrackableObjects owned by a dependencies domain
+       *
+       *  Objects are carved out of fixed-size slabs and returned to the pool
+       *  when the domain is cleared (i.e. after a taskwait), so steady state
+       *  submission does not reach the heap. Only the thread running the
+       *  domain owner WD allocates or releases objects.
+       */
+      class TrackableObjectPool
+      {
+         private:
+            static const size_t _slabSize = 64;   /**< Objects per slab */
+
+            std::vector<TrackableObject *>   _free;  /**< Released objects, ready to be reused */
+            std::vector<char *>              _slabs; /**< Raw memory of every slab */
+
+            /* disable copy and assigment */
+            TrackableObjectPool ( const TrackableObjectPool & );
+            const TrackableObjectPool & operator= ( const TrackableObjectPool & );
+         public:
+            TrackableObjectPool () : _free(), _slabs() {}
+
+            ~TrackableObjectPool ()
+            {
+               for ( std::vector<char *>::iterator it = _slabs.begin(); it != _slabs.end(); it++ ) {
+                  delete[] *it;
+               }
+            }
+
+            TrackableObject * allocate ( void )
+            {
+               if ( _free.empty() ) {
+                  char *slab = NEW char[ _slabSize * sizeof( TrackableObject ) ];
+                  _slabs.push_back( slab );
+                  for ( size_t i = _slabSize; i > 0; i-- ) {
+                     _free.push_back( ( TrackableObject * ) ( slab + ( i - 1 ) * sizeof( TrackableObject ) ) );
+                  }
+               }
+               TrackableObject *obj = _free.back();
+               _free.pop_back();
+               return new ( obj ) TrackableObject();
+            }
+
+            void release ( TrackableObject *obj )
+            {
+               obj->~TrackableObject();
+               _free.push_back( obj );
+            }
+      };
+
       class PlainDependenciesDomain : public BaseDependenciesDomain
       {
          private:
             typedef TR1::unordered_map<Address::TargetType, TrackableObject*> DepsMap; /**< Maps addresses to Trackable objects */
-            
+
+            static const size_t _numShardsShift = 4;
+            static const size_t _numShards = 1 << _numShardsShift; /**< Number of address map shards (power of two) */
+
+            /*! \brief Part of the address map protected by its own lock
+             */
+            struct DepsShard {
+               Lock     _lock;    /**< Protects _map against concurrent lookups (finishing tasks) and insertions */
+               DepsMap  _map;     /**< Addresses that hash to this shard */
+               DepsShard () : _lock(), _map() {}
+            };
+
+            /*! \brief Data access of a dependence graph region, with the TrackableObject it was resolved to
+             */
+            struct RecordedAccess {
+               Address::TargetType  _address;
+               AccessType           _flags;
+               TrackableObject     *_status;
+            };
+
+            typedef std::vector<RecordedAccess> RecordedGraph;                 /**< Accesses of a region, in submission order */
+            typedef std::map<const void *, RecordedGraph> RecordedGraphMap;    /**< Recorded regions by key */
+
          private:
-            DepsMap _addressDependencyMap; /**< Used to track dependencies between DependableObject */
+            DepsShard            *_shards;   /**< Used to track dependencies between DependableObject, allocated at first use */
+            TrackableObjectPool   _pool;     /**< TrackableObjects of this domain */
+            RecordedGraphMap      _graphs;   /**< Recorded dependence graph regions */
+            RecordedGraph        *_graph;    /**< Region being run, NULL if none */
+            size_t                _cursor;   /**< Next access of the region being run */
+            bool                  _graphChanged; /**< The region being run did not match its recording */
+            int                   _graphDepth;   /**< Nesting level of regions (only the outermost one is recorded) */
+            std::set<TrackableObject *> _pinned; /**< TrackableObjects referenced by recorded regions */
          private:
 
+            //! \brief Whether two data accesses have the same access type
+            static bool sameAccessType ( AccessType const &a, AccessType const &b )
+            {
+               return a.input == b.input && a.output == b.output && a.can_rename == b.can_rename &&
+                      a.concurrent == b.concurrent && a.commutative == b.commutative;
+            }
+
+            //! \brief Collects the TrackableObjects referenced by the recorded regions
+            void pinRecordedObjects ( void )
+            {
+               _pinned.clear();
+               for ( RecordedGraphMap::iterator it = _graphs.begin(); it != _graphs.end(); it++ ) {
+                  for ( RecordedGraph::iterator acc = it->second.begin(); acc != it->second.end(); acc++ ) {
+                     _pinned.insert( acc->_status );
+                  }
+               }
+            }
+
+            //! \brief Returns the shard an address belongs to
+            DepsShard & getShard ( Address::TargetType target ) const
+            {
+               uint64_t key = ( uint64_t ) ( uintptr_t ) target;
+               key = ( key >> 3 ) * 0x9E3779B97F4A7C15ULL;
+               return _shards[ key >> ( 64 - _numShardsShift ) ];
+            }
+
+            //! \brief Looks for the TrackableObject of an address
+            //! \return The TrackableObject, or NULL if the address has never been accessed
+            TrackableObject * findDependency ( Address::TargetType target ) const
+            {
+               if ( _shards == NULL ) return NULL;
+
+               DepsShard &shard = getShard( target );
+               SyncLockBlock lock( shard._lock );
+               DepsMap::iterator it = shard._map.find( target );
+               return it != shard._map.end() ? it->second : NULL;
+            }
+
+            //! \brief Releases every TrackableObject of the domain to the pool
+            void releaseAll ( void )
+            {
+               if ( _shards == NULL ) return;
+
+               for ( size_t i = 0; i < _numShards; i++ ) {
+                  DepsMap &map = _shards[i]._map;
+                  for ( DepsMap::iterator it = map.begin(); it != map.end(); it++ ) {
+                     _pool.release( it->second );
+                  }
+                  map.clear();
+               }
+            }
+
             //! \brief Clear current dependencies domain
             //!
             //! This function should be called withing a thread safe area. It is, when other
             //! tasks can not update the domain: after a taskwait and before any task submission.
+            //! TrackableObjects are reclaimed by the domain pool, except the ones referenced by
+            //! recorded dependence graph regions (they are idle at this point and will be reused).
             void clearDependenciesDomain ( void )
             {
-               _addressDependencyMap.clear(); 
+               if ( _pinned.empty() ) {
+                  releaseAll();
+                  return;
+               }
+               if ( _shards == NULL ) return;
+
+               for ( size_t i = 0; i < _numShards; i++ ) {
+                  DepsMap &map = _shards[i]._map;
+                  for ( DepsMap::iterator it = map.begin(); it != map.end(); ) {
+                     if ( _pinned.count( it->second ) == 0 ) {
+                        _pool.release( it->second );
+                        map.erase( it++ );
+                     } else {
+                        it++;
+                     }
+                  }
+               }
+            }
+
+            //! \brief Resolves the TrackableObject of a data access
+            //!
+            //! Inside a dependence graph region, the access is checked against the recording: if it
+            //! matches, the recorded TrackableObject is used; otherwise it is looked up and the rest
+            //! of the recording is replaced from this access on.
+            TrackableObject* resolveDependency ( const Address& target, AccessType const &accessType )
+            {
+               if ( _graph == NULL ) return lookupDependency( target );
+
+               if ( _cursor < _graph->size() ) {
+                  RecordedAccess &acc = (*_graph)[_cursor];
+                  if ( acc._address == target() && sameAccessType( acc._flags, accessType ) ) {
+                     _cursor++;
+                     return acc._status;
+                  }
+                  _graph->resize( _cursor );
+               }
+
+               RecordedAccess acc;
+               acc._address = target();
+               acc._flags = accessType;
+               acc._status = lookupDependency( target );
+               _graph->push_back( acc );
+               _pinned.insert( acc._status );
+               _cursor++;
+               _graphChanged = true;
+
+               return acc._status;
             }
 
             //! \brief Looks for the dependency's address, returns the trackableObject associated
@@ -50,22 +232,19 @@ namespace nanos {
             //! \sa Dependency TrackableObject
             TrackableObject* lookupDependency ( const Address& target )
             {
-               TrackableObject* status = NULL;
-               
-               DepsMap::iterator it = _addressDependencyMap.find( target() ); 
-
-               if ( it == _addressDependencyMap.end() ) {
-                   status = NEW TrackableObject();
-                   {
-                      // Lock this so we avoid problems when concurrently calling deleteLastWriter
-                      // due this function will also chase also the map
-                      SyncRecursiveLockBlock lock1( getInstanceLock() );
-                      _addressDependencyMap.insert( std::make_pair( target(), status ) );
-                   }
-               } else {
-                  status = it->second;
-               }
-               
+               // Only the domain owner submits, so it is the only one allocating shards and objects.
+               // Finishing tasks just look up existing entries, holding the shard lock.
+               if ( _shards == NULL ) _shards = NEW DepsShard[_numShards];
+
+               DepsShard &shard = getShard( target() );
+               SyncLockBlock lock( shard._lock );
+
+               DepsMap::iterator it = shard._map.find( target() );
+               if ( it != shard._map.end() ) return it->second;
+
+               TrackableObject *status = _pool.allocate();
+               shard._map.insert( std::make_pair( target(), status ) );
+
                return status;
             }
          protected:
@@ -128,7 +307,7 @@ namespace nanos {
 
                ensure(!(accessType.concurrent && accessType.commutative),"Task cannot be concurrent AND commutative");
 
-               TrackableObject &status = *lookupDependency( target );
+               TrackableObject &status = *resolveDependency( target, accessType );
 
                if ( status.getLastWriter() == &depObj ) return;
 
@@ -157,60 +336,58 @@ namespace nanos {
             inline void deleteLastWriter ( DependableObject &depObj, BaseDependency const &target )
             {
                const Address& address( static_cast<const Address&>( target ) );
-               SyncRecursiveLockBlock lock1( getInstanceLock() );
-               DepsMap::iterator it = _addressDependencyMap.find( address() );
-               
-               if ( it != _addressDependencyMap.end() ) {
-                  TrackableObject &status = *it->second;
-                  
-                  status.deleteLastWriter(depObj);
-               }
+               TrackableObject *status = findDependency( address() );
+
+               if ( status != NULL ) status->deleteLastWriter( depObj );
             }
             
             
             inline void deleteReader ( DependableObject &depObj, BaseDependency const &target )
             {
                const Address& address( static_cast<const Address&>( target ) );
-               SyncRecursiveLockBlock lock1( getInstanceLock() );
-               DepsMap::iterator it = _addressDependencyMap.find( address() );
-               
-               if ( it != _addressDependencyMap.end() ) {
-                  TrackableObject &status = *it->second;
-                  
-                  {
-                     SyncLockBlock lock2( status.getReadersLock() );
-                     status.deleteReader(depObj);
-                  }
+               TrackableObject *status = findDependency( address() );
+
+               if ( status != NULL ) {
+                  SyncLockBlock lock2( status->getReadersLock() );
+                  status->deleteReader( depObj );
                }
             }
             
             inline void removeCommDO ( CommutationDO *commDO, BaseDependency const &target )
             {
                const Address& address( static_cast<const Address&>( target ) );
-               SyncRecursiveLockBlock lock1( getInstanceLock() );
-               DepsMap::iterator it = _addressDependencyMap.find( address() );
-               
-               if ( it != _addressDependencyMap.end() ) {
-                  TrackableObject &status = *it->second;
-                  
-                  if ( status.getCommDO ( ) == commDO ) {
-                     status.setCommDO ( 0 );
-                  }
+               TrackableObject *status = findDependency( address() );
+
+               if ( status != NULL && status->getCommDO() == commDO ) {
+                  status->setCommDO( 0 );
                }
             }
 
          public:
-            PlainDependenciesDomain() : BaseDependenciesDomain(), _addressDependencyMap() {}
+            PlainDependenciesDomain() : BaseDependenciesDomain(), _shards( NULL ), _pool(), _graphs(), _graph( NULL ),
+                                        _cursor( 0 ), _graphChanged( false ), _graphDepth( 0 ), _pinned() {}
             PlainDependenciesDomain ( const PlainDependenciesDomain &depDomain )
-               : BaseDependenciesDomain( depDomain ),
-               _addressDependencyMap ( depDomain._addressDependencyMap ) {}
-            
-            ~PlainDependenciesDomain()
+               : BaseDependenciesDomain( depDomain ), _shards( NULL ), _pool(), _graphs(), _graph( NULL ),
+                 _cursor( 0 ), _graphChanged( false ), _graphDepth( 0 ), _pinned()
             {
-               for ( DepsMap::iterator it = _addressDependencyMap.begin(); it != _addressDependencyMap.end(); it++ ) {
-                  delete it->second;
+               if ( depDomain._shards == NULL ) return;
+
+               _shards = NEW DepsShard[_numShards];
+               for ( size_t i = 0; i < _numShards; i++ ) {
+                  DepsMap &map = depDomain._shards[i]._map;
+                  for ( DepsMap::iterator it = map.begin(); it != map.end(); it++ ) {
+                     TrackableObject *status = _pool.allocate();
+                     *status = *it->second;
+                     _shards[i]._map.insert( std::make_pair( it->first, status ) );
+                  }
                }
             }
+
+            ~PlainDependenciesDomain()
+            {
+               releaseAll();
+               delete[] _shards;
+            }
             
             /*!
              *  \note This function cannot be implemented in
@@ -232,39 +409,71 @@ namespace nanos {
                submitDependableObjectInternal ( depObj, deps, deps+numDeps, callback );
             }
 
-            bool haveDependencePendantWrites ( void *addr )
+            //! \brief Starts running a dependence graph region
+            //!
+            //! The first run records the resolved data accesses, the following ones reuse them
+            //! while the submitted tasks access the same addresses in the same way.
+            void beginGraphRegion ( const void *key )
             {
-               DepsMap::iterator it = _addressDependencyMap.find( addr ); 
-               if ( it == _addressDependencyMap.end() ) {
-                  return false;
-               } else {
-                  TrackableObject* status = it->second;
-                  DependableObject *lastWriter = status->getLastWriter();
-                  return (lastWriter != NULL);
+               if ( _graphDepth++ > 0 ) return;
+
+               _graph = &_graphs[key];
+               _cursor = 0;
+               _graphChanged = false;
+            }
+
+            //! \brief Ends the dependence graph region being run
+            void endGraphRegion ( void )
+            {
+               if ( _graphDepth == 0 ) {
+                  warning0( "Ending a dependence graph region that was not started" );
+                  return;
+               }
+               if ( --_graphDepth > 0 ) return;
+
+               // A shorter run than the recording also changes it
+               if ( _cursor < _graph->size() ) {
+                  _graph->resize( _cursor );
+                  _graphChanged = true;
                }
+               // Drop the pins of the accesses that were replaced
+               if ( _graphChanged ) pinRecordedObjects();
+
+               _graph = NULL;
+            }
+
+            bool haveDependencePendantWrites ( void *addr )
+            {
+               TrackableObject *status = findDependency( addr );
+               return status != NULL && status->getLastWriter() != NULL;
             }
             void finalizeAllReductions ( void )
             {
-               DepsMap::iterator it; 
-               for ( it = _addressDependencyMap.begin(); it != _addressDependencyMap.end(); it++ ) {
-                  TrackableObject& status = *( it->second );
-                  Address::TargetType target = it->first;
-                  CommutationDO *commDO = status.getCommDO();
-                  if ( commDO != NULL ) {
-                     status.setCommDO( NULL );
-                     status.setLastWriter( *commDO );
-
-                     TaskReduction *tr = myThread->getCurrentWD()->getTaskReduction( (const void *) target );
-                     if ( tr != NULL ) {
-                        if ( myThread->getCurrentWD()->getDepth() == tr->getDepth() )
-							commDO->setTaskReduction( tr );
-                     }
+               if ( _shards == NULL ) return;
 
-                     commDO->resetReferences();
+               //! \note Not holding the shard locks: releasing a CommutationDO may end up in removeCommDO()
+               for ( size_t i = 0; i < _numShards; i++ ) {
+                  DepsMap &map = _shards[i]._map;
+                  for ( DepsMap::iterator it = map.begin(); it != map.end(); it++ ) {
+                     TrackableObject& status = *( it->second );
+                     Address::TargetType target = it->first;
+                     CommutationDO *commDO = status.getCommDO();
+                     if ( commDO != NULL ) {
+                        status.setCommDO( NULL );
+                        status.setLastWriter( *commDO );
 
-                     //! Finally decrease dummy dependence added in createCommutationDO
-                     std::list<uint64_t> flushDeps;
-                     commDO->decreasePredecessors( &flushDeps, NULL, false, false ); 
+                        TaskReduction *tr = myThread->getCurrentWD()->getTaskReduction( (const void *) target );
+                        if ( tr != NULL ) {
+                           if ( myThread->getCurrentWD()->getDepth() == tr->getDepth() )
+                              commDO->setTaskReduction( tr );
+                        }
+
+                        commDO->resetReferences();
+
+                        //! Finally decrease dummy dependence added in createCommutationDO
+                        std::list<uint64_t> flushDeps;
+                        commDO->decreasePredecessors( &flushDeps, NULL, false, false ); 
+                     }
                   }
                }
             }
@@ -115,7 +115,7 @@ namespace nanos {
          public:
             using SchedulePolicy::queue;
             typedef std::stack<BotLevDOData *>   bot_lev_dos_t;
-            typedef std::set<std::pair< unsigned int, DependableObject * > > DepObjVector; /**< Type vector of successors  */
+            typedef DependableObject::DependableObjectVector DepObjVector; /**< Type vector of successors  */
 
          private:
             bot_lev_dos_t     _blStack;       //! tasks added, pending having their bottom level updated
@@ -31,6 +31,7 @@ namespace nanos {
             using SchedulePolicy::queue;
             static bool       _usePriority;
             static bool       _useSmartPriority;
+            static bool       _useWSDeque;
          private:
             /** \brief DistributedBF Scheduler data associated to each thread
               *
@@ -43,6 +44,7 @@ namespace nanos {
                ThreadData () : ScheduleThreadData(), _readyQueue( NULL )
                {
                  if ( _usePriority || _useSmartPriority ) _readyQueue = NEW WDPriorityQueue<>( true /* enableDeviceCounter */, true /* optimise option */ );
+                 else if ( _useWSDeque ) _readyQueue = NEW WDWorkStealingDeque( true /* enableDeviceCounter */ );
                  else _readyQueue = NEW WDDeque( true /* enableDeviceCounter */ );
                }
                virtual ~ThreadData () { delete _readyQueue; }
@@ -132,6 +134,7 @@ namespace nanos {
                if ( targetThread ) targetThread->addNextWD(&wd);
                else {
                   ThreadData &data = ( ThreadData & ) *thread->getTeamData()->getScheduleData();
+                  data._readyQueue->setOwner( thread );
                   data._readyQueue->push_front( &wd );
                   sys.getThreadManager()->unblockThread(thread);
                }
@@ -236,6 +239,7 @@ namespace nanos {
 
       bool DistributedBFPolicy::_usePriority = true;
       bool DistributedBFPolicy::_useSmartPriority = false;
+      bool DistributedBFPolicy::_useWSDeque = false;
 
       class DistributedBFSchedPlugin : public Plugin
       {
@@ -253,6 +257,9 @@ namespace nanos {
                cfg.registerConfigOption ( "schedule-smart-priority", NEW Config::FlagOption( DistributedBFPolicy::_useSmartPriority ), "Smart priority queue propagates high priorities to predecessors");
                cfg.registerArgOption( "schedule-smart-priority", "schedule-smart-priority" );
 
+               cfg.registerConfigOption ( "schedule-ws-deque", NEW Config::FlagOption( DistributedBFPolicy::_useWSDeque ), "Lock-free work-stealing deque used as ready task queue (when priorities are not used)");
+               cfg.registerArgOption( "schedule-ws-deque", "schedule-ws-deque" );
+
                
             }
 
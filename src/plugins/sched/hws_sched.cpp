@@ -0,0 +1,288 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#include "schedule.hpp"
+#include "wddeque.hpp"
+#include "plugin.hpp"
+#include "system.hpp"
+#include "smpdd.hpp"
+
+#include <vector>
+
+namespace nanos {
+   namespace ext {
+
+      /*! \brief Hierarchical (topology-aware) work-stealing scheduler
+       *
+       *  Each thread owns a ready queue. Idle threads steal from the threads
+       *  sharing their core (SMT siblings) first, then from the threads in
+       *  the same NUMA node/socket and only then from remote NUMA nodes.
+       *  Steals move up to half of the victim queue at once, and the remote
+       *  level is tried less and less often while it keeps being empty.
+       */
+      class HierarchicalWSPolicy : public SchedulePolicy
+      {
+         public:
+            using SchedulePolicy::queue;
+
+            enum StealLevel { SIBLINGS = 0, LOCAL, REMOTE, NUM_LEVELS };
+
+            static bool          _useWSDeque;
+            static int           _maxStealBatch;
+            static int           _maxRemoteBackoff;
+         private:
+            struct ThreadData : public ScheduleThreadData
+            {
+               WDPool              *_readyQueue;                  /**< Ready tasks of this thread */
+               std::vector<int>     _victims[NUM_LEVELS];         /**< Team ids of the victims of each level */
+               int                  _teamSize;                    /**< Team size the victim lists were built for */
+               int                  _remoteBackoff;               /**< Idle calls to skip before trying the remote level */
+               int                  _remoteSkipped;               /**< Idle calls skipped since the last remote attempt */
+               unsigned int         _seed;                        /**< Victim selection seed */
+
+               ThreadData () : ScheduleThreadData(), _readyQueue( NULL ), _teamSize( 0 ),
+                               _remoteBackoff( 0 ), _remoteSkipped( 0 ), _seed( 0 )
+               {
+                  if ( _useWSDeque ) _readyQueue = NEW WDWorkStealingDeque( true /* enableDeviceCounter */ );
+                  else _readyQueue = NEW WDDeque( true /* enableDeviceCounter */ );
+               }
+               virtual ~ThreadData () { delete _readyQueue; }
+            };
+
+            /* disable copy and assigment */
+            explicit HierarchicalWSPolicy ( const HierarchicalWSPolicy & );
+            const HierarchicalWSPolicy & operator= ( const HierarchicalWSPolicy & );
+
+            /*! \brief Fills the victim lists of a thread from the topology of the team members
+             */
+            void buildVictims ( BaseThread *thread, ThreadData &data );
+
+            /*! \brief Tries to steal from the victims of one level
+             *  \return The stolen WD to run (others may have been moved to the thread queue)
+             */
+            WD * stealFrom ( BaseThread *thread, ThreadData &data, StealLevel level );
+
+         public:
+            // constructor
+            HierarchicalWSPolicy() : SchedulePolicy ( "Hierarchical Work-Stealing" ) {}
+
+            // destructor
+            virtual ~HierarchicalWSPolicy() {}
+
+            virtual size_t getTeamDataSize () const { return 0; }
+            virtual size_t getThreadDataSize () const { return sizeof(ThreadData); }
+
+            virtual ScheduleTeamData * createTeamData ()
+            {
+               return 0;
+            }
+
+            virtual ScheduleThreadData * createThreadData ()
+            {
+               return NEW ThreadData();
+            }
+
+            /*!
+            *  \brief Enqueue a work descriptor in the readyQueue of the passed thread
+            *  \param thread pointer to the thread to which readyQueue the task must be appended
+            *  \param wd a reference to the work descriptor to be enqueued
+            *  \sa ThreadData, WD and BaseThread
+            */
+            virtual void queue ( BaseThread *thread, WD &wd )
+            {
+               BaseThread *targetThread = wd.isTiedTo();
+               if ( targetThread ) targetThread->addNextWD(&wd);
+               else {
+                  ThreadData &data = ( ThreadData & ) *thread->getTeamData()->getScheduleData();
+                  data._readyQueue->setOwner( thread );
+                  data._readyQueue->push_front( &wd );
+                  sys.getThreadManager()->unblockThread(thread);
+               }
+            }
+
+            /*!
+            *  \brief Function called when a new task must be created: the new created task
+            *          is directly queued (Breadth-First policy)
+            *  \param thread pointer to the thread to which belongs the new task
+            *  \param wd a reference to the work descriptor of the new task
+            *  \sa WD and BaseThread
+            */
+            virtual WD * atSubmit ( BaseThread *thread, WD &newWD )
+            {
+               queue(thread,newWD);
+
+               return 0;
+            }
+
+            virtual WD *atIdle ( BaseThread *thread, int numSteal );
+
+            bool testDequeue()
+            {
+               ThreadData &data = ( ThreadData & ) *myThread->getTeamData()->getScheduleData();
+               return data._readyQueue->testDequeue();
+            }
+      };
+
+      bool HierarchicalWSPolicy::_useWSDeque = false;
+      int HierarchicalWSPolicy::_maxStealBatch = 16;
+      int HierarchicalWSPolicy::_maxRemoteBackoff = 64;
+
+      void HierarchicalWSPolicy::buildVictims ( BaseThread *thread, ThreadData &data )
+      {
+         ThreadTeam *team = thread->getTeam();
+         int size = team->getFinalSize();
+
+         for ( int level = 0; level < NUM_LEVELS; level++ ) data._victims[level].clear();
+
+         PE *myPE = thread->runningOn();
+         bool mySMP = myPE->supports( getSMPDevice() );
+         int myCore = mySMP ? (int) sys._hwloc.getCoreOfCpu( thread->getCpuId() ) : -1;
+
+         for ( int thid = 0; thid < size; thid++ ) {
+            BaseThread &victim = team->getThread( thid );
+            if ( &victim == thread ) continue;
+
+            PE *pe = victim.runningOn();
+            StealLevel level = REMOTE;
+            if ( mySMP && pe->supports( getSMPDevice() ) && (int) sys._hwloc.getCoreOfCpu( victim.getCpuId() ) == myCore ) {
+               level = SIBLINGS;
+            } else if ( pe->getNumaNode() == myPE->getNumaNode() && pe->getSocket() == myPE->getSocket() ) {
+               level = LOCAL;
+            }
+            data._victims[level].push_back( thid );
+         }
+
+         data._teamSize = size;
+         data._seed = (unsigned int) thread->getId();
+         debug( "HWS: thread " << thread->getId() << " victims: " << data._victims[SIBLINGS].size() << " siblings, "
+                << data._victims[LOCAL].size() << " local, " << data._victims[REMOTE].size() << " remote" );
+      }
+
+      WD * HierarchicalWSPolicy::stealFrom ( BaseThread *thread, ThreadData &data, StealLevel level )
+      {
+         std::vector<int> &victims = data._victims[level];
+         int num = (int) victims.size();
+         if ( num == 0 ) return NULL;
+
+         ThreadTeam *team = thread->getTeam();
+         int start = rand_r( &data._seed ) % num;
+
+         for ( int i = 0; i < num; i++ ) {
+            BaseThread &victim = team->getThread( victims[( start + i ) % num] );
+            if ( victim.getTeam() == NULL ) continue;
+
+            WDPool &queue = *( ( ThreadData & ) *victim.getTeamData()->getScheduleData() )._readyQueue;
+            if ( queue.empty() ) continue;
+
+            WD *wd = queue.pop_back( thread );
+            if ( wd == NULL ) continue;
+
+            // Steal-half: bring more work home while we are touching the victim anyway
+            int batch = std::min( (int) ( queue.size() / 2 ), _maxStealBatch - 1 );
+            for ( int j = 0; j < batch; j++ ) {
+               WD *extra = queue.pop_back( thread );
+               if ( extra == NULL ) break;
+               data._readyQueue->setOwner( thread );
+               data._readyQueue->push_back( extra );
+            }
+            return wd;
+         }
+         return NULL;
+      }
+
+      /*!
+       *  \brief Function called by the scheduler when a thread becomes idle to schedule it
+       *  \param thread pointer to the thread to be scheduled
+       *  \sa BaseThread
+       */
+      WD * HierarchicalWSPolicy::atIdle ( BaseThread *thread, int numSteal )
+      {
+         WorkDescriptor * wd = thread->getNextWD();
+
+         if ( wd ) return wd;
+
+         WorkDescriptor * next = NULL;
+
+         ThreadData &data = ( ThreadData & ) *thread->getTeamData()->getScheduleData();
+
+         //! First try to schedule the thread with a task from its queue
+         if ( ( wd = data._readyQueue->pop_front ( thread ) ) != NULL ) return wd;
+
+         //! If the local queue is empty, try to steal the parent (possibly enqueued in the queue of another thread)
+         if ( ( wd = thread->getCurrentWD()->getParent() ) != NULL ) {
+            WDPool *pq; //!< Parent queue
+            //! Removing it from the queue, if someone move it stop looking for it to avoid ping-pongs
+            if ( (pq = wd->getMyQueue()) != NULL ) {
+               //! Not in queue = in execution, in queue = not in execution
+               if ( pq->removeWD( thread, wd, &next ) ) return next; //!< Found it!
+            }
+         }
+
+         if ( data._teamSize != thread->getTeam()->getFinalSize() ) buildVictims( thread, data );
+
+         //! Steal from the closest victims first
+         if ( ( wd = stealFrom( thread, data, SIBLINGS ) ) != NULL ) return wd;
+         if ( ( wd = stealFrom( thread, data, LOCAL ) ) != NULL ) return wd;
+
+         //! Remote victims are tried with an exponential back-off while they keep being empty
+         if ( data._remoteSkipped < data._remoteBackoff ) {
+            data._remoteSkipped++;
+            return NULL;
+         }
+         data._remoteSkipped = 0;
+
+         if ( ( wd = stealFrom( thread, data, REMOTE ) ) != NULL ) {
+            data._remoteBackoff = 0;
+            return wd;
+         }
+
+         if ( !data._victims[REMOTE].empty() ) {
+            data._remoteBackoff = data._remoteBackoff == 0 ? 1 : std::min( data._remoteBackoff * 2, _maxRemoteBackoff );
+         }
+         return NULL;
+      }
+
+      class HierarchicalWSSchedPlugin : public Plugin
+      {
+         public:
+            HierarchicalWSSchedPlugin() : Plugin( "Hierarchical Work-Stealing scheduling Plugin",1 ) {}
+
+            virtual void config( Config& cfg )
+            {
+               cfg.setOptionsSection( "HWS module", "Hierarchical (topology-aware) work-stealing scheduling module" );
+
+               cfg.registerConfigOption ( "schedule-ws-deque", NEW Config::FlagOption( HierarchicalWSPolicy::_useWSDeque ), "Lock-free work-stealing deque used as ready task queue");
+               cfg.registerArgOption( "schedule-ws-deque", "schedule-ws-deque" );
+
+               cfg.registerConfigOption ( "schedule-steal-batch", NEW Config::PositiveVar( HierarchicalWSPolicy::_maxStealBatch ), "Maximum number of tasks taken from a victim in one steal (16)");
+               cfg.registerArgOption( "schedule-steal-batch", "schedule-steal-batch" );
+
+               cfg.registerConfigOption ( "schedule-remote-backoff", NEW Config::PositiveVar( HierarchicalWSPolicy::_maxRemoteBackoff ), "Maximum number of idle calls between remote NUMA steal attempts (64)");
+               cfg.registerArgOption( "schedule-remote-backoff", "schedule-remote-backoff" );
+            }
+
+            virtual void init() {
+               sys.setDefaultSchedulePolicy(NEW HierarchicalWSPolicy());
+            }
+      };
+
+   }
+}
+
+DECLARE_PLUGIN("sched-hws",nanos::ext::HierarchicalWSSchedPlugin);
@@ -23,45 +23,65 @@
 #include "system.hpp"
 #include "config.hpp"
 
+#include <stdlib.h>
+
 namespace nanos {
    namespace ext {
 
+      /*! \brief Relaxed priority scheduler (MultiQueue)
+       *
+       *  The team owns c x workers priority queues, each one with its own lock.
+       *  Ready tasks are pushed to a random queue and idle threads pop from the
+       *  best of two random queues (the one with the highest top priority), so
+       *  tasks leave in nearly priority order without a team-wide lock.
+       */
       class MultiPriorityQueue : public SchedulePolicy
       {
         private:
            struct TeamData : public ScheduleTeamData
            {
-              WDPool **_readyQueue;
+              WDPriorityQueue<>  *_readyQueues;
+              int                 _numQueues;
 
-              TeamData () : ScheduleTeamData(), _readyQueue()
+              TeamData () : ScheduleTeamData(), _readyQueues( NULL ), _numQueues( 0 )
               {
-                _readyQueue = (WDPool **) malloc(sizeof(WDPool *)* _numQueues);
-                for (int i=0; i<_numQueues; i++)
-                   _readyQueue[i] = NEW WDDeque();
-               //fprintf(stderr,"Nanos++: Max priority = %d, number of queues = %d\n",_maxPriority, _numQueues);
-              }
-              ~TeamData () {
-                 for (int i=0; i<_numQueues; i++)
-                    delete _readyQueue[i];
+                 int workers = std::max( (int) sys.getSMPPlugin()->getMaxWorkers(), sys.getNumWorkers() );
+                 _numQueues = std::max( 1, _queuesPerThread * workers );
+                 _readyQueues = NEW WDPriorityQueue<>[_numQueues];
               }
+              ~TeamData () { delete[] _readyQueues; }
+           };
+
+           struct ThreadData : public ScheduleThreadData
+           {
+              unsigned int        _seed;      /**< Queue selection seed */
+
+              ThreadData () : ScheduleThreadData(), _seed( 0 ) {}
+              virtual ~ThreadData () {}
            };
 
+           /* disable copy and assigment */
+           explicit MultiPriorityQueue ( const MultiPriorityQueue & );
+           const MultiPriorityQueue & operator= ( const MultiPriorityQueue & );
+
+           static int randomQueue ( BaseThread *thread, TeamData &tdata )
+           {
+              ThreadData &data = ( ThreadData & ) *thread->getTeamData()->getScheduleData();
+              if ( data._seed == 0 ) data._seed = (unsigned int) thread->getId() + 1;
+              return rand_r( &data._seed ) % tdata._numQueues;
+           }
+
          public:
-           static bool       _useStack;
-           static bool       _usePriority;
            static bool       _useSmartPriority;
-           static int        _numQueues;
-           static int        _maxPriority;
+           static int        _queuesPerThread;
 
-           MultiPriorityQueue() : SchedulePolicy("Multi Priority Queue") {
-              _usePriority = _usePriority && sys.getPrioritiesNeeded();
-           }
+           MultiPriorityQueue() : SchedulePolicy("Multi Priority Queue") {}
            virtual ~MultiPriorityQueue () {}
 
          private:
             
            virtual size_t getTeamDataSize () const { return sizeof(TeamData); }
-           virtual size_t getThreadDataSize () const { return 0; }
+           virtual size_t getThreadDataSize () const { return sizeof(ThreadData); }
 
            virtual ScheduleTeamData * createTeamData ()
            {
@@ -70,99 +90,55 @@ namespace nanos {
 
            virtual ScheduleThreadData * createThreadData ()
            {
-              return 0;
+              return NEW ThreadData();
            }
 
            virtual void queue ( BaseThread *thread, WD &wd )
            {
-              TeamData &tdata = (TeamData &) *thread->getTeam()->getScheduleData();
-
-              int priority = (int) (wd.getPriority()*(_numQueues-1))/ ((_maxPriority == 0)?1:_maxPriority);
-              if( priority >= _numQueues) {
-                 fprintf(stderr,"Nanox++: Priority value has been saturated\n");
-                 priority = _numQueues-1;
+              BaseThread *targetThread = wd.isTiedTo();
+              if ( targetThread ) {
+                 targetThread->addNextWD( &wd );
+                 return;
               }
 
-              if ( _useStack ) return tdata._readyQueue[priority]->push_front( &wd );
-              else tdata._readyQueue[priority]->push_back( &wd );
+              TeamData &tdata = (TeamData &) *thread->getTeam()->getScheduleData();
+              tdata._readyQueues[randomQueue( thread, tdata )].push_back( &wd );
            }
 
-            virtual void queue ( BaseThread ** threads, WD ** wds, size_t numElems )
-            {
-               fatal_cond( true , "Cannot queue 0 (or N) elements ."); //FIXME
-               
-               // First step: check if all threads have the same team
-               ThreadTeam* team = threads[0]->getTeam();
-               
-               for ( size_t i = 1; i < numElems; ++i )
-               {
-                  if ( threads[i]->getTeam() == team )
-                     continue;
-                  
-                  fatal( "Batch submission does not support different teams" );
-               }
-               
-               // If they have the same team, we can insert in batch
-               TeamData &tdata = (TeamData &) *team->getScheduleData();
-               
-               LockBlock lock( tdata._readyQueue[0]->getLock() );
-               
-               if ( _useStack ) return tdata._readyQueue[0]->push_front( wds, numElems );
-               else tdata._readyQueue[0]->push_back( wds, numElems );
-            }
-            
-            /*! This scheduling policy supports all WDs, no restrictions. */
-            bool isValidForBatch ( const WD * wd ) const
-            {
-               return false;
-            }
+           /*!
+            * \brief This method performs the main task of the smart priority
+            * scheduler, which is to propagate the priority of a WD to its
+            * immediate predecessors. It is meant to be invoked from
+            * DependenciesDomain::submitWithDependenciesInternal.
+            * \param [in/out] predecessor The preceding DependableObject.
+            * \param [in] successor DependableObject whose WD priority has to be
+            * propagated.
+            */
+           void atSuccessor   ( DependableObject &successor, DependableObject &predecessor )
+           {
+              if ( ! _useSmartPriority ) return;
 
+              WD *pred = ( WD* ) predecessor.getRelatedObject();
+              if ( pred == NULL ) return;
 
-            /*!
-             * \brief This method performs the main task of the smart priority
-             * scheduler, which is to propagate the priority of a WD to its
-             * immediate predecessors. It is meant to be invoked from
-             * DependenciesDomain::submitWithDependenciesInternal.
-             * \param [in/out] predecessor The preceding DependableObject.
-             * \param [in] successor DependableObject whose WD priority has to be
-             * propagated.
-             */
-//            void successorFound( DependableObject *predecessor, DependableObject *successor )
-            void atSuccessor   ( DependableObject &successor, DependableObject &predecessor )
-            {
-               //debug( "Scheduler::successorFound" );
-               // if ( ! _useSmartPriority ) return;
-               return; //FIXME
-
-
- //              if ( predecessor == NULL || successor == NULL ) return;
-
-               WD *pred = ( WD* ) predecessor.getRelatedObject();
-               if ( pred == NULL ) return;
-
-               WD *succ = ( WD* ) successor.getRelatedObject();
-               if ( succ == NULL ) {
-                  fatal( "SmartPriority::successorFound  successor->getRelatedObject() is NULL" );
-               }
-
-               debug ( "Propagating priority from "
-                  << (void*)succ << ":" << succ->getId() << " to "
-                  << (void*)pred << ":"<< pred->getId()
-                  << ", old priority: " << pred->getPriority()
-                  << ", new priority: " << std::max( pred->getPriority(),
-                  succ->getPriority() )
-               );
-
-               // Propagate priority
-               if ( pred->getPriority() < succ->getPriority() ) {
-                  pred->setPriority( succ->getPriority() );
-
-                  // Reorder
-                  TeamData &tdata = (TeamData &) *myThread->getTeam()->getScheduleData();
-                  WDPriorityQueue<> *q = (WDPriorityQueue<> *) tdata._readyQueue[0];
-                  q->reorderWD( pred );
-               }
-            }
+              WD *succ = ( WD* ) successor.getRelatedObject();
+              if ( succ == NULL ) {
+                 fatal( "SmartPriority::successorFound  successor->getRelatedObject() is NULL" );
+              }
+
+              debug ( "Propagating priority from "
+                 << (void*)succ << ":" << succ->getId() << " to "
+                 << (void*)pred << ":"<< pred->getId()
+                 << ", old priority: " << pred->getPriority()
+                 << ", new priority: " << std::max( pred->getPriority(),
+                 succ->getPriority() )
+              );
+
+              // Propagate priority (a queued predecessor is reordered through reorderWD)
+              if ( pred->getPriority() < succ->getPriority() ) {
+                 pred->setPriority( succ->getPriority() );
+              }
+           }
 
            virtual WD *atSubmit ( BaseThread *thread, WD &newWD )
            {
@@ -172,81 +148,77 @@ namespace nanos {
 
            WD * atIdle ( BaseThread *thread, int numSteal )
            {
+              WD *rv = thread->getNextWD();
+              if ( rv ) return rv;
+
               TeamData &tdata = (TeamData &) *thread->getTeam()->getScheduleData();
-              
-              WD *rv = NULL;
-              for (int i=_numQueues-1; i >=0; i-- ) {
-                 rv = tdata._readyQueue[i]->pop_front( thread );
-                 if ( rv != NULL) break;
+
+              //! Pop from the best of two random queues
+              WDPriorityQueue<> *first = &tdata._readyQueues[randomQueue( thread, tdata )];
+              WDPriorityQueue<> *second = &tdata._readyQueues[randomQueue( thread, tdata )];
+              if ( first->empty() || ( !second->empty() && second->maxPriority() > first->maxPriority() ) ) {
+                 std::swap( first, second );
+              }
+
+              if ( ( rv = first->pop_front( thread ) ) != NULL ) return rv;
+              if ( second != first && ( rv = second->pop_front( thread ) ) != NULL ) return rv;
+
+              //! Both were empty (or their tasks cannot run here): look at the rest before going idle
+              int start = randomQueue( thread, tdata );
+              for ( int i = 0; i < tdata._numQueues; i++ ) {
+                 WDPriorityQueue<> &q = tdata._readyQueues[( start + i ) % tdata._numQueues];
+                 if ( q.empty() ) continue;
+                 if ( ( rv = q.pop_front( thread ) ) != NULL ) return rv;
               }
-              return rv;
+
+              return NULL;
            }
 
            WD * atPrefetch ( BaseThread *thread, WD &current )
            {
-              if ( !_usePriority && !_useSmartPriority ) {
-                 WD * found = current.getImmediateSuccessor(*thread);
-                 return found != NULL ? found : atIdle(thread,false);
-              } else {
-                 return atIdle(thread,false);
-              }
+              return atIdle(thread,false);
            }
         
-           WD * atBeforeExit ( BaseThread *thread, WD &current, bool schedule )
+           bool reorderWD ( BaseThread *t, WD *wd )
            {
-              if ( !_usePriority && !_useSmartPriority && schedule ) {
-                 return current.getImmediateSuccessor(*thread);
-              } else {
-                 return 0;
-              }
+              WDPriorityQueue<> *q = (WDPriorityQueue<> *) wd->getMyQueue();
+              return q? q->reorderWD( wd ) : true;
            }
-            bool reorderWD ( BaseThread *t, WD *wd )
-            {
-              //! \bug FIXME flags of priority must be in queue
-               if ( _usePriority || _useSmartPriority ) {
-                  WDPriorityQueue<> *q = (WDPriorityQueue<> *) wd->getMyQueue();
-                  return q? q->reorderWD( wd ) : true;
-               } else {
-                  return true;
-               }
-            }
             
-            bool usingPriorities() const
-            {
-               return _usePriority || _useSmartPriority;
-            }
+           bool usingPriorities() const
+           {
+              return true;
+           }
+
+           bool testDequeue()
+           {
+              TeamData &tdata = (TeamData &) *myThread->getTeam()->getScheduleData();
+              for ( int i = 0; i < tdata._numQueues; i++ ) {
+                 if ( tdata._readyQueues[i].testDequeue() ) return true;
+              }
+              return false;
+           }
       };
 
-      bool MultiPriorityQueue::_useStack = false;
-      bool MultiPriorityQueue::_usePriority = true;
       bool MultiPriorityQueue::_useSmartPriority = false;
-      int  MultiPriorityQueue::_maxPriority = 0;
-      int  MultiPriorityQueue::_numQueues = 8;
+      int  MultiPriorityQueue::_queuesPerThread = 2;
 
-      class BFSchedPlugin : public Plugin
+      class MPQSchedPlugin : public Plugin
       {
 
          public:
-            BFSchedPlugin() : Plugin( "BF scheduling Plugin",1 ) {}
+            MPQSchedPlugin() : Plugin( "MPQ scheduling Plugin",1 ) {}
 
             virtual void config ( Config &cfg )
             {
-               cfg.setOptionsSection( "MPQ module", "Multi-priority queue scheduling module" );
-
-               cfg.registerConfigOption ( "schedule-priority", NEW Config::FlagOption( MultiPriorityQueue::_usePriority ), "Priority queue used as ready task queue");
-               cfg.registerArgOption( "schedule-priority", "schedule-priority" );
+               cfg.setOptionsSection( "MPQ module", "Multi-priority queue (relaxed priority) scheduling module" );
 
                cfg.registerConfigOption ( "schedule-smart-priority", NEW Config::FlagOption( MultiPriorityQueue::_useSmartPriority ), "Smart priority queue propagates high priorities to predecessors");
                cfg.registerArgOption( "schedule-smart-priority", "schedule-smart-priority" );
 
-               cfg.registerConfigOption( "schedule-max-priority", NEW Config::PositiveVar( MultiPriorityQueue::_maxPriority ),
-                                         "Defines max priority which can be used in the program" );
-               cfg.registerArgOption( "schedule-max-priority", "schedule-max-priority" );
-
-               cfg.registerConfigOption( "schedule-num-queues", NEW Config::PositiveVar( MultiPriorityQueue::_numQueues ),
-                                         "Defines number of queues that will be used by the scheduler" );
+               cfg.registerConfigOption( "schedule-num-queues", NEW Config::PositiveVar( MultiPriorityQueue::_queuesPerThread ),
+                                         "Defines number of priority queues per worker thread (2)" );
                cfg.registerArgOption( "schedule-num-queues", "schedule-num-queues" );
-
             }
 
             virtual void init() {
@@ -257,4 +229,4 @@ namespace nanos {
    }
 }
 
-DECLARE_PLUGIN("sched-bf",nanos::ext::BFSchedPlugin);
+DECLARE_PLUGIN("sched-mpq",nanos::ext::MPQSchedPlugin);
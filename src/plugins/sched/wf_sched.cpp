@@ -30,15 +30,21 @@ namespace nanos {
       {
          public:
             using SchedulePolicy::queue;
+            static bool          _useWSDeque;
          private:
             struct ThreadData : public ScheduleThreadData
             {
                /*! queue of ready tasks to be executed */
-               WDDeque _readyQueue;
+               WDPool *_readyQueue;
 
-               ThreadData () : _readyQueue() {}
+               ThreadData () : _readyQueue( NULL )
+               {
+                  if ( _useWSDeque ) _readyQueue = NEW WDWorkStealingDeque();
+                  else _readyQueue = NEW WDDeque();
+               }
                virtual ~ThreadData () {
-                  ensure(_readyQueue.empty(),"Destroying non-empty queue");
+                  ensure(_readyQueue->empty(),"Destroying non-empty queue");
+                  delete _readyQueue;
                }
             };
 
@@ -73,16 +79,16 @@ namespace nanos {
             /*! \brief Extracts a WD from the queue either from the beginning or the end of the queue
              *
              *  This function allows to simplify the code to extract code from the queues.
-             *  It's a wrapper around the WDDeque
+             *  It's a wrapper around the WDPool
              *  functions with the actual function chosen with the policy argument.
              *
              *   \param [inout] q The queue from we want to extract a WD
              *   \param [in] policy Either FIFO/LIFO to specify if we extract from the beginning or the end of the queue
              *   \param [in] thread The thread trying to extract the thread
              *   \returns either a WD if one was available in the queues or NULL
-             *   \sa WDDeque::pop_front, WDDeque::pop_back
+             *   \sa WDPool::pop_front, WDPool::pop_back
              */
-            WD * pop ( WDDeque &q, QueuePolicy policy, BaseThread *thread )
+            WD * pop ( WDPool &q, QueuePolicy policy, BaseThread *thread )
             {
                return policy == LIFO  ? q.pop_front(thread) : q.pop_back(thread);
             }
@@ -96,7 +102,8 @@ namespace nanos {
             virtual void queue ( BaseThread *thread, WD &wd )
             {
                 ThreadData &data = ( ThreadData & ) *thread->getTeamData()->getScheduleData();
-                data._readyQueue.push_front ( &wd );
+                data._readyQueue->setOwner( thread );
+                data._readyQueue->push_front ( &wd );
             }
 
             /*!
@@ -123,6 +130,7 @@ namespace nanos {
       };
 
       bool WorkFirst::_stealParent = true;
+      bool WorkFirst::_useWSDeque = false;
       WorkFirst::QueuePolicy WorkFirst::_localPolicy = WorkFirst::LIFO;
       WorkFirst::QueuePolicy WorkFirst::_stealPolicy = WorkFirst::FIFO;
 
@@ -144,7 +152,7 @@ namespace nanos {
          /*
           *  First try to schedule the thread with a task from its queue
           */
-         if ( ( wd = pop( data._readyQueue, _localPolicy, thread ) ) != NULL ) {
+         if ( ( wd = pop( *data._readyQueue, _localPolicy, thread ) ) != NULL ) {
             return wd;
          } else {
             /*
@@ -178,7 +186,7 @@ namespace nanos {
 
                if ( victim.getTeam() != NULL ) {
                  ThreadData &tdata = ( ThreadData & ) *victim.getTeamData()->getScheduleData();
-                 wd = pop( tdata._readyQueue, _stealPolicy, thread );
+                 wd = pop( *tdata._readyQueue, _stealPolicy, thread );
                }
 
                count++;
@@ -223,6 +231,10 @@ namespace nanos {
                                              "Defines the steal access policy");
                cfg.registerArgOption ( "schedule-steal-policy", "schedule-steal-policy" );
 
+               cfg.registerConfigOption ( "schedule-ws-deque", NEW Config::FlagOption( WorkFirst::_useWSDeque ),
+                                             "Use a lock-free work-stealing deque as ready task queue" );
+               cfg.registerArgOption ( "schedule-ws-deque", "schedule-ws-deque" );
+
             }
 
             virtual void init() {
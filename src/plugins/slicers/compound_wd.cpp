@@ -20,6 +20,7 @@
 #include "plugin.hpp"
 #include "slicer.hpp"
 #include "system.hpp"
+#include "chunkpool.hpp"
 
 namespace nanos {
 
@@ -109,10 +110,10 @@ bool SlicerCompoundWD::dequeue ( WorkDescriptor *wd, WorkDescriptor **slice )
 
    if ( modifiers == true ) {
       if ( _serializeAll ) serialize = true ;
-      if ( _totalTasks != 0) serialize = serialize || (ss._totalTasks > _totalTasks );
-      if ( _totalTasksPerThread != 0) serialize = serialize || ( ss._totalTasks > ( nthreads * _totalTasksPerThread) );
-      if ( _readyTasks != 0) serialize = serialize || (ss._readyTasks > _readyTasks );
-      if ( _readyTasksPerThread != 0) serialize = serialize || (ss._readyTasks > ( nthreads * _readyTasksPerThread) );
+      if ( _totalTasks != 0) serialize = serialize || (ss._totalTasks.approximate() > _totalTasks );
+      if ( _totalTasksPerThread != 0) serialize = serialize || ( ss._totalTasks.approximate() > ( nthreads * _totalTasksPerThread) );
+      if ( _readyTasks != 0) serialize = serialize || (ss._readyTasks.approximate() > _readyTasks );
+      if ( _readyTasksPerThread != 0) serialize = serialize || (ss._readyTasks.approximate() > ( nthreads * _readyTasksPerThread) );
       if ( _depthOfTask != 0) {} //! \todo depthOfTask is not involved in serialize flag
    }
    
@@ -146,7 +147,7 @@ void SlicerCompoundWD::executeWDs ( nanos_compound_wd_data_t *data )
       slice = (WorkDescriptor*)data->lwd[i];
       Scheduler::inlineWork( slice, /*schedule*/ false );
       slice->~WorkDescriptor();
-      delete[] (char *)slice;
+      ChunkPool::deallocate( slice );
    }
 
 }
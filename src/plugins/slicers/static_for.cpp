@@ -21,6 +21,7 @@
 #include "slicer.hpp"
 #include "system.hpp"
 #include "smpdd.hpp"
+#include "chunkpool.hpp"
 
 namespace nanos {
 namespace ext {
@@ -215,7 +216,7 @@ void SlicerStaticFor::submit ( WorkDescriptor &work )
    if ( mythread == &first_thread ) {
       if ( Scheduler::inlineWork( &work, false ) ) {
          work.~WorkDescriptor();
-         delete[] (char *) &work;
+         ChunkPool::deallocate( &work );
       }
    }
    else
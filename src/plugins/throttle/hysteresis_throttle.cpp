@@ -79,7 +79,11 @@ namespace nanos {
          // If it's OpenMP, first level tasks will have depth 1
          unsigned maxDepth = ( sys.getPMInterface().getInterface() == PMInterface::OpenMP ) ? 2 : 1;
          // Only dealing with first level tasks
-         if ( ( (myThread->getCurrentWD())->getDepth() < maxDepth ) && ( _get_num_tasks() > _upper ) ) _syncCond->wait();
+         if ( ( (myThread->getCurrentWD())->getDepth() < maxDepth ) && ( _get_num_tasks() > _upper ) ) {
+            // The condition checks the published counter, do not keep our own updates pending
+            sys.getSchedulerStats().flush();
+            _syncCond->wait();
+         }
          return true;
       }
       void HysteresisThrottle::throttleOut ( void )
@@ -0,0 +1,42 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#include "steal_loop.hpp"
+#include "plugin.hpp"
+
+namespace nanos {
+namespace ext {
+
+class WorkSharingDynamicStealForPlugin : public Plugin {
+   public:
+      WorkSharingDynamicStealForPlugin () : Plugin("Worksharing plugin for loops using a dynamic policy with per-thread ranges",1) {}
+     ~WorkSharingDynamicStealForPlugin () {}
+
+      virtual void config( Config& cfg ) {}
+
+      void init ()
+      {
+         sys.registerWorkSharing("dynamic_steal_for", NEW WorkSharingStealFor<false>() );
+      }
+};
+
+} // namespace ext
+} // namespace nanos
+
+DECLARE_PLUGIN( "placeholder-name", nanos::ext::WorkSharingDynamicStealForPlugin );
@@ -0,0 +1,210 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_WORKSHARING_STEAL_LOOP
+#define _NANOS_WORKSHARING_STEAL_LOOP
+
+#include "nanos-int.h"
+#include "atomic.hpp"
+#include "allocator_decl.hpp"
+#include "system.hpp"
+#include "worksharing_decl.hpp"
+
+namespace nanos {
+namespace ext {
+
+//! \brief Range of loop units owned by one thread
+//!
+//! Both ends are packed in a single word (begin in the low half, end in the high half) so the
+//! owner taking from the front and a thief splitting off the back are one compare and swap.
+typedef struct {
+   Atomic<uint64_t>          range;
+   char                      pad[NANOS_CACHELINE - sizeof(Atomic<uint64_t>)];
+} WorkSharingStealRange;
+
+typedef struct {
+   int64_t                   lowerBound;   // loop lower bound
+   int64_t                   upperBound;   // loop upper bound
+   int64_t                   loopStep;     // loop step
+   int64_t                   chunkSize;    // loop chunk size
+   int64_t                   numOfChunks;  // number of chunks for the loop
+   int64_t                   unitChunks;   // chunks grouped in a range unit
+   int                       numOfRanges;  // one range per team member
+   WorkSharingStealRange    *ranges;       // per-thread ranges of units
+} WorkSharingStealLoopInfo;
+
+//! \brief Dynamic/guided loop with per-thread ranges and range stealing
+//!
+//! The iteration space is pre-partitioned among the team members. Each thread consumes its
+//! own range (one chunk at a time, or half of what is left if guided) and, once exhausted,
+//! steals the upper half of a neighbour's range. No thread waits for the others to create
+//! the loop: every one of them builds the descriptor and the first to publish it wins.
+template <bool guided>
+class WorkSharingStealFor : public WorkSharing {
+   private:
+      static uint64_t pack ( uint64_t begin, uint64_t end ) { return begin | ( end << 32 ); }
+      static uint64_t begin ( uint64_t r ) { return r & 0xFFFFFFFFULL; }
+      static uint64_t end ( uint64_t r ) { return r >> 32; }
+
+      static WorkSharingStealLoopInfo * build ( nanos_ws_info_loop_t *loop_info, int nranges )
+      {
+         WorkSharingStealLoopInfo *data = NEW WorkSharingStealLoopInfo();
+
+         data->lowerBound = loop_info->lower_bound;
+         data->upperBound = loop_info->upper_bound;
+         data->loopStep   = loop_info->loop_step;
+
+         int64_t chunk_size = (1 < loop_info->chunk_size) ? loop_info->chunk_size : 1;
+         data->chunkSize  = chunk_size;
+
+         int64_t niters = (((loop_info->upper_bound - loop_info->lower_bound) / loop_info->loop_step ) + 1 );
+         if ( niters < 0 ) niters = 0;
+         int64_t chunks = niters / chunk_size;
+         if ( niters % chunk_size != 0 ) chunks++;
+         data->numOfChunks = chunks;
+
+         // Range ends are 32 bits wide: group chunks when there are too many of them
+         int64_t units_limit = 0x7FFFFFFFLL;
+         data->unitChunks = ( chunks + units_limit - 1 ) / units_limit;
+         if ( data->unitChunks < 1 ) data->unitChunks = 1;
+         uint64_t units = ( chunks + data->unitChunks - 1 ) / data->unitChunks;
+
+         data->numOfRanges = nranges;
+         data->ranges = NEW WorkSharingStealRange[nranges];
+         for ( int i = 0; i < nranges; i++ ) {
+            data->ranges[i].range = pack( ( units * i ) / nranges, ( units * ( i + 1 ) ) / nranges );
+         }
+
+         return data;
+      }
+
+      static void destroy ( WorkSharingStealLoopInfo *data )
+      {
+         delete[] data->ranges;
+         delete data;
+      }
+
+      //! \brief Takes units from the front of the thread's own range
+      static bool takeLocal ( WorkSharingStealRange &own, uint64_t &first, uint64_t &count )
+      {
+         while ( true ) {
+            uint64_t r = own.range.value();
+            uint64_t b = begin( r ), e = end( r );
+            if ( b >= e ) return false;
+
+            uint64_t n = 1;
+            if ( guided && ( e - b ) / 2 > 1 ) n = ( e - b ) / 2;
+
+            if ( own.range.cswap( r, pack( b + n, e ) ) ) {
+               first = b;
+               count = n;
+               return true;
+            }
+         }
+      }
+
+      //! \brief Moves the upper half of some other thread's range into the thread's own range
+      //! \return false when every other range was found empty
+      static bool steal ( WorkSharingStealLoopInfo *data, int me )
+      {
+         for ( int i = 1; i < data->numOfRanges; i++ ) {
+            WorkSharingStealRange &victim = data->ranges[( me + i ) % data->numOfRanges];
+            while ( true ) {
+               uint64_t r = victim.range.value();
+               uint64_t b = begin( r ), e = end( r );
+               if ( b >= e ) break;
+
+               uint64_t split = e - ( e - b + 1 ) / 2;
+               if ( victim.range.cswap( r, pack( b, split ) ) ) {
+                  // Own range is empty: thieves leave it alone, only the owner writes it now
+                  data->ranges[me].range = pack( split, e );
+                  return true;
+               }
+            }
+         }
+         return false;
+      }
+
+   public:
+      //! \brief create a loop descriptor
+      //! \return only one thread per loop will get 'true' (single like behaviour)
+      bool create ( nanos_ws_desc_t **wsd, nanos_ws_info_t *info )
+      {
+         nanos_ws_info_loop_t *loop_info = (nanos_ws_info_loop_t *) info;
+         bool single = false;
+
+         *wsd = myThread->getTeamWorkSharingDescriptor( &single );
+
+         if ( (*wsd)->data == NULL ) {
+            ThreadTeam *team = myThread->getTeam();
+            int nranges = ( team != NULL ) ? team->getFinalSize() : 1;
+            WorkSharingStealLoopInfo *data = build( loop_info, nranges > 0 ? nranges : 1 );
+
+            memoryFence();     // Split initialization phase (before) from make it visible (after)
+
+            if ( !compareAndSwap( &(*wsd)->data, (nanos_ws_data_t) NULL, (nanos_ws_data_t) data ) ) destroy( data );
+         }
+
+         (*wsd)->ws = this;
+
+         return single;
+      }
+
+      //! \brief Get next chunk of iterations
+      void nextItem ( nanos_ws_desc_t *wsd, nanos_ws_item_t *item )
+      {
+         nanos_ws_item_loop_t     *loop_item = ( nanos_ws_item_loop_t *) item;
+         WorkSharingStealLoopInfo *loop_data = ( WorkSharingStealLoopInfo *) wsd->data;
+
+         int me = myThread->getTeamId();
+         if ( me < 0 ) me = 0;
+         me = me % loop_data->numOfRanges;
+
+         uint64_t first = 0, count = 0;
+         while ( !takeLocal( loop_data->ranges[me], first, count ) ) {
+            if ( !steal( loop_data, me ) ) {
+               loop_item->execute = false;
+               return;
+            }
+         }
+
+         int64_t first_chunk = first * loop_data->unitChunks;
+         int64_t last_chunk = ( first + count ) * loop_data->unitChunks;
+         if ( last_chunk > loop_data->numOfChunks ) last_chunk = loop_data->numOfChunks;
+         last_chunk--;
+
+         int sign = (( loop_data->loopStep < 0 ) ? -1 : +1);
+
+         loop_item->lower = loop_data->lowerBound + first_chunk * loop_data->chunkSize * loop_data->loopStep;
+
+         loop_item->upper = loop_data->lowerBound + ( last_chunk + 1 ) * loop_data->chunkSize * loop_data->loopStep - sign;
+         if ( ( loop_data->upperBound * sign ) < ( loop_item->upper * sign ) ) loop_item->upper = loop_data->upperBound;
+
+         loop_item->last = last_chunk == (loop_data->numOfChunks - 1);
+
+         loop_item->execute = (loop_item->lower * sign) <= (loop_item->upper * sign);
+      }
+
+      void duplicateWS ( nanos_ws_desc_t *orig, nanos_ws_desc_t **copy ) {}
+};
+
+} // namespace ext
+} // namespace nanos
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "allocator.hpp"
 #include "basethread.hpp"
+#include "atomic.hpp"
 
 using namespace nanos;
 
@@ -39,24 +40,50 @@ Allocator & nanos::getAllocator ( void )
    else return my_thread->getAllocator();
 }
 
-void * Allocator::Arena::allocate ( void )
+Allocator::SizeClass * Allocator::createSizeClass ( size_t idx )
 {
-   unsigned int obj;
+   SizeClass *sizeClass = (SizeClass *) malloc( sizeof(SizeClass) );
+   if ( sizeClass == NULL ) throw(NANOS_ENOMEM);
+   new ( sizeClass ) SizeClass( this );
+   _classes[idx] = sizeClass;
+   return sizeClass;
+}
+
+Allocator::FreeObject * Allocator::SizeClass::refill ( size_t objectSize )
+{
+   // First, take back all the objects released by other threads
+   FreeObject *list;
+   do {
+      list = _remoteFree;
+   } while ( list != NULL && !compareAndSwap( (FreeObject **) &_remoteFree, list, (FreeObject *) NULL ) );
 
-   if ( !_free ) return NULL;
+   if ( list != NULL ) return list;
 
-   for ( obj = 0 ; obj < numObjects ; obj++ ) {
-      if ( _bitmap[obj]._bit ) break;
-   }
+   // Otherwise, carve a new object from the current Arena
+   ObjectHeader *ptr = NULL;
+   if ( _arenas != NULL ) ptr = (ObjectHeader *) _arenas->allocate();
 
-   if (obj == numObjects) {
-      _free = false;
-      return NULL; 
+   if ( ptr == NULL ) {
+      Arena *arena = (Arena *) malloc( sizeof(Arena) );
+      if ( arena == NULL ) throw(NANOS_ENOMEM);
+      new ( arena ) Arena( objectSize, this, _arenas );
+      _arenas = arena;
+      ptr = (ObjectHeader *) arena->allocate();
    }
 
-   _bitmap[obj]._bit = false;
+   // The header is written once, the free list link goes right after it
+   ptr->_arena = _arenas;
+   FreeObject *obj = (FreeObject *) ( ((char *) ptr ) + _headerSize );
+   obj->_next = NULL;
 
-   return (void *) &_arena[obj*_objectSize];
+   return obj;
 }
 
-
+void Allocator::SizeClass::pushRemote ( FreeObject *obj )
+{
+   FreeObject *head;
+   do {
+      head = _remoteFree;
+      obj->_next = head;
+   } while ( !compareAndSwap( (FreeObject **) &_remoteFree, head, obj ) );
+}
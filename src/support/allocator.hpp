@@ -34,17 +34,15 @@ inline size_t Allocator::Arena::getObjectSize () const
    return _objectSize;
 }
 
-inline void Allocator::Arena::deallocate ( void *object )
+inline void * Allocator::Arena::allocate ( void )
 {
-   unsigned long offset = ((char *) object - _arena);
-   unsigned long index = offset / _objectSize;
-
-   //if (sys.getNetwork()->getNodeNum() == 0 && _objectSize > 32768) std::cerr << "Free object size " << _objectSize << " : " << (void *) _objectSize << " addr range is " << (void *) object << ":" << ((void *) (((char*)object)+_objectSize)) << " this is arena " << (void*) this << std::endl;
-   _free = true;
-   _bitmap[index]._bit = true;
+   if ( _used == numObjects ) return NULL;
+   return (void *) &_arena[(_used++)*_objectSize];
+}
 
-   //if (sys.getNetwork()->getNodeNum() == 0 && _objectSize > 32768) std::cerr << "memset from " << (void *) &_arena[index*_objectSize] << " to " << (void*) (&_arena[index*_objectSize+_objectSize]) << std::endl;
-   //memset( &_arena[index*_objectSize], 0, _objectSize );
+inline Allocator::SizeClass * Allocator::Arena::getSizeClass ( void ) const
+{
+   return _sizeClass;
 }
 
 inline Allocator::Arena * Allocator::Arena::getNext ( void ) const
@@ -52,9 +50,26 @@ inline Allocator::Arena * Allocator::Arena::getNext ( void ) const
    return _next;
 }
 
-inline void Allocator::Arena::setNext ( Arena * a )
+inline void * Allocator::SizeClass::allocate ( size_t objectSize )
 {
-   _next = a;
+   FreeObject *obj = _freeList;
+   if ( obj == NULL ) obj = refill( objectSize );
+   _freeList = obj->_next;
+
+   return (void *) obj;
+}
+
+inline void Allocator::SizeClass::deallocate ( void *object )
+{
+   FreeObject *obj = (FreeObject *) object;
+
+   if ( &getAllocator() == _allocator ) {
+      // Local free: back to the owner's magazine
+      obj->_next = _freeList;
+      _freeList = obj;
+   } else {
+      pushRemote( obj );
+   }
 }
 
 inline void * Allocator::allocateBigObject ( size_t size )
@@ -80,44 +95,14 @@ inline void * Allocator::allocate ( size_t size, const char* file, int line )
    realSize |= realSize >> 8;
    realSize |= realSize >> 16;
    realSize++;
- 
-
-   ArenaCollection::iterator it;
-   for ( it = _arenas.begin(); it != _arenas.end(); it++ ) {
-      if ( (*it)->getObjectSize() == realSize ) break;
-   }
-
-   Arena *arena = NULL;
 
-   if ( it == _arenas.end() ) {
-      // no arena found for that size, create a new one
-      arena = (Arena *) malloc ( sizeof(Arena) );
-      if ( arena == NULL ) throw(NANOS_ENOMEM);
-      new ( arena ) Arena( realSize );
-      _arenas.push_back( arena );
-   }
-   else arena = *it;
+   /* realSize is a power of 2, so its log2 is the number of trailing zeros */
+   size_t idx = __builtin_ctzl( realSize );
 
+   SizeClass *sizeClass = _classes[idx];
+   if ( sizeClass == NULL ) sizeClass = createSizeClass( idx );
 
-   ObjectHeader * ptr = NULL;
-
-   while ( ptr == NULL ) {
-      ptr = (ObjectHeader *) arena->allocate();
-      if ( ptr == NULL ) { 
-          if ( arena->getNext() == NULL ) {
-             Arena *next = ( Arena *) malloc ( sizeof(Arena) );
-             if ( next == NULL ) throw(NANOS_ENOMEM);
-             new (next) Arena(realSize);
-             arena->setNext( next );
-          }
-          arena = arena->getNext(); 
-      }
-   }
-
-   ptr->_arena = arena;
-   //if (sys.getNetwork()->getNodeNum() == 0 && realSize > 32768) std::cerr << "Allocate object size " << realSize << " : " << (void *) realSize << " addr range is " << (void *) ptr << ":" << ((void *) (((char*)ptr)+realSize)) << " this is arena " << (void *) arena << std::endl;
-
-   return  ((char *) ptr ) + _headerSize;
+   return sizeClass->allocate( realSize );
 }
 
 inline void Allocator::deallocate ( void *object, const char *file, int line )
@@ -132,7 +117,7 @@ inline void Allocator::deallocate ( void *object, const char *file, int line )
    if ( arena == NULL )
      free(ptr);
    else
-     arena->deallocate(ptr);
+     arena->getSizeClass()->deallocate( object );
 }
 
 inline size_t Allocator::getObjectSize ( void *object )
@@ -85,10 +85,25 @@ class InternalAllocator
        inline void destroy( pointer p ) { p->~T(); }
 };
 /*! \class Allocator
+ *
+ *  Size-class allocator. Objects are carved from per size class Arenas and
+ *  recycled through an intrusive free list (the magazine) owned by the
+ *  allocating thread, so both allocation and local deallocation are O(1).
+ *  Objects released by a thread other than the owner are pushed to a
+ *  lock-free remote list, which the owner takes as a whole when its
+ *  magazine runs empty.
  */
 class Allocator
 {
    private:
+      class SizeClass;
+
+     /*! \brief Link stored in free objects (right after the ObjectHeader)
+      */
+      struct FreeObject {
+         FreeObject          *_next;
+      };
+
      /*! \class Arena
       */
       class Arena
@@ -96,16 +111,11 @@ class Allocator
          private: /* Arena data members and disabled constructors */
             static const size_t numObjects = NANOS_OBJECTS_PER_ARENA;      /** Number of maximum objects allocated in this arena*/
 
-            union bitmap_entry {
-               bool             _bit;
-               char             pad[NANOS_CACHELINE];
-            };                                         /**< bitmap_entry struct */
-
             size_t            _objectSize;            /**< Object size in current Arena  */
             char             *_arena;                 /**< Memory region used by Arena */
-            bitmap_entry     *_bitmap;                /**< Bit map (free/busy) */
+            size_t            _used;                  /**< Objects already carved from the region */
+            SizeClass        *_sizeClass;             /**< Size class (and owner) of this Arena */
             Arena            *_next;                  /**< Next Arena in the list */
-            bool              _free;                  /**< Are there free entries */
             /*! \brief Arena copy constructor (disabled)
              */
             Arena ( const Arena &a );
@@ -118,12 +128,11 @@ class Allocator
          public: /* Arena method members */
            /*! \brief Arena constructor
             */
-            Arena ( size_t objectSize ) : _objectSize(objectSize), _next (NULL), _free(true)
+            Arena ( size_t objectSize, SizeClass *sizeClass, Arena *next ) : _objectSize(objectSize), _used(0),
+               _sizeClass(sizeClass), _next(next)
             {
-               _arena = (char *) malloc( (objectSize + sizeof(bitmap_entry) ) * numObjects );
+               _arena = (char *) malloc( objectSize * numObjects );
                if ( _arena == NULL ) throw ( NANOS_ENOMEM );
-               _bitmap = (bitmap_entry *) (_arena + objectSize * numObjects);
-               for ( size_t i = 0; i < numObjects; i++ ) _bitmap[i]._bit = true;
             }
            /*! \brief Arena destructor
             */
@@ -131,27 +140,56 @@ class Allocator
             {
                delete _next;
                free(_arena);
-               free(_bitmap);
             }
            /*! \brief Returns the size of allocated object
             */
             size_t getObjectSize ( void ) const ; 
-           /*! \brief Returns a free object address (and mark it as busy)
+           /*! \brief Returns a never used object address, NULL if the Arena is exhausted
             */
             void * allocate ( void ) ;
-           /*! \brief Mark 'object' as free
+           /*! \brief Returns the size class this Arena belongs to
             */
-            void deallocate ( void *object ) ;
+            SizeClass * getSizeClass ( void ) const;
            /*! \brief Returns next Arena object in the list
             */
             Arena * getNext ( void ) const;
-           /*! \brief Set as next Arena object 'a'
-            */
-            void setNext ( Arena * a );
       };
-      template<typename T>
-      struct InternalCollection {
-         typedef std::list<T, InternalAllocator<T> > type;
+
+     /*! \class SizeClass
+      *  \brief Per allocator state of a given object size
+      *  \note SizeClass objects are never released: other threads may still
+      *  return objects to them after the owner Allocator is gone.
+      */
+      class SizeClass
+      {
+         private:
+            Allocator             *_allocator;       /**< Owner Allocator */
+            FreeObject            *_freeList;        /**< Magazine of free objects (owner only) */
+            Arena                 *_arenas;          /**< Arenas of this class, newest first */
+            char                   _pad[NANOS_CACHELINE];
+            FreeObject * volatile  _remoteFree;      /**< Objects released by other threads */
+            /*! \brief SizeClass copy constructor (disabled)
+             */
+            SizeClass ( const SizeClass &sc );
+            /*! \brief SizeClass copy assignment operator (disabled)
+             */
+            SizeClass & operator= ( const SizeClass &sc );
+         public:
+           /*! \brief SizeClass constructor
+            */
+            SizeClass ( Allocator *allocator ) : _allocator( allocator ), _freeList( NULL ), _arenas( NULL ), _remoteFree( NULL ) {}
+           /*! \brief Returns a free object, refilling the magazine if needed
+            */
+            void * allocate ( size_t objectSize );
+           /*! \brief Returns an object allocated from this class
+            */
+            void deallocate ( void *object );
+           /*! \brief Refills the magazine from the remote list or from the Arenas (slow path)
+            */
+            FreeObject * refill ( size_t objectSize );
+           /*! \brief Lock-free push of an object released by a thread other than the owner
+            */
+            void pushRemote ( FreeObject *obj );
       };
 
       struct ObjectHeader {
@@ -159,9 +197,9 @@ class Allocator
       };
 
    private: /* Allocator data members */
-      typedef InternalCollection<Arena *>::type  ArenaCollection;
+      static const size_t           _numClasses = sizeof(size_t) * 8;
 
-      ArenaCollection               _arenas;      /**< Vector of Arenas in Allocator*/
+      SizeClass                    *_classes[_numClasses]; /**< Size classes, indexed by log2 of object size */
       static size_t                 _headerSize;  /**< Size of ObjectHeader */
 
       static const size_t                  _sizeOfBig = 1024*1024*10;
@@ -177,20 +215,23 @@ class Allocator
      /*! \brief Alternative allocation method for big objects */
       void * allocateBigObject ( size_t size ); 
 
+     /*! \brief Creates the SizeClass for index 'idx' (slow path) */
+      SizeClass * createSizeClass ( size_t idx );
+
    public: /* Allocator method members */
     /*! \brief Allocator default constructor 
      */
-     Allocator ( ) : _arenas() {}
+     Allocator ( ) { for ( size_t i = 0; i < _numClasses; i++ ) _classes[i] = NULL; }
     /*! \brief Allocator destructor 
      */
      ~Allocator () { }
     /*! \brief Allocates 'size' bytes in memory and returns memory pointer
      *
-     *  This function will check in his list of Arenas looking for one who
-     *  stores objects of the given 'size'. If Allocator finds an Arena region
-     *  with this 'size' will ask to it for a new object. If none of the current
-     *  Arenas works with the given 'size' Allocator will create a new Arena entry
-     *  in order to manage this (and future) objects of the given 'size'.
+     *  The object size (plus header) is rounded up to the next power of 2,
+     *  which selects the SizeClass. Allocator takes the first object of the
+     *  SizeClass magazine; when it is empty the magazine is refilled with the
+     *  objects other threads have released or, otherwise, with a new object
+     *  carved from the SizeClass Arenas (creating a new Arena if needed).
      */
      void * allocate ( size_t size, const char *file = NULL, int line = 0 ) ;
     /*! \brief Deallocates 'object' (object has a header which identifies related Arena
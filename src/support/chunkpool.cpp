@@ -0,0 +1,66 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#include "chunkpool.hpp"
+
+using namespace nanos;
+
+ChunkPool::SizeClass ChunkPool::_classes[ChunkPool::_numClasses];
+__thread ChunkPool::ThreadCache ChunkPool::_cache;
+
+void ChunkPool::flush ( size_t sizeClass )
+{
+   // Detach the older half of the cache (the hot chunks stay in this thread)
+   FreeChunk *last = _cache._free[sizeClass];
+   for ( size_t i = 1; i < _cacheSize / 2; i++ ) last = last->_next;
+
+   FreeChunk *first = last->_next;
+   last->_next = NULL;
+   _cache._count[sizeClass] = _cacheSize / 2;
+
+   for ( last = first; last->_next != NULL; last = last->_next );
+
+   SizeClass &global = _classes[sizeClass];
+   LockBlock lock( global._lock );
+   last->_next = global._free;
+   global._free = first;
+}
+
+bool ChunkPool::refill ( size_t sizeClass )
+{
+   SizeClass &global = _classes[sizeClass];
+   if ( global._free == NULL ) return false;
+
+   FreeChunk *first;
+   size_t count = 0;
+   {
+      LockBlock lock( global._lock );
+      first = global._free;
+      if ( first == NULL ) return false;
+
+      FreeChunk *last = first;
+      for ( count = 1; count < _cacheSize / 2 && last->_next != NULL; count++ ) last = last->_next;
+      global._free = last->_next;
+      last->_next = NULL;
+   }
+
+   _cache._free[sizeClass] = first;
+   _cache._count[sizeClass] = count;
+   return true;
+}
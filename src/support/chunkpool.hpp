@@ -0,0 +1,86 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_CHUNKPOOL
+#define _NANOS_CHUNKPOOL
+
+#include "chunkpool_decl.hpp"
+#include "lock.hpp"
+#include "new_decl.hpp"
+
+namespace nanos {
+
+inline size_t ChunkPool::getSizeClass ( size_t size )
+{
+   size_t sizeClass = 0;
+   while ( sizeClass < _numClasses && getClassSize( sizeClass ) < size ) sizeClass++;
+   return sizeClass;
+}
+
+inline void * ChunkPool::allocate ( size_t size )
+{
+   size_t realSize = size + sizeof( ChunkHeader );
+   size_t sizeClass = getSizeClass( realSize );
+
+   ChunkHeader *header;
+   if ( sizeClass == _numClasses ) {
+      header = (ChunkHeader *) NEW char[realSize];
+   } else {
+      if ( _cache._free[sizeClass] == NULL && !refill( sizeClass ) ) {
+         header = (ChunkHeader *) NEW char[getClassSize( sizeClass )];
+      } else {
+         FreeChunk *chunk = _cache._free[sizeClass];
+         _cache._free[sizeClass] = chunk->_next;
+         _cache._count[sizeClass]--;
+         header = (ChunkHeader *) chunk;
+      }
+   }
+
+   header->_sizeClass = sizeClass;
+   header->_magic = _chunkMagic;
+   return (void *) ( header + 1 );
+}
+
+inline void ChunkPool::deallocate ( void *chunk )
+{
+   ChunkHeader *header = ( (ChunkHeader *) chunk ) - 1;
+
+   if ( header->_magic != _chunkMagic ) {
+      delete[] (char *) chunk;
+      return;
+   }
+
+   size_t sizeClass = header->_sizeClass;
+
+   if ( sizeClass == _numClasses ) {
+      delete[] (char *) header;
+      return;
+   }
+
+   if ( _cache._count[sizeClass] == _cacheSize ) flush( sizeClass );
+
+   FreeChunk *freeChunk = (FreeChunk *) header;
+   freeChunk->_next = _cache._free[sizeClass];
+   _cache._free[sizeClass] = freeChunk;
+   _cache._count[sizeClass]++;
+}
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,93 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_CHUNKPOOL_DECL
+#define _NANOS_CHUNKPOOL_DECL
+
+#include <stddef.h>
+#include "lock_decl.hpp"
+
+namespace nanos {
+
+  /*! \brief Recycling pool for short-lived variable-size chunks (e.g. WorkDescriptor chunks)
+   *
+   *  Chunks are grouped in power-of-two size classes. Released chunks are kept
+   *  in a small per-thread cache and, when it overflows, in a global lock
+   *  protected list, so that in steady state neither allocate() nor
+   *  deallocate() reach the heap. Chunks bigger than the largest class are
+   *  allocated and freed directly.
+   */
+   class ChunkPool
+   {
+      public:
+         static const size_t _minClassShift = 6;   /**< Smallest class: 64 bytes */
+         static const size_t _numClasses = 11;     /**< Largest class: 64KB */
+         static const size_t _cacheSize = 32;      /**< Chunks per class kept by each thread */
+      private:
+         struct ChunkHeader {
+            size_t   _sizeClass;                   /**< Size class index, _numClasses if not pooled */
+            size_t   _magic;                       /**< _chunkMagic, tells pool chunks from foreign ones (16-byte header) */
+         };
+
+         static const size_t _chunkMagic = 0x6e78636b706f6f6cULL;
+
+         struct FreeChunk {
+            FreeChunk  *_next;
+         };
+
+         struct SizeClass {
+            Lock        _lock;
+            FreeChunk  *_free;
+            SizeClass() : _lock(), _free( NULL ) {}
+         };
+
+         struct ThreadCache {
+            FreeChunk  *_free[_numClasses];
+            size_t      _count[_numClasses];
+         };
+
+         static SizeClass              _classes[_numClasses];
+         static __thread ThreadCache   _cache;
+
+      private:
+         /*! \brief ChunkPool default constructor (private, only static members) */
+         ChunkPool ();
+
+         static size_t getSizeClass ( size_t size );
+         static size_t getClassSize ( size_t sizeClass ) { return ((size_t) 1) << ( sizeClass + _minClassShift ); }
+
+         /*! \brief Moves half of the thread cache of a class to its global list */
+         static void flush ( size_t sizeClass );
+         /*! \brief Refills the thread cache of a class from its global list
+          *  \return false if the global list was empty
+          */
+         static bool refill ( size_t sizeClass );
+
+      public:
+         /*! \brief Returns a chunk of at least size bytes (16-byte aligned, not cleared) */
+         static void * allocate ( size_t size );
+         /*! \brief Returns a chunk obtained through allocate() to the pool
+          *  \note Chunks obtained through NEW char[] (e.g. WDs built by hand) are released with delete[]
+          */
+         static void deallocate ( void *chunk );
+   };
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,136 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_FLATSET
+#define _NANOS_FLATSET
+
+#include <algorithm>
+#include "flatset_decl.hpp"
+#include "new_decl.hpp"
+
+namespace nanos {
+
+template <typename T, size_t N>
+inline FlatSet<T,N>::FlatSet () : _data( _inline ), _size( 0 ), _capacity( N ) {}
+
+template <typename T, size_t N>
+inline FlatSet<T,N>::FlatSet ( const FlatSet &set ) : _data( _inline ), _size( 0 ), _capacity( N )
+{
+   *this = set;
+}
+
+template <typename T, size_t N>
+inline const FlatSet<T,N> & FlatSet<T,N>::operator= ( const FlatSet &set )
+{
+   if ( this == &set ) return *this;
+
+   if ( set._size > _capacity ) {
+      _size = 0;
+      reserve( set._size );
+   }
+   std::copy( set.begin(), set.end(), _data );
+   _size = set._size;
+
+   return *this;
+}
+
+template <typename T, size_t N>
+inline FlatSet<T,N>::~FlatSet ()
+{
+   if ( _data != _inline ) delete[] _data;
+}
+
+template <typename T, size_t N>
+inline void FlatSet<T,N>::reserve ( size_t capacity )
+{
+   if ( capacity <= _capacity ) return;
+
+   size_t newCapacity = _capacity * 2;
+   while ( newCapacity < capacity ) newCapacity *= 2;
+
+   T *data = NEW T[newCapacity];
+   std::copy( begin(), end(), data );
+   if ( _data != _inline ) delete[] _data;
+
+   _data = data;
+   _capacity = newCapacity;
+}
+
+template <typename T, size_t N>
+inline std::pair<typename FlatSet<T,N>::iterator, bool> FlatSet<T,N>::insert ( const T &value )
+{
+   iterator pos;
+
+   // Fast path: values usually come in increasing order
+   if ( _size == 0 || _data[_size - 1] < value ) {
+      pos = end();
+   } else {
+      pos = std::lower_bound( begin(), end(), value );
+      if ( !( value < *pos ) ) return std::make_pair( pos, false );
+   }
+
+   if ( _size == _capacity ) {
+      size_t index = pos - _data;
+      reserve( _size + 1 );
+      pos = _data + index;
+   }
+
+   std::copy_backward( pos, end(), end() + 1 );
+   *pos = value;
+   _size++;
+
+   return std::make_pair( pos, true );
+}
+
+template <typename T, size_t N>
+inline typename FlatSet<T,N>::iterator FlatSet<T,N>::find ( const T &value )
+{
+   iterator pos = std::lower_bound( begin(), end(), value );
+   if ( pos != end() && !( value < *pos ) ) return pos;
+   return end();
+}
+
+template <typename T, size_t N>
+inline typename FlatSet<T,N>::iterator FlatSet<T,N>::erase ( iterator it )
+{
+   std::copy( it + 1, end(), it );
+   _size--;
+   return it;
+}
+
+template <typename T, size_t N>
+inline size_t FlatSet<T,N>::erase ( const T &value )
+{
+   iterator it = find( value );
+   if ( it == end() ) return 0;
+   erase( it );
+   return 1;
+}
+
+template <typename T, size_t N>
+inline typename FlatSet<T,N>::iterator FlatSet<T,N>::erase ( iterator first, iterator last )
+{
+   std::copy( last, end(), first );
+   _size -= last - first;
+   return first;
+}
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,93 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_FLATSET_DECL
+#define _NANOS_FLATSET_DECL
+
+#include <stddef.h>
+#include <utility>
+
+namespace nanos {
+
+  /*! \brief Ordered set of small values stored in a sorted array
+   *
+   *  The first N elements live inside the object itself, so sets that never
+   *  grow beyond N elements do not allocate at all. Beyond that the storage
+   *  is a heap array that doubles its capacity. Insertions in increasing
+   *  order (the common case) are appended without searching, other lookups
+   *  use a binary search. Iterators are plain pointers and are invalidated
+   *  by insert() and erase() (erase() returns the next valid one).
+   */
+   template <typename T, size_t N>
+   class FlatSet
+   {
+      public:
+         typedef T         value_type;
+         typedef T *       iterator;
+         typedef const T * const_iterator;
+      private:
+         T          *_data;       /**< Either _inline or a heap array */
+         size_t      _size;       /**< Number of elements */
+         size_t      _capacity;   /**< Number of elements that fit in _data */
+         T           _inline[N];  /**< Inline storage */
+
+         /*! \brief Grows the storage to hold at least capacity elements */
+         void reserve ( size_t capacity );
+      public:
+         /*! \brief FlatSet default constructor */
+         FlatSet ();
+         /*! \brief FlatSet copy constructor */
+         FlatSet ( const FlatSet &set );
+         /*! \brief FlatSet copy assignment operator, can be self-assigned */
+         const FlatSet & operator= ( const FlatSet &set );
+         /*! \brief FlatSet destructor */
+         ~FlatSet ();
+
+         iterator begin () { return _data; }
+         iterator end () { return _data + _size; }
+         const_iterator begin () const { return _data; }
+         const_iterator end () const { return _data + _size; }
+
+         size_t size () const { return _size; }
+         bool empty () const { return _size == 0; }
+
+         /*! \brief Removes all the elements (keeps the storage) */
+         void clear () { _size = 0; }
+
+         /*! \brief Inserts value if not present
+          *  \return The position of value and whether it has been inserted
+          */
+         std::pair<iterator, bool> insert ( const T &value );
+         /*! \brief Returns the position of value, or end() if not present */
+         iterator find ( const T &value );
+         /*! \brief Removes the element at it
+          *  \return The position of the element that followed it
+          */
+         iterator erase ( iterator it );
+         /*! \brief Removes value, if present
+          *  \return Number of elements removed (0 or 1)
+          */
+         size_t erase ( const T &value );
+         /*! \brief Removes the elements in [first,last) */
+         iterator erase ( iterator first, iterator last );
+   };
+
+} // namespace nanos
+
+#endif
@@ -110,6 +110,23 @@ unsigned int Hwloc::getNumaNodeOfCpu ( unsigned int cpu )
 #endif
 }
 
+unsigned int Hwloc::getCoreOfCpu ( unsigned int cpu )
+{
+   unsigned int coreId = cpu;
+#ifdef HWLOC
+   hwloc_obj_t pu = hwloc_get_pu_obj_by_os_index( _hwlocTopology, cpu );
+   if ( pu == NULL ) return coreId;
+
+   hwloc_obj_t core = hwloc_get_ancestor_obj_by_type( _hwlocTopology, HWLOC_OBJ_CORE, pu );
+
+   // Cores are numbered after the CPUs, so that they never clash with an unknown CPU
+   if ( core != NULL ) {
+      coreId = hwloc_get_nbobjs_by_type( _hwlocTopology, HWLOC_OBJ_PU ) + core->logical_index;
+   }
+#endif
+   return coreId;
+}
+
 void Hwloc::getNumSockets(unsigned int &allowedNodes, int &numSockets, unsigned int &hwThreads) {
 #ifdef HWLOC
    numSockets = 0;
@@ -50,6 +50,15 @@ class Hwloc {
       void unloadHwloc();
       unsigned int getNumaNodeOfCpu( unsigned int cpu );
       unsigned int getNumaNodeOfGpu( unsigned int gpu );
+      /*!
+       * \brief Returns an identifier of the core a CPU belongs to, so that
+       * SMT siblings get the same value.
+       *
+       * If hwloc is not available, every CPU is its own core.
+       *
+       * @param cpu OS CPU index.
+       */
+      unsigned int getCoreOfCpu( unsigned int cpu );
       void getNumSockets(unsigned int &allowedNodes, int &numSockets, unsigned int &hwThreads);
 
       /*!
@@ -0,0 +1,250 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_INTERVALTREE
+#define _NANOS_INTERVALTREE
+
+#include "intervaltree_decl.hpp"
+#include "new_decl.hpp"
+
+namespace nanos {
+
+template <typename K, typename V>
+inline IntervalTree<K,V>::IntervalTree () : _root( NULL ), _free( NULL ), _size( 0 ), _seed( 0x9E3779B9 ) {}
+
+template <typename K, typename V>
+inline IntervalTree<K,V>::~IntervalTree ()
+{
+   clear();
+   while ( _free != NULL ) {
+      Node *next = _free->_right;
+      delete _free;
+      _free = next;
+   }
+}
+
+template <typename K, typename V>
+inline bool IntervalTree<K,V>::less ( const K &low1, const K &high1, const K &low2, const K &high2 )
+{
+   return low1 < low2 || ( !( low2 < low1 ) && high1 < high2 );
+}
+
+template <typename K, typename V>
+inline void IntervalTree<K,V>::update ( Node *node )
+{
+   node->_maxHigh = node->_high;
+   if ( node->_left != NULL && node->_maxHigh < node->_left->_maxHigh ) node->_maxHigh = node->_left->_maxHigh;
+   if ( node->_right != NULL && node->_maxHigh < node->_right->_maxHigh ) node->_maxHigh = node->_right->_maxHigh;
+}
+
+template <typename K, typename V>
+typename IntervalTree<K,V>::Node * IntervalTree<K,V>::merge ( Node *left, Node *right )
+{
+   if ( left == NULL ) return right;
+   if ( right == NULL ) return left;
+
+   if ( left->_priority > right->_priority ) {
+      left->_right = merge( left->_right, right );
+      update( left );
+      return left;
+   }
+   right->_left = merge( left, right->_left );
+   update( right );
+   return right;
+}
+
+template <typename K, typename V>
+inline typename IntervalTree<K,V>::Node * IntervalTree<K,V>::allocate ( const K &low, const K &high, const V &value )
+{
+   Node *node = _free;
+   if ( node != NULL ) _free = node->_right;
+   else node = NEW Node;
+
+   // xorshift32
+   _seed ^= _seed << 13;
+   _seed ^= _seed >> 17;
+   _seed ^= _seed << 5;
+
+   node->_low = low;
+   node->_high = high;
+   node->_maxHigh = high;
+   node->_value = value;
+   node->_priority = _seed;
+   node->_left = NULL;
+   node->_right = NULL;
+   return node;
+}
+
+template <typename K, typename V>
+typename IntervalTree<K,V>::Node * IntervalTree<K,V>::insert ( Node *node, Node *item, bool &inserted )
+{
+   if ( node == NULL ) {
+      inserted = true;
+      return item;
+   }
+
+   if ( less( item->_low, item->_high, node->_low, node->_high ) ) {
+      node->_left = insert( node->_left, item, inserted );
+      if ( node->_left->_priority > node->_priority ) {
+         // Rotate right
+         Node *top = node->_left;
+         node->_left = top->_right;
+         top->_right = node;
+         update( node );
+         node = top;
+      }
+   } else if ( less( node->_low, node->_high, item->_low, item->_high ) ) {
+      node->_right = insert( node->_right, item, inserted );
+      if ( node->_right->_priority > node->_priority ) {
+         // Rotate left
+         Node *top = node->_right;
+         node->_right = top->_left;
+         top->_left = node;
+         update( node );
+         node = top;
+      }
+   } else {
+      inserted = false;
+      return node;
+   }
+   update( node );
+   return node;
+}
+
+template <typename K, typename V>
+bool IntervalTree<K,V>::insert ( const K &low, const K &high, const V &value )
+{
+   Node *item = allocate( low, high, value );
+   bool inserted = false;
+   _root = insert( _root, item, inserted );
+
+   if ( inserted ) {
+      _size++;
+   } else {
+      item->_right = _free;
+      _free = item;
+   }
+   return inserted;
+}
+
+template <typename K, typename V>
+V * IntervalTree<K,V>::find ( const K &low, const K &high ) const
+{
+   Node *node = _root;
+   while ( node != NULL ) {
+      if ( less( low, high, node->_low, node->_high ) ) node = node->_left;
+      else if ( less( node->_low, node->_high, low, high ) ) node = node->_right;
+      else return &node->_value;
+   }
+   return NULL;
+}
+
+template <typename K, typename V>
+typename IntervalTree<K,V>::Node * IntervalTree<K,V>::erase ( Node *node, const K &low, const K &high, bool &erased )
+{
+   if ( node == NULL ) return NULL;
+
+   if ( less( low, high, node->_low, node->_high ) ) {
+      node->_left = erase( node->_left, low, high, erased );
+   } else if ( less( node->_low, node->_high, low, high ) ) {
+      node->_right = erase( node->_right, low, high, erased );
+   } else {
+      Node *replacement = merge( node->_left, node->_right );
+      node->_right = _free;
+      _free = node;
+      erased = true;
+      return replacement;
+   }
+   update( node );
+   return node;
+}
+
+template <typename K, typename V>
+size_t IntervalTree<K,V>::erase ( const K &low, const K &high )
+{
+   bool erased = false;
+   _root = erase( _root, low, high, erased );
+   if ( !erased ) return 0;
+
+   _size--;
+   return 1;
+}
+
+template <typename K, typename V>
+void IntervalTree<K,V>::release ( Node *node )
+{
+   if ( node == NULL ) return;
+
+   release( node->_left );
+   release( node->_right );
+   node->_right = _free;
+   _free = node;
+}
+
+template <typename K, typename V>
+inline void IntervalTree<K,V>::clear ()
+{
+   release( _root );
+   _root = NULL;
+   _size = 0;
+}
+
+template <typename K, typename V>
+void IntervalTree<K,V>::findOverlaps ( const Node *node, const K &low, const K &high, std::vector<V> &result ) const
+{
+   // Nothing in this subtree ends at or after low
+   if ( node == NULL || node->_maxHigh < low ) return;
+
+   findOverlaps( node->_left, low, high, result );
+
+   // This node and its right subtree start after high
+   if ( high < node->_low ) return;
+
+   if ( !( node->_high < low ) ) result.push_back( node->_value );
+
+   findOverlaps( node->_right, low, high, result );
+}
+
+template <typename K, typename V>
+inline void IntervalTree<K,V>::findOverlaps ( const K &low, const K &high, std::vector<V> &result ) const
+{
+   findOverlaps( _root, low, high, result );
+}
+
+template <typename K, typename V>
+template <typename F>
+void IntervalTree<K,V>::forEach ( const Node *node, F &f ) const
+{
+   if ( node == NULL ) return;
+
+   forEach( node->_left, f );
+   f( node->_low, node->_high, node->_value );
+   forEach( node->_right, f );
+}
+
+template <typename K, typename V>
+template <typename F>
+inline void IntervalTree<K,V>::forEach ( F &f ) const
+{
+   forEach( _root, f );
+}
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,102 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_INTERVALTREE_DECL
+#define _NANOS_INTERVALTREE_DECL
+
+#include <stddef.h>
+#include <vector>
+
+namespace nanos {
+
+  /*! \brief Set of closed intervals [low,high] that answers overlap queries
+   *
+   *  Intervals are kept in a treap ordered by (low,high), where every node also
+   *  stores the highest end of its subtree. Inserting, removing and finding an
+   *  interval is O(log n) expected, and reporting the k intervals that overlap a
+   *  given one is O(log n + k). Removed nodes are kept in a free list and reused
+   *  by the next insertions, they are only released when the tree is destroyed.
+   */
+   template <typename K, typename V>
+   class IntervalTree
+   {
+      private:
+         struct Node {
+            K             _low;      /**< Interval start */
+            K             _high;     /**< Interval end (included) */
+            K             _maxHigh;  /**< Highest end of this subtree */
+            V             _value;    /**< Value associated to the interval */
+            unsigned int  _priority; /**< Heap priority (random) */
+            Node         *_left;
+            Node         *_right;
+         };
+
+         Node         *_root;     /**< Root of the treap */
+         Node         *_free;     /**< Removed nodes, chained through _right */
+         size_t        _size;     /**< Number of intervals */
+         unsigned int  _seed;     /**< Priority generator state */
+
+         /*! \brief Copy constructor (private) */
+         IntervalTree ( const IntervalTree & );
+         /*! \brief Copy assignment operator (private) */
+         const IntervalTree & operator= ( const IntervalTree & );
+
+         static bool less ( const K &low1, const K &high1, const K &low2, const K &high2 );
+         static void update ( Node *node );
+         static Node * merge ( Node *left, Node *right );
+
+         Node * allocate ( const K &low, const K &high, const V &value );
+         Node * insert ( Node *node, Node *item, bool &inserted );
+         Node * erase ( Node *node, const K &low, const K &high, bool &erased );
+         void release ( Node *node );
+         void findOverlaps ( const Node *node, const K &low, const K &high, std::vector<V> &result ) const;
+         template <typename F>
+         void forEach ( const Node *node, F &f ) const;
+      public:
+         /*! \brief IntervalTree default constructor */
+         IntervalTree ();
+         /*! \brief IntervalTree destructor */
+         ~IntervalTree ();
+
+         size_t size () const { return _size; }
+         bool empty () const { return _size == 0; }
+
+         /*! \brief Adds [low,high] associated to value, unless it is already present
+          *  \return Whether it has been inserted
+          */
+         bool insert ( const K &low, const K &high, const V &value );
+         /*! \brief Returns the value of [low,high], or NULL if not present */
+         V * find ( const K &low, const K &high ) const;
+         /*! \brief Removes [low,high], if present
+          *  \return Number of intervals removed (0 or 1)
+          */
+         size_t erase ( const K &low, const K &high );
+         /*! \brief Removes all the intervals (their nodes are kept for reuse) */
+         void clear ();
+
+         /*! \brief Appends to result the values of all the intervals overlapping [low,high], in (low,high) order */
+         void findOverlaps ( const K &low, const K &high, std::vector<V> &result ) const;
+         /*! \brief Calls f( low, high, value ) for every interval, in (low,high) order */
+         template <typename F>
+         void forEach ( F &f ) const;
+   };
+
+} // namespace nanos
+
+#endif
@@ -23,6 +23,9 @@
 #include <map>
 #include <list>
 #include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <new>
 
 namespace nanos {
 
@@ -95,14 +98,136 @@ class MemoryChunk {
       static void partitionEnd( MemoryChunk &mcA, MemoryChunk const &mcB );
 };
 
+/*! \brief Storage of the nodes of a single MemoryMap
+ *
+ *  Nodes are carved from slabs and recycled through a free list, so splitting and
+ *  removing chunks does not go to the global allocator and the nodes of a map stay
+ *  close in memory. Slabs are released when the map is destroyed. Not thread safe,
+ *  as the map using it.
+ */
+class MemoryMapArena {
+   private:
+      struct FreeNode {
+         FreeNode *_next;
+      };
+
+      static const std::size_t NODES_PER_SLAB = 64;
+
+      std::size_t  _nodeSize;
+      FreeNode    *_freeNodes;
+      void        *_slabs;      /**< Slabs list, linked through their first word */
+      unsigned int _references;
+
+      MemoryMapArena( MemoryMapArena const &arena );
+      MemoryMapArena & operator=( MemoryMapArena const &arena );
+
+   public:
+      MemoryMapArena() : _nodeSize( 0 ), _freeNodes( NULL ), _slabs( NULL ), _references( 1 ) { }
+      ~MemoryMapArena() {
+         while ( _slabs != NULL ) {
+            void *next = *( void ** ) _slabs;
+            ::free( _slabs );
+            _slabs = next;
+         }
+      }
+
+      void addReference() { _references++; }
+      bool removeReference() { return --_references == 0; }
+
+      //! \brief Whether nodes of size bytes are served by this arena (the first size it serves)
+      bool serves( std::size_t size ) {
+         if ( _nodeSize == 0 ) {
+            _nodeSize = size < sizeof( FreeNode ) ? sizeof( FreeNode ) : size;
+            _nodeSize = ( _nodeSize + sizeof( void * ) - 1 ) & ~( sizeof( void * ) - 1 );
+         }
+         return size <= _nodeSize && size * 2 > _nodeSize;
+      }
+
+      void *allocate() {
+         if ( _freeNodes == NULL ) {
+            char *slab = ( char * ) ::malloc( sizeof( void * ) + _nodeSize * NODES_PER_SLAB );
+            if ( slab == NULL ) throw std::bad_alloc();
+            *( void ** ) slab = _slabs;
+            _slabs = slab;
+            for ( std::size_t idx = 0; idx < NODES_PER_SLAB; idx += 1 ) {
+               FreeNode *node = ( FreeNode * ) ( slab + sizeof( void * ) + idx * _nodeSize );
+               node->_next = _freeNodes;
+               _freeNodes = node;
+            }
+         }
+         FreeNode *node = _freeNodes;
+         _freeNodes = node->_next;
+         return node;
+      }
+
+      void release( void *ptr ) {
+         FreeNode *node = ( FreeNode * ) ptr;
+         node->_next = _freeNodes;
+         _freeNodes = node;
+      }
+};
+
+/*! \brief STL allocator of the MemoryMap nodes. A default constructed allocator gets its own
+ *  arena, copies (including the rebound ones std::map makes for its nodes) share it.
+ */
+template < typename T >
+class MemoryMapAllocator {
+   public:
+      typedef T value_type;
+      typedef value_type* pointer;
+      typedef const value_type* const_pointer;
+      typedef value_type& reference;
+      typedef const value_type& const_reference;
+      typedef std::size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      template < typename U >
+      struct rebind {
+         typedef MemoryMapAllocator< U > other;
+      };
+
+      MemoryMapArena *_arena;
+
+      MemoryMapAllocator() : _arena( NEW MemoryMapArena() ) { }
+      MemoryMapAllocator( MemoryMapAllocator const &a ) : _arena( a._arena ) { _arena->addReference(); }
+      template < typename U >
+      MemoryMapAllocator( MemoryMapAllocator< U > const &a ) : _arena( a._arena ) { _arena->addReference(); }
+      ~MemoryMapAllocator() { if ( _arena->removeReference() ) delete _arena; }
+
+      pointer address( reference r ) const { return &r; }
+      const_pointer address( const_reference r ) const { return &r; }
+      size_type max_size() const { return ( (size_type) -1 ) / sizeof( T ); }
+
+      pointer allocate( size_type n, const void * = 0 ) {
+         if ( n == 1 && _arena->serves( sizeof( T ) ) ) return ( pointer ) _arena->allocate();
+         pointer p = ( pointer ) ::malloc( n * sizeof( T ) );
+         if ( p == NULL ) throw std::bad_alloc();
+         return p;
+      }
+      void deallocate( pointer p, size_type n ) {
+         if ( n == 1 && _arena->serves( sizeof( T ) ) ) _arena->release( p );
+         else ::free( p );
+      }
+      void construct( pointer p, const T& t ) { new( p ) T( t ); }
+      void destroy( pointer p ) { p->~T(); }
+
+      template < typename U >
+      bool operator==( MemoryMapAllocator< U > const &a ) const { return _arena == a._arena; }
+      template < typename U >
+      bool operator!=( MemoryMapAllocator< U > const &a ) const { return _arena != a._arena; }
+
+   private:
+      MemoryMapAllocator & operator=( MemoryMapAllocator const &a );
+};
+
 template <typename _Type>
-class MemoryMap : public std::map< MemoryChunk, _Type * > { 
-   using std::map< MemoryChunk, _Type *>::operator=;
-   //private:
-   //   const MemoryMap & operator=( const MemoryMap &mm ) { this->std::map< MemoryChunk}
+class MemoryMap : public std::map< MemoryChunk, _Type *, std::less< MemoryChunk >, MemoryMapAllocator< std::pair< const MemoryChunk, _Type * > > > { 
    public:
       //typedef enum { MEM_CHUNK_FOUND, MEM_CHUNK_NOT_FOUND, MEM_CHUNK_NOT_FOUND_BUT_ALLOCATED } QueryResult;
-      typedef std::map< MemoryChunk, _Type * > BaseMap;
+      typedef std::map< MemoryChunk, _Type *, std::less< MemoryChunk >, MemoryMapAllocator< std::pair< const MemoryChunk, _Type * > > > BaseMap;
+   private:
+      using BaseMap::operator=;
+   public:
       typedef std::pair< const MemoryChunk *, _Type ** > MemChunkPair;
       typedef std::list< MemChunkPair > MemChunkList;
       typedef std::pair< MemoryChunk, _Type * > ConstMemChunkPair;
@@ -110,8 +235,9 @@ class MemoryMap : public std::map< MemoryChunk, _Type * > {
       typedef typename BaseMap::iterator iterator;
       typedef typename BaseMap::const_iterator const_iterator;
 
-      MemoryMap() : std::map< MemoryChunk, _Type * >() { }
-      MemoryMap( const MemoryMap &mm ) : std::map< MemoryChunk, _Type * >( mm ) { }
+      MemoryMap() : BaseMap() { }
+      //! \brief Copy constructor, the copy gets its own arena
+      MemoryMap( const MemoryMap &mm ) : BaseMap( mm.begin(), mm.end() ) { }
       ~MemoryMap() {
          for ( iterator it = this->begin(); it != this->end(); it++ ) {
             delete it->second;
@@ -137,11 +263,11 @@ class MemoryMap : public std::map< MemoryChunk, _Type * > {
 
 #if 1
 template <> 
-class MemoryMap<uint64_t> : public std::map< MemoryChunk, uint64_t > {
+class MemoryMap<uint64_t> : public std::map< MemoryChunk, uint64_t, std::less< MemoryChunk >, MemoryMapAllocator< std::pair< const MemoryChunk, uint64_t > > > {
    public:
-      MemoryMap( const MemoryMap &mm ) : std::map< MemoryChunk, uint64_t> () { }
+      typedef std::map< MemoryChunk, uint64_t, std::less< MemoryChunk >, MemoryMapAllocator< std::pair< const MemoryChunk, uint64_t > > > BaseMap;
+      MemoryMap( const MemoryMap &mm ) : BaseMap() { }
       const MemoryMap & operator=( const MemoryMap &mm );// { return *this; }
-      typedef std::map< MemoryChunk, uint64_t > BaseMap;
       typedef BaseMap::iterator iterator;
       typedef BaseMap::const_iterator const_iterator;
 
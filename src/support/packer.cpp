@@ -21,77 +21,93 @@
 #include "system.hpp"
 
 #include <iostream>
+#include <string.h>
 
 using namespace nanos;
 
+//! \brief Copies count rows of LEN bytes; the fixed size lets the compiler use vector moves
+template < std::size_t LEN >
+static inline void copyRows( char *dst, std::size_t dstLd, char const *src, std::size_t srcLd, std::size_t count ) {
+   for ( std::size_t i = 0; i < count; i += 1 ) {
+      ::memcpy( &dst[ i * dstLd ], &src[ i * srcLd ], LEN );
+   }
+}
+
+static void copyRows( char *dst, std::size_t dstLd, char const *src, std::size_t srcLd, std::size_t len, std::size_t count ) {
+   if ( dstLd == len && srcLd == len ) {
+      ::memcpy( dst, src, len * count );
+      return;
+   }
+   switch ( len ) {
+      case 4:   copyRows<4>( dst, dstLd, src, srcLd, count ); break;
+      case 8:   copyRows<8>( dst, dstLd, src, srcLd, count ); break;
+      case 16:  copyRows<16>( dst, dstLd, src, srcLd, count ); break;
+      case 32:  copyRows<32>( dst, dstLd, src, srcLd, count ); break;
+      case 64:  copyRows<64>( dst, dstLd, src, srcLd, count ); break;
+      case 128: copyRows<128>( dst, dstLd, src, srcLd, count ); break;
+      case 256: copyRows<256>( dst, dstLd, src, srcLd, count ); break;
+      case 512: copyRows<512>( dst, dstLd, src, srcLd, count ); break;
+      default:
+         for ( std::size_t i = 0; i < count; i += 1 ) {
+            ::memcpy( &dst[ i * dstLd ], &src[ i * srcLd ], len );
+         }
+   }
+}
 
-bool Packer::PackInfo::operator<( Packer::PackInfo const &pack ) const {
-   return _addr < pack._addr;
+void Packer::pack( char *packed, char const *strided, std::size_t len, std::size_t count, std::size_t ld ) {
+   copyRows( packed, len, strided, ld, len, count );
 }
 
-bool Packer::PackInfo::overlaps( uint64_t addr ) const {
-   return addr < ( _addr + _len * _count );
+void Packer::unpack( char *strided, char const *packed, std::size_t len, std::size_t count, std::size_t ld ) {
+   copyRows( strided, ld, packed, len, len, count );
 }
 
-bool Packer::PackInfo::sizeMatch( std::size_t len, std::size_t count ) const {
-   return len == _len && count == _count ;
+unsigned int Packer::poolClass( std::size_t size ) {
+   unsigned int pclass = 0;
+   while ( ( ( (std::size_t) 1 ) << pclass ) < size ) pclass++;
+   return pclass;
+}
+
+//! \brief Returns the pooled buffers to the allocator, _lock must be held
+void Packer::releasePool() {
+   _allocator->lock();
+   for ( unsigned int pclass = 0; pclass < NUM_POOL_CLASSES; pclass += 1 ) {
+      for ( std::vector< void * >::iterator it = _pool[ pclass ].begin(); it != _pool[ pclass ].end(); it++ ) {
+         _allocator->free( *it );
+      }
+      _pool[ pclass ].clear();
+   }
+   _allocator->unlock();
 }
 
 void * Packer::give_pack( uint64_t addr, std::size_t len, std::size_t count ) {
    void *result = NULL;
-   PackInfo key( addr, len, count );
+   std::size_t size = len * count;
 
-#if 1 /* simple implementation */
    _lock.acquire();
    if ( _allocator == NULL ) _allocator = sys.getNetwork()->getPackerAllocator();
-   _allocator->lock();
-   result = _allocator->allocate( len * count );
-   _allocator->unlock();
-   _lock.release();
-#else
-   _lock.acquire();
-   //std::map< PackInfo, void *>::iterator it = _packs.lower_bound( key );
-   mapIterator it = _packs.lower_bound( key );
-   if ( it == _packs.end() || _packs.key_comp()( key, it->first ) || !it->first.sizeMatch( len, count ) ) {
-      if ( it == _packs.end() ) { /* not found */
-         if ( it != _packs.begin() ) {
-            mapIterator previous = it;
-            //std::map< PackInfo, void *>::iterator previous = it;
-            previous--;
-            //if ( previous->first.overlaps( addr ) ) {
-            //   std::cerr << "overlap with previous" << std::endl;
-            //} else {
-               if ( _allocator == NULL ) _allocator = sys.getNetwork()->getPackerAllocator();
-               _allocator->lock();
-               result = _allocator->allocate( len * count );
-               _allocator->unlock();
-               _packs.insert( it, std::make_pair( key, PackMemory( result ) ) );
-            //}
-         } else { 
-            //std::cerr << "begin chunk" << std::endl;
-            if ( _allocator == NULL ) _allocator = sys.getNetwork()->getPackerAllocator();
-            _allocator->lock();
-            result = _allocator->allocate( len * count );
-            _allocator->unlock();
-            _packs.insert( it, std::make_pair( key, PackMemory( result ) ) );
-         }
-      } else if ( _packs.key_comp()( key, it->first )  ) { /* not equal: key < it */
-         //std::cerr << "not equal addr equal addr" << std::endl;
-         if ( _allocator == NULL ) _allocator = sys.getNetwork()->getPackerAllocator();
+   if ( size <= MAX_POOLED_SIZE ) {
+      unsigned int pclass = poolClass( size );
+      if ( !_pool[ pclass ].empty() ) {
+         result = _pool[ pclass ].back();
+         _pool[ pclass ].pop_back();
+      } else {
+         size = ( (std::size_t) 1 ) << pclass;
+      }
+   }
+   if ( result == NULL ) {
+      _allocator->lock();
+      result = _allocator->allocate( size );
+      _allocator->unlock();
+      if ( result == NULL ) {
+         releasePool();
          _allocator->lock();
-         result = _allocator->allocate( len * count );
+         result = _allocator->allocate( size );
          _allocator->unlock();
-         _packs.insert( it, std::make_pair( key, result ) );
-      } else { /* eq addr, no size match*/
-         if (sys.getNetwork()->getNodeNum() == 0) std::cerr << "equal addr, different size" << std::endl;
-         fatal("Unhandled case\n");
       }
-   } else { /* exact match */
-      if (sys.getNetwork()->getNodeNum() == 0) std::cerr << "exact match chunk " << (void *) addr << " pack addr "<< it->second.getMemory()  << std::endl;
-      result = it->second.getMemoryAndIncreaseReferences();
    }
    _lock.release();
-#endif
+
    if ( result == NULL ) {
       std::cerr << "Error: could not get a memory area to pack data. Requested " << ( len*count) << " bytes, capacity " << _allocator->getCapacity() << " bytes."<< std::endl;
       printBt(std::cerr);
@@ -102,27 +118,18 @@ void * Packer::give_pack( uint64_t addr, std::size_t len, std::size_t count ) {
 
 bool Packer::free_pack( uint64_t addr, std::size_t len, std::size_t count, void *allocAddr ) {
    bool result = true;
-#if 1
+   std::size_t size = len * count;
    _lock.acquire();
-   _allocator->lock();
-   if ( _allocator->free( allocAddr ) == 0 ) {
-      result = false;
-   }
-   _allocator->unlock();
-   _lock.release();
-#else
-   PackInfo key( addr, len, count );
-   _lock.acquire();
-   _allocator->lock();
-   mapIterator it = _packs.find( key );
-   //if (sys.getNetwork()->getNodeNum() == 0) std::cerr <<"pack frees h: " << (void *) addr << " pack addr " <<  it->second << std::endl;
-   if ( it->second.decreaseReferences() == 0 ) {
-      _allocator->free( it->second.getMemory() );
-      _packs.erase( it );
+   if ( size <= MAX_POOLED_SIZE ) {
+      _pool[ poolClass( size ) ].push_back( allocAddr );
+   } else {
+      _allocator->lock();
+      if ( _allocator->free( allocAddr ) == 0 ) {
+         result = false;
+      }
+      _allocator->unlock();
    }
-   _allocator->unlock();
    _lock.release();
-#endif
    return result;
 }
 
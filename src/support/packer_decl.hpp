@@ -21,55 +21,43 @@
 #define PACKER_DECL_H
 
 #include <stdint.h>
-#include <map>
+#include <vector>
 #include "simpleallocator_decl.hpp"
 
 namespace nanos {
 
+/*! \brief Provides the buffers used to pack strided regions and the pack/unpack routines
+ *
+ *  Released buffers are kept in a pool, by size class (power of two), and given again to
+ *  requests of the same class. The pool is returned to the allocator when it can not
+ *  serve a request. Packs bigger than MAX_POOLED_SIZE are not pooled.
+ */
 class Packer {
 
-   class PackInfo {
-      uint64_t    _addr;
-      std::size_t _len;
-      std::size_t _count;
+   static const unsigned int NUM_POOL_CLASSES = 24;
+   static const std::size_t MAX_POOLED_SIZE = ( (std::size_t) 1 ) << ( NUM_POOL_CLASSES - 1 );
 
-      public:
-         PackInfo() : _addr( 0 ), _len ( 0 ), _count( 0 ) { }
-         PackInfo( uint64_t addr, std::size_t len, std::size_t count ) : _addr( addr ), _len ( len ), _count( count ) { }
-         PackInfo( PackInfo const &pack ) : _addr( pack._addr ), _len ( pack._len ), _count( pack._count ) { }
-         bool operator<( PackInfo const &pack ) const;
-         bool overlaps( uint64_t addr ) const;
-         bool sizeMatch( std::size_t len, std::size_t count ) const;
-   };
-
-   class PackMemory {
-      void * _memory;
-      Atomic<unsigned int> _refCounter;
-
-      public:
-         PackMemory() : _memory( NULL ), _refCounter( 0 ) { }
-         PackMemory( void *mem ) : _memory( mem ), _refCounter( 1 ) { }
-         PackMemory( PackMemory const &pm ) : _memory( pm._memory ), _refCounter( pm._refCounter.value() ) { }
-         void *getMemoryAndIncreaseReferences() { _refCounter++; return _memory; }
-         unsigned int decreaseReferences() { unsigned int value = --_refCounter; return value; }
-         void *getMemory() const { return _memory; }
-   };
-
-   std::map< PackInfo, PackMemory > _packs;
+   std::vector< void * > _pool[ NUM_POOL_CLASSES ];
    SimpleAllocator *_allocator;
    Lock _lock;
 
-   typedef std::map< PackInfo, PackMemory >::iterator mapIterator;
-
    private:
       Packer( Packer const &p );
       bool operator=( Packer const &p );
 
+      static unsigned int poolClass( std::size_t size );
+      void releasePool();
+
    public:
-      Packer() : _packs(), _allocator( NULL ) {}
+      Packer() : _allocator( NULL ) {}
       void *give_pack( uint64_t addr, std::size_t len, std::size_t count );
       bool free_pack( uint64_t addr, std::size_t len, std::size_t count, void *allocAddr );
       void setAllocator( SimpleAllocator *alloc );
+
+      /*! \brief Gathers count rows of len bytes, ld bytes apart, into packed */
+      static void pack( char *packed, char const *strided, std::size_t len, std::size_t count, std::size_t ld );
+      /*! \brief Scatters count rows of len bytes from packed to strided, ld bytes apart */
+      static void unpack( char *strided, char const *packed, std::size_t len, std::size_t count, std::size_t ld );
 };
 
 } // namespace nanos
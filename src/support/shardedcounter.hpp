@@ -0,0 +1,70 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_SHARDEDCOUNTER
+#define _NANOS_SHARDEDCOUNTER
+
+#include "shardedcounter_decl.hpp"
+#include "atomic.hpp"
+
+namespace nanos {
+
+inline int ShardedCounter::getShard ()
+{
+   if ( _myShard < 0 ) _myShard = ( _nextShard++ ) % _numShards;
+   return _myShard;
+}
+
+inline int ShardedCounter::add ( int delta )
+{
+   Shard &shard = _shards[getShard()];
+   int pending = ( shard._delta += delta );
+
+   if ( pending >= _flushThreshold || pending <= -_flushThreshold ) {
+      shard._delta -= pending;
+      return ( _total += pending );
+   }
+   return _total.value() + pending;
+}
+
+inline void ShardedCounter::flush ()
+{
+   Shard &shard = _shards[getShard()];
+   int pending = shard._delta.value();
+   if ( pending == 0 ) return;
+
+   shard._delta -= pending;
+   _total += pending;
+}
+
+inline int ShardedCounter::value () const
+{
+   // Shards are assigned in order, the ones never handed out are still zero
+   int used = _nextShard.value();
+   if ( used > _numShards ) used = _numShards;
+
+   memoryFence();
+   int result = _total.value();
+   for ( int i = 0; i < used; i++ ) result += _shards[i]._delta.value();
+   return result;
+}
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,109 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#ifndef _NANOS_SHARDEDCOUNTER_DECL
+#define _NANOS_SHARDEDCOUNTER_DECL
+
+#include "atomic_decl.hpp"
+#include "allocator_decl.hpp"
+
+namespace nanos {
+
+  /*! \brief Integer counter updated from many threads and read from a few places
+   *
+   *  Each thread accumulates its updates in its own cache-line padded shard and
+   *  only publishes them to the shared total when they reach _flushThreshold
+   *  (in absolute value) or when flush() is called, so updates do not bounce a
+   *  single cache line between all the cores.
+   *
+   *  approximate() returns the shared total, which may lag the real value by
+   *  less than _flushThreshold per thread, and costs a single load. value()
+   *  adds all the shards and is exact once the updaters are quiescent.
+   */
+   class ShardedCounter
+   {
+      public:
+         static const int _numShards = 64;        /**< Threads beyond this share shards */
+         static const int _flushThreshold = 16;   /**< Pending updates kept in a shard */
+      private:
+         struct Shard {
+            Atomic<int>    _delta;
+            char           _pad[NANOS_CACHELINE - sizeof(Atomic<int>)];
+            Shard () : _delta( 0 ) {}
+         };
+
+         Atomic<int>             _total;          /**< Published value */
+         char                    _pad[NANOS_CACHELINE - sizeof(Atomic<int>)];
+         Shard                   _shards[_numShards];
+
+         static Atomic<int>      _nextShard;      /**< Next shard to assign to a thread */
+         static __thread int     _myShard;        /**< Shard of the current thread (-1 until first use) */
+      private:
+         /*! \brief ShardedCounter copy constructor (private)
+          */
+         ShardedCounter ( const ShardedCounter &sc );
+         /*! \brief ShardedCounter copy assignment operator (private)
+          */
+         ShardedCounter & operator= ( const ShardedCounter &sc );
+
+         static int getShard ();
+      public:
+         /*! \brief ShardedCounter constructor
+          */
+         ShardedCounter ( int init = 0 ) : _total( init ), _shards() {}
+         /*! \brief ShardedCounter destructor
+          */
+         ~ShardedCounter () {}
+
+         /*! \brief Adds delta to the counter
+          *  \return Approximate value after the update (exact for the calling thread's updates)
+          */
+         int add ( int delta );
+
+         int operator++ () { return add( 1 ); }
+         int operator-- () { return add( -1 ); }
+         int operator++ ( int ) { return add( 1 ) - 1; }
+         int operator-- ( int ) { return add( -1 ) + 1; }
+         int operator+= ( int delta ) { return add( delta ); }
+         int operator-= ( int delta ) { return add( -delta ); }
+
+         /*! \brief Publishes the pending updates of the calling thread
+          */
+         void flush ();
+
+         /*! \brief Returns the published value (single load, may lag behind)
+          */
+         int approximate () const { return _total.value(); }
+
+         /*! \brief Returns the sum of the published value and all the pending updates
+          */
+         int value () const;
+
+         /*! \brief Address of the published value (used by condition checkers)
+          */
+#ifdef HAVE_NEW_GCC_ATOMIC_OPS
+         int * getApproximateAddr () { return &_total.override(); }
+#else
+         volatile int * getApproximateAddr () { return &_total.override(); }
+#endif
+   };
+
+} // namespace nanos
+
+#endif
@@ -26,183 +26,214 @@
 
 using namespace nanos;
 
-SimpleAllocator::SimpleAllocator( uint64_t baseAddress, std::size_t len ) : _baseAddress( baseAddress ), _remaining ( len ), _capacity( len )
+SimpleAllocator::SimpleAllocator( uint64_t baseAddress, std::size_t len ) : _allocatedBlocks(), _nonEmptyClasses( 0 ),
+   _firstBlock( NULL ), _unusedHeaders( NULL ), _headerSlabs(), _baseAddress( 0 ), _remaining( 0 ), _capacity( 0 )
 {
-   _freeChunks[ baseAddress ] = len;
+   for ( unsigned int idx = 0; idx < NUM_CLASSES; idx += 1 ) _freeLists[idx] = NULL;
+   init( baseAddress, len );
+}
+
+SimpleAllocator::SimpleAllocator() : _allocatedBlocks(), _nonEmptyClasses( 0 ), _firstBlock( NULL ),
+   _unusedHeaders( NULL ), _headerSlabs(), _baseAddress( 0 ), _remaining( 0 ), _capacity( 0 )
+{
+   for ( unsigned int idx = 0; idx < NUM_CLASSES; idx += 1 ) _freeLists[idx] = NULL;
+}
+
+SimpleAllocator::~SimpleAllocator()
+{
+   for ( std::list< Block * >::iterator it = _headerSlabs.begin(); it != _headerSlabs.end(); it++ ) {
+      delete[] *it;
+   }
 }
 
 void SimpleAllocator::init( uint64_t baseAddress, std::size_t len )
 {
    _baseAddress = baseAddress;
-   _freeChunks[ baseAddress ] = len;
    _remaining = len;
    _capacity = len;
+   if ( len == 0 ) return;
+
+   _firstBlock = newBlock( baseAddress, len );
+   insertFree( _firstBlock );
 }
 
-void * SimpleAllocator::allocate( std::size_t size )
+unsigned int SimpleAllocator::sizeClass( std::size_t size )
 {
-   SegmentMap::iterator mapIter = _freeChunks.begin();
-   void * retAddr = (void *) 0;
-   ensure(size != 0, "Error, can't allocate 0 bytes.");
+   unsigned int sclass = 0;
+   while ( size >>= 1 ) sclass++;
+   return sclass;
+}
 
-   while( mapIter != _freeChunks.end() && mapIter->second < size )
-   {
-      mapIter++;
+SimpleAllocator::Block * SimpleAllocator::newBlock( uint64_t address, std::size_t size )
+{
+   if ( _unusedHeaders == NULL ) {
+      Block *slab = NEW Block[HEADERS_PER_SLAB];
+      _headerSlabs.push_back( slab );
+      for ( unsigned int idx = 0; idx < HEADERS_PER_SLAB; idx += 1 ) {
+         slab[idx]._nextFree = _unusedHeaders;
+         _unusedHeaders = &slab[idx];
+      }
    }
-   if ( mapIter != _freeChunks.end() ) {
+   Block *block = _unusedHeaders;
+   _unusedHeaders = block->_nextFree;
+
+   block->_address = address;
+   block->_size = size;
+   block->_free = false;
+   block->_prev = NULL;
+   block->_next = NULL;
+   block->_prevFree = NULL;
+   block->_nextFree = NULL;
+   return block;
+}
 
-      uint64_t targetAddr = mapIter->first;
-      std::size_t chunkSize = mapIter->second;
+void SimpleAllocator::deleteBlock( Block *block )
+{
+   block->_nextFree = _unusedHeaders;
+   _unusedHeaders = block;
+}
 
-      _freeChunks.erase( mapIter );
+void SimpleAllocator::insertFree( Block *block )
+{
+   unsigned int sclass = sizeClass( block->_size );
+   block->_free = true;
+   block->_prevFree = NULL;
+   block->_nextFree = _freeLists[sclass];
+   if ( _freeLists[sclass] != NULL ) _freeLists[sclass]->_prevFree = block;
+   _freeLists[sclass] = block;
+   _nonEmptyClasses |= ( (uint64_t) 1 ) << sclass;
+}
+
+void SimpleAllocator::removeFree( Block *block )
+{
+   unsigned int sclass = sizeClass( block->_size );
+   if ( block->_prevFree != NULL ) {
+      block->_prevFree->_nextFree = block->_nextFree;
+   } else {
+      _freeLists[sclass] = block->_nextFree;
+      if ( _freeLists[sclass] == NULL ) _nonEmptyClasses &= ~( ( (uint64_t) 1 ) << sclass );
+   }
+   if ( block->_nextFree != NULL ) block->_nextFree->_prevFree = block->_prevFree;
+   block->_free = false;
+   block->_prevFree = NULL;
+   block->_nextFree = NULL;
+}
+
+//! \brief Splits a block (not in a free list) in two, the first one keeping size bytes
+//! \return The second block
+SimpleAllocator::Block * SimpleAllocator::splitBlock( Block *block, std::size_t size )
+{
+   Block *rest = newBlock( block->_address + size, block->_size - size );
+   rest->_prev = block;
+   rest->_next = block->_next;
+   if ( block->_next != NULL ) block->_next->_prev = rest;
+   block->_next = rest;
+   block->_size = size;
+   return rest;
+}
 
-      //add the chunk with the new size (previous size - requested size)
-      if (chunkSize > size)
-         _freeChunks[ targetAddr + size ] = chunkSize - size ;
-      _allocatedChunks[ targetAddr ] = size;
+//! \brief Allocates size bytes at address from a free block (address must be inside it)
+void * SimpleAllocator::allocateBlock( Block *block, uint64_t address, std::size_t size )
+{
+   removeFree( block );
 
-      retAddr = ( void * ) targetAddr;
-      _remaining -= size;
+   // Leading gap, left free
+   if ( address > block->_address ) {
+      Block *head = block;
+      block = splitBlock( head, address - head->_address );
+      insertFree( head );
    }
-   else {
-      // Could not get a chunk of 'size' bytes
-      //*myThread->_file << __FUNCTION__ << " WARNING: Allocator is full, requested " << size << " bytes, remaining " << _remaining << " bytes." << std::endl;
-      //sys.printBt();
-      return NULL;
+   // Trailing part, left free
+   if ( block->_size > size ) {
+      insertFree( splitBlock( block, size ) );
    }
- //  *(myThread->_file) << "SimpleAllocator::allocate returns " << (void *) retAddr << std::endl;
 
-   return retAddr;
+   _allocatedBlocks[ address ] = block;
+   _remaining -= size;
+   return ( void * ) address;
 }
 
-void * SimpleAllocator::allocateSizeAligned( std::size_t size )
+void * SimpleAllocator::allocate( std::size_t size )
 {
-   SegmentMap::iterator mapIter = _freeChunks.begin();
-   void * retAddr = (void *) 0;
+   ensure(size != 0, "Error, can't allocate 0 bytes.");
+
+   // Blocks of the same class may be smaller than size, look for the first one that fits
+   unsigned int sclass = sizeClass( size );
+   for ( Block *block = _freeLists[sclass]; block != NULL; block = block->_nextFree ) {
+      if ( block->_size >= size ) return allocateBlock( block, block->_address, size );
+   }
 
+   // Any block of a greater class fits, take the smallest class available
+   uint64_t candidates = ( sclass + 1 < NUM_CLASSES ) ? _nonEmptyClasses & ~( ( ( (uint64_t) 1 ) << ( sclass + 1 ) ) - 1 ) : 0;
+   if ( candidates != 0 ) {
+      Block *block = _freeLists[ __builtin_ctzll( candidates ) ];
+      return allocateBlock( block, block->_address, size );
+   }
+
+   // Could not get a chunk of 'size' bytes
+   //*myThread->_file << __FUNCTION__ << " WARNING: Allocator is full, requested " << size << " bytes, remaining " << _remaining << " bytes." << std::endl;
+   //sys.printBt();
+   return NULL;
+}
+
+void * SimpleAllocator::allocateSizeAligned( std::size_t size )
+{
    std::size_t alignedLen;
    unsigned int count = 0;
    while ( (size >> count) != 1 ) count++;
    alignedLen = (1UL<<(count));
 
-   while( mapIter != _freeChunks.end() && 
-      mapIter->second < 
-      ( ( mapIter->first & ~(alignedLen-1) ) +
-        ( ( ( mapIter->first & (alignedLen-1) ) == 0 ) ? 0 : alignedLen ) +
-        size ) -
-       mapIter->first )
-   {
-      mapIter++;
-   }
-   if ( mapIter != _freeChunks.end() ) {
-      uint64_t chunkAddr = mapIter->first;
-      std::size_t chunkSize = mapIter->second;
-      uint64_t targetAddr = ( mapIter->first & ~(alignedLen-1) ) + ( ( ( mapIter->first & (alignedLen-1) ) == 0 ) ? 0 : alignedLen ) ;
-
-      //add the chunk with the new size (previous size - requested size)
-      if (chunkSize > size) {
-         if (targetAddr == chunkAddr ) {
-            _freeChunks.erase( chunkAddr ); 
-         } else { 
-            _freeChunks[ mapIter->first ] = ( targetAddr - chunkAddr );
+   for ( unsigned int sclass = sizeClass( size ); sclass < NUM_CLASSES; sclass += 1 ) {
+      for ( Block *block = _freeLists[sclass]; block != NULL; block = block->_nextFree ) {
+         uint64_t targetAddr = ( block->_address + alignedLen - 1 ) & ~( (uint64_t) alignedLen - 1 );
+         if ( targetAddr + size <= block->_address + block->_size ) {
+            return allocateBlock( block, targetAddr, size );
          }
-         if ((chunkAddr + chunkSize) - (targetAddr + size) > 0)
-            _freeChunks[ targetAddr + size ] = (chunkAddr + chunkSize) - (targetAddr + size) ;
-      } else if ( chunkSize == size ) {
-         _freeChunks.erase( chunkAddr );
-      } else { fprintf(stderr, "Error, this does not make sense!\n"); }
-      _allocatedChunks[ targetAddr ] = size;
-
-      retAddr = ( void * ) targetAddr ;
-      _remaining -= size;
-   }
-   else {
-      // Could not get a chunk of 'size' bytes
-      *myThread->_file << sys.getNetwork()->getNodeNum() << ": WARNING: Allocator is full" << std::endl;
-      return NULL;
+      }
    }
 
-   return retAddr;
+   // Could not get a chunk of 'size' bytes
+   *myThread->_file << sys.getNetwork()->getNodeNum() << ": WARNING: Allocator is full" << std::endl;
+   return NULL;
 }
 
 std::size_t SimpleAllocator::free( void *address )
 {
-   ensure( !_allocatedChunks.empty(), "Empty _allocatedChunks!");
+   ensure( !_allocatedBlocks.empty(), "Empty _allocatedChunks!");
    //*(myThread->_file) << "SimpleAllocator::free " << (void *) address << std::endl;
-   SegmentMap::iterator mapIter = _allocatedChunks.find( ( uint64_t ) address );
+   BlockMap::iterator it = _allocatedBlocks.find( ( uint64_t ) address );
 
    // Unknown address, simply ignore
-   if( mapIter == _allocatedChunks.end() ) {
+   if( it == _allocatedBlocks.end() ) {
       //ensure0( false,"Unknown address deallocation (Simple Allocator)" ); //It can happen in OpenCL
       return 0;
    }
 
-   size_t size = mapIter->second;
-   std::pair< SegmentMap::iterator, bool > ret;
+   Block *block = it->second;
+   std::size_t size = block->_size;
    ensure (size != 0, "Invalid entry in _allocatedChunks, size == 0");
-
-   _allocatedChunks.erase( mapIter );
-
-   if ( !_freeChunks.empty() ) {
-      mapIter = _freeChunks.lower_bound( ( uint64_t ) address );
-
-      //case where address is the highest key, check if it can be merged with the previous chunk
-      if ( mapIter == _freeChunks.end() ) {
-         mapIter--;
-         if ( mapIter->first + mapIter->second == ( uint64_t ) address ) {
-            mapIter->second += size;
-         } else {
-            _freeChunks[ ( uint64_t ) address ] = size;
-         }
-      }
-      //address is not the highest key, check if it can be merged with the previous and next chunks
-      else if ( _freeChunks.key_comp()( ( uint64_t ) address, mapIter->first ) ) {
-         std::size_t totalSize = size;
-         bool firstMerge = false;
-
-         //check next chunk
-         if ( mapIter->first == ( ( uint64_t ) address ) + size ) {
-            totalSize += mapIter->second;
-            _freeChunks.erase( mapIter );
-            ret = _freeChunks.insert( SegmentMap::value_type( ( uint64_t ) address, totalSize ) );
-            mapIter = ret.first;
-            firstMerge = true;
-         }
-
-         //check previous chunk
-         if ( _freeChunks.begin() != mapIter )
-         {
-            mapIter--;
-            if ( mapIter->first + mapIter->second == ( uint64_t ) address ) {
-               //if totalSize > size then the next chunk was merged
-               if ( totalSize > size ) {
-                  mapIter->second += totalSize;
-                  mapIter++;
-                  _freeChunks.erase( mapIter );
-               }
-               else {
-                  mapIter->second += size;
-               }
-            } else if ( !firstMerge ) {
-               _freeChunks[ ( uint64_t ) address ] = size;
-            }
-         }
-         else if ( !firstMerge ) {
-            _freeChunks[ ( uint64_t ) address ] = size;
-         }
-      }
-      //duplicate key, error
-      else {
-         *(myThread->_file) << "Duplicate entry in segment map, addr " << address << ", size " << size << ". Got entry with size " << mapIter->second << ". Remaining: "<< _remaining << std::endl;
-         printBt(*(myThread->_file));
-         printMap(*(myThread->_file));
-         return 0;
-      }
+   _allocatedBlocks.erase( it );
+   _remaining += size;
+
+   // Coalesce with the physical neighbours
+   Block *next = block->_next;
+   if ( next != NULL && next->_free ) {
+      removeFree( next );
+      block->_size += next->_size;
+      block->_next = next->_next;
+      if ( next->_next != NULL ) next->_next->_prev = block;
+      deleteBlock( next );
    }
-   else {
-      _freeChunks[ ( uint64_t ) address ] = size;
+   Block *prev = block->_prev;
+   if ( prev != NULL && prev->_free ) {
+      removeFree( prev );
+      prev->_size += block->_size;
+      prev->_next = block->_next;
+      if ( block->_next != NULL ) block->_next->_prev = prev;
+      deleteBlock( block );
+      block = prev;
    }
-  _remaining += size;
+   insertFree( block );
 
    return size;
 }
@@ -211,20 +242,22 @@ void SimpleAllocator::printMap( std::ostream &o )
 {
    std::size_t totalAlloc = 0, totalFree = 0;
    o << (void *) this <<" ALLOCATED CHUNKS" << std::endl;
-   for (SegmentMap::iterator it = _allocatedChunks.begin(); it != _allocatedChunks.end(); it++ ) {
+   for ( Block *block = _firstBlock; block != NULL; block = block->_next ) {
+      if ( block->_free ) continue;
       o << "|... ";
-      o << (void *) it->first << " @ " << (std::size_t)it->second;
+      o << (void *) block->_address << " @ " << (std::size_t) block->_size;
       o << " ...";
-      totalAlloc += it->second;
+      totalAlloc += block->_size;
    }
    o << "| total allocated bytes " << (std::size_t) totalAlloc << std::endl;
 
    o << (void *) this <<" FREE CHUNKS" << std::endl;
-   for (SegmentMap::iterator it = _freeChunks.begin(); it != _freeChunks.end(); it++ ) {
+   for ( Block *block = _firstBlock; block != NULL; block = block->_next ) {
+      if ( !block->_free ) continue;
       o << "|... ";
-      o << (void *) it->first << " @ " << (std::size_t) it->second;
+      o << (void *) block->_address << " @ " << (std::size_t) block->_size;
       o << " ...";
-      totalFree += it->second;
+      totalFree += block->_size;
    }
    o << "| total free bytes "<< (std::size_t) totalFree << std::endl;
 }
@@ -243,41 +276,51 @@ void SimpleAllocator::unlock() {
 uint64_t SimpleAllocator::getBasePointer( uint64_t address, size_t size )
 {
    //This is likely an error
-   if (_allocatedChunks.size()==0) return 0;
-   
-   SegmentMap::iterator it = _allocatedChunks.lower_bound( address );
+   if (_allocatedBlocks.size()==0) return 0;
 
    // Perfect match, check size
-   if ( it->first == address ) {
-      if ( it->second >= size ) return it->first;
+   BlockMap::iterator it = _allocatedBlocks.find( address );
+   if ( it != _allocatedBlocks.end() ) {
+      return it->second->_size >= size ? address : 0;
    }
 
-   // address is lower than any other pinned address
-   if ( it == _allocatedChunks.begin() ) return 0;
-
-   // It is an intermediate region, check it fits into a pinned area
-   it--;
-
-   if ( ( it->first < address ) && ( ( ( size_t ) it->first + it->second ) >= ( ( size_t ) address + size ) ) ){
-       return it->first;
+   // It is an intermediate region, check it fits into an allocated area
+   for ( Block *block = _firstBlock; block != NULL && block->_address < address; block = block->_next ) {
+      if ( !block->_free && ( block->_address + block->_size ) >= ( address + size ) ) {
+         return block->_address;
+      }
    }
-   
+
    return 0;
 }
 
 void SimpleAllocator::canAllocate( std::size_t *sizes, unsigned int numChunks, std::size_t *remainingSizes ) const {
+   std::size_t total = 0;
+   for ( unsigned int idx = 0; idx < numChunks; idx += 1 ) {
+      total += sizes[ idx ];
+   }
+
+   // Every block of the highest non-empty class can hold all of them
+   if ( _nonEmptyClasses != 0 && total <= ( ( (std::size_t) 1 ) << ( 63 - __builtin_clzll( _nonEmptyClasses ) ) ) ) {
+      remainingSizes[ 0 ] = 0;
+      return;
+   }
+
    bool *allocated = (bool *) alloca( numChunks * sizeof(bool) );
    unsigned int allocated_chunks = 0;
    for ( unsigned int idx = 0; idx < numChunks; idx += 1 ) {
       allocated[ idx ] = false;
    }
-   for ( SegmentMap::const_iterator mapIter = _freeChunks.begin(); mapIter != _freeChunks.end(); mapIter++ ) {
-      std::size_t thisSize = mapIter->second;
-      for ( unsigned int idx = 0; idx < numChunks; idx += 1 ) {
-         if ( allocated[ idx ] == false && sizes[ idx ] <= thisSize ) {
-            allocated[ idx ] = true;
-            thisSize -= sizes[ idx ];
-            allocated_chunks += 1;
+   // Greedy fit, largest blocks first
+   for ( int sclass = NUM_CLASSES - 1; sclass >= 0 && allocated_chunks < numChunks; sclass -= 1 ) {
+      for ( Block *block = _freeLists[sclass]; block != NULL && allocated_chunks < numChunks; block = block->_nextFree ) {
+         std::size_t thisSize = block->_size;
+         for ( unsigned int idx = 0; idx < numChunks; idx += 1 ) {
+            if ( allocated[ idx ] == false && sizes[ idx ] <= thisSize ) {
+               allocated[ idx ] = true;
+               thisSize -= sizes[ idx ];
+               allocated_chunks += 1;
+            }
          }
       }
    }
@@ -298,8 +341,8 @@ void SimpleAllocator::canAllocate( std::size_t *sizes, unsigned int numChunks, s
 }
 
 void SimpleAllocator::getFreeChunksList( SimpleAllocator::ChunkList &list ) const {
-   for ( SegmentMap::const_iterator mapIter = _freeChunks.begin(); mapIter != _freeChunks.end(); mapIter++ ) {
-      list.push_back( *mapIter );
+   for ( Block *block = _firstBlock; block != NULL; block = block->_next ) {
+      if ( block->_free ) list.push_back( std::make_pair( block->_address, block->_size ) );
    }
 }
 
@@ -21,30 +21,68 @@
 #define _NANOS_SIMPLEALLOCATOR_DECL
 
 #include <stdint.h>
-#include <map>
 #include <list>
 #include <ostream>
 
 #include "atomic_decl.hpp"
 #include "lock_decl.hpp"
+#include "compatibility.hpp"
 
 namespace nanos {
 
    /*! \brief Simple memory allocator to manage a given contiguous memory area
+    *
+    *  The area is not accessed by the allocator (it may be device memory), so the
+    *  block headers are kept out of band. Every block (free or allocated) knows its
+    *  physical neighbours, which makes coalescing on free() O(1). Free blocks are kept
+    *  in segregated lists by size class (floor of log2 of their size) and a bitmap of
+    *  the non-empty classes, so allocate() only searches the list of its own class and
+    *  otherwise takes the first block of the next non-empty one.
     */
    class SimpleAllocator
    {
       private:
-         typedef std::map < uint64_t, std::size_t > SegmentMap;
-
-         SegmentMap _allocatedChunks;
-         SegmentMap _freeChunks;
+         /*! \brief Out of band header of a block of the managed area */
+         struct Block {
+            uint64_t     _address;
+            std::size_t  _size;
+            bool         _free;
+            Block       *_prev;      /**< Block physically before this one */
+            Block       *_next;      /**< Block physically after this one */
+            Block       *_prevFree;  /**< Previous block of the same free list */
+            Block       *_nextFree;  /**< Next block of the same free list (or next unused header) */
+         };
+
+         typedef TR1::unordered_map< uint64_t, Block * > BlockMap;
+
+         static const unsigned int NUM_CLASSES = 64;
+         static const unsigned int HEADERS_PER_SLAB = 64;
+
+         BlockMap             _allocatedBlocks;           /**< Allocated blocks by address */
+         Block               *_freeLists[NUM_CLASSES];    /**< Free blocks by size class */
+         uint64_t             _nonEmptyClasses;           /**< Bit i set if _freeLists[i] is not empty */
+         Block               *_firstBlock;                /**< Block at the base address */
+         Block               *_unusedHeaders;             /**< Recycled block headers */
+         std::list< Block * > _headerSlabs;               /**< Storage of the block headers */
 
          uint64_t _baseAddress;
          Lock     _lock;
          std::size_t _remaining;
          std::size_t _capacity;
 
+         /*! \brief Copy constructor (private) */
+         SimpleAllocator( SimpleAllocator const & );
+         /*! \brief Copy assignment operator (private) */
+         SimpleAllocator & operator=( SimpleAllocator const & );
+
+         static unsigned int sizeClass( std::size_t size );
+         Block * newBlock( uint64_t address, std::size_t size );
+         void deleteBlock( Block *block );
+         void insertFree( Block *block );
+         void removeFree( Block *block );
+         Block * splitBlock( Block *block, std::size_t size );
+         void * allocateBlock( Block *block, uint64_t address, std::size_t size );
+
       public:
          typedef std::list< std::pair< uint64_t, std::size_t > > ChunkList;
 
@@ -52,7 +90,9 @@ namespace nanos {
 
          // WARNING: Calling this constructor requires calling init() at some time
          // before any allocate() or free() methods are called
-         SimpleAllocator() : _baseAddress( 0 ), _remaining( 0 )  { }
+         SimpleAllocator();
+
+         ~SimpleAllocator();
 
          void init( uint64_t baseAddress, std::size_t len );
          uint64_t getBaseAddress ();
@@ -0,0 +1,116 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_MAX_CPUS=1" )
+</testinfo>
+*/
+
+#include "config.hpp"
+#include "nanos.h"
+#include "flatset.hpp"
+#include <iostream>
+#include <set>
+#include <stdlib.h>
+
+using namespace std;
+using namespace nanos;
+
+typedef std::pair<unsigned int, void *> Key;
+typedef FlatSet<Key, 4> KeySet;
+
+#define NUM_OPS    20000
+#define MAX_ID     256
+
+static bool sameContents ( KeySet const &flat, std::set<Key> const &ref )
+{
+   if ( flat.size() != ref.size() ) return false;
+
+   std::set<Key>::const_iterator rit = ref.begin();
+   for ( KeySet::const_iterator it = flat.begin(); it != flat.end(); it++, rit++ ) {
+      if ( *it != *rit ) return false;
+   }
+   return true;
+}
+
+/* FlatSet must behave as a std::set: ordered, no duplicates, both while using
+ * the inline storage and after growing to the heap */
+int main ( int argc, char **argv )
+{
+   KeySet flat;
+   std::set<Key> ref;
+   unsigned int seed = 1;
+
+   for ( int i = 0; i < NUM_OPS; i++ ) {
+      // Mostly increasing ids, as successors are usually added in creation order
+      unsigned int id = ( rand_r( &seed ) % 4 == 0 ) ? rand_r( &seed ) % MAX_ID : ( i / 16 ) % MAX_ID;
+      Key key( id, (void *) (size_t) ( id & 3 ) );
+
+      switch ( rand_r( &seed ) % 3 ) {
+         case 0:
+         case 1:
+            if ( flat.insert( key ).second != ref.insert( key ).second ) {
+               cerr << "insert mismatch" << endl;
+               return 1;
+            }
+            break;
+         case 2:
+            if ( flat.erase( key ) != ref.erase( key ) ) {
+               cerr << "erase mismatch" << endl;
+               return 1;
+            }
+            break;
+      }
+
+      if ( ( flat.find( key ) != flat.end() ) != ( ref.find( key ) != ref.end() ) ) {
+         cerr << "find mismatch" << endl;
+         return 1;
+      }
+   }
+
+   if ( !sameContents( flat, ref ) ) {
+      cerr << "contents mismatch" << endl;
+      return 1;
+   }
+
+   // Copies must not share storage
+   KeySet copy( flat );
+   flat.clear();
+   if ( !flat.empty() || !sameContents( copy, ref ) ) {
+      cerr << "copy mismatch" << endl;
+      return 1;
+   }
+
+   // Erasing while iterating
+   for ( KeySet::iterator it = copy.begin(); it != copy.end(); ) {
+      if ( it->first % 2 ) it = copy.erase( it );
+      else it++;
+   }
+   for ( KeySet::iterator it = copy.begin(); it != copy.end(); it++ ) {
+      if ( it->first % 2 ) {
+         cerr << "erase while iterating mismatch" << endl;
+         return 1;
+      }
+   }
+
+   cout << "successful" << endl;
+   return 0;
+}
@@ -0,0 +1,108 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_MAX_CPUS=1" )
+</testinfo>
+*/
+
+#include "config.hpp"
+#include "nanos.h"
+#include "intervaltree.hpp"
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <stdlib.h>
+
+using namespace std;
+using namespace nanos;
+
+typedef std::pair<unsigned int, unsigned int> Interval;
+typedef IntervalTree<unsigned int, int> Tree;
+
+#define NUM_OPS     20000
+#define MAX_ADDR    4096
+#define MAX_LENGTH  64
+
+/* IntervalTree must report the same overlaps as a linear scan over all the
+ * intervals, while they are inserted, removed and the tree is cleared */
+int main ( int argc, char **argv )
+{
+   Tree tree;
+   std::map<Interval, int> ref;
+   unsigned int seed = 1;
+
+   for ( int i = 0; i < NUM_OPS; i++ ) {
+      unsigned int low = rand_r( &seed ) % MAX_ADDR;
+      unsigned int high = low + rand_r( &seed ) % MAX_LENGTH;
+      Interval key( low, high );
+
+      switch ( rand_r( &seed ) % 4 ) {
+         case 0:
+         case 1:
+            if ( tree.insert( low, high, i ) != ref.insert( std::make_pair( key, i ) ).second ) {
+               cout << "Error: insert of [" << low << "," << high << "] differs" << endl;
+               return 1;
+            }
+            break;
+         case 2:
+            if ( tree.erase( low, high ) != ref.erase( key ) ) {
+               cout << "Error: erase of [" << low << "," << high << "] differs" << endl;
+               return 1;
+            }
+            break;
+         case 3:
+         {
+            std::vector<int> found, expected;
+            tree.findOverlaps( low, high, found );
+            for ( std::map<Interval, int>::iterator it = ref.begin(); it != ref.end(); it++ ) {
+               if ( !( it->first.second < low || it->first.first > high ) ) expected.push_back( it->second );
+            }
+            if ( found != expected ) {
+               cout << "Error: overlaps of [" << low << "," << high << "] differ (" << found.size()
+                    << " found, " << expected.size() << " expected)" << endl;
+               return 1;
+            }
+            int *value = tree.find( low, high );
+            std::map<Interval, int>::iterator it = ref.find( key );
+            if ( ( value == NULL ) != ( it == ref.end() ) || ( value != NULL && *value != it->second ) ) {
+               cout << "Error: find of [" << low << "," << high << "] differs" << endl;
+               return 1;
+            }
+            break;
+         }
+      }
+
+      if ( tree.size() != ref.size() ) {
+         cout << "Error: size differs (" << tree.size() << " vs " << ref.size() << ")" << endl;
+         return 1;
+      }
+
+      // Start over from time to time, nodes are reused from then on
+      if ( i % 5000 == 4999 ) {
+         tree.clear();
+         ref.clear();
+      }
+   }
+
+   return 0;
+}
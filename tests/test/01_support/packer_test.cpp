@@ -0,0 +1,104 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_MAX_CPUS=1" )
+</testinfo>
+*/
+
+
+#include "config.hpp"
+#include "nanos.h"
+#include "packer_decl.hpp"
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+using namespace nanos;
+
+#define POOL_SIZE ( 1UL << 20 )
+
+/* Packs and unpacks strided rows of several lengths (the specialised ones and
+ * others) and checks the data and the bytes between rows. Then checks that a
+ * released pack buffer is given again to a request of the same size class */
+
+int main ( int argc, char **argv )
+{
+   const std::size_t lens[] = { 1, 4, 8, 12, 16, 32, 64, 100, 128, 256, 512, 4096 };
+   const std::size_t counts[] = { 1, 3, 64 };
+
+   for ( unsigned int l = 0; l < sizeof( lens ) / sizeof( lens[0] ); l++ ) {
+      for ( unsigned int c = 0; c < sizeof( counts ) / sizeof( counts[0] ); c++ ) {
+         for ( std::size_t extra = 0; extra <= 8; extra += 8 ) {
+            std::size_t len = lens[l], count = counts[c], ld = len + extra;
+            char *strided = ( char * ) malloc( ld * count );
+            char *copy = ( char * ) malloc( ld * count );
+            char *packed = ( char * ) malloc( len * count );
+
+            for ( std::size_t i = 0; i < ld * count; i++ ) strided[i] = ( char ) rand();
+            Packer::pack( packed, strided, len, count, ld );
+            for ( std::size_t r = 0; r < count; r++ ) {
+               if ( memcmp( &packed[ r * len ], &strided[ r * ld ], len ) != 0 ) {
+                  cout << "Error: wrong packed row " << r << " (len " << len << " ld " << ld << ")" << endl;
+                  return 1;
+               }
+            }
+
+            memset( copy, 0x5a, ld * count );
+            Packer::unpack( copy, packed, len, count, ld );
+            for ( std::size_t i = 0; i < ld * count; i++ ) {
+               char expected = ( i % ld < len ) ? strided[i] : 0x5a;
+               if ( copy[i] != expected ) {
+                  cout << "Error: wrong unpacked byte " << i << " (len " << len << " ld " << ld << ")" << endl;
+                  return 1;
+               }
+            }
+            free( strided );
+            free( copy );
+            free( packed );
+         }
+      }
+   }
+
+   char *area = ( char * ) malloc( POOL_SIZE );
+   SimpleAllocator allocator( ( uint64_t ) area, POOL_SIZE );
+   Packer packer;
+   packer.setAllocator( &allocator );
+
+   void *first = packer.give_pack( 0, 100, 10 );
+   packer.free_pack( 0, 100, 10, first );
+   void *second = packer.give_pack( 0, 1000, 1 );
+   if ( first == NULL || second != first ) {
+      cout << "Error: released pack buffer was not reused" << endl;
+      return 1;
+   }
+
+   // The pooled buffer holds part of the area, it must be released to give the whole area
+   packer.free_pack( 0, 1000, 1, second );
+   void *whole = packer.give_pack( 0, POOL_SIZE / 2, 2 );
+   if ( whole == NULL ) {
+      cout << "Error: pooled buffers were not returned to the allocator" << endl;
+      return 1;
+   }
+
+   return 0;
+}
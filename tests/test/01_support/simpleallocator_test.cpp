@@ -0,0 +1,115 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_MAX_CPUS=1" )
+</testinfo>
+*/
+
+
+#include "config.hpp"
+#include "nanos.h"
+#include "simpleallocator.hpp"
+#include <iostream>
+#include <map>
+#include <stdlib.h>
+
+using namespace std;
+using namespace nanos;
+
+#define BASE_ADDRESS  0x100000UL
+#define CAPACITY      ( 1UL << 20 )
+#define NUM_OPS       50000
+#define MAX_SIZE      8192
+
+/* SimpleAllocator must never hand out overlapping or out of bounds chunks, free()
+ * must return the allocated size, and the free chunks must be coalesced back into
+ * a single one once everything is released */
+int main ( int argc, char **argv )
+{
+   SimpleAllocator allocator( BASE_ADDRESS, CAPACITY );
+   std::map<uint64_t, std::size_t> allocated;
+   std::size_t used = 0;
+   unsigned int seed = 1;
+
+   for ( int i = 0; i < NUM_OPS; i++ ) {
+      if ( allocated.empty() || rand_r( &seed ) % 2 == 0 ) {
+         // Mostly small sizes, a few large ones
+         std::size_t size = ( rand_r( &seed ) % 8 == 0 ) ? 1 + rand_r( &seed ) % ( 16 * MAX_SIZE ) : 1 + rand_r( &seed ) % MAX_SIZE;
+         uint64_t addr = (uint64_t) ( rand_r( &seed ) % 16 == 0 ? allocator.allocateSizeAligned( size ) : allocator.allocate( size ) );
+         if ( addr == 0 ) continue;
+
+         if ( addr < BASE_ADDRESS || addr + size > BASE_ADDRESS + CAPACITY ) {
+            cout << "Error: chunk " << (void *) addr << " out of bounds" << endl;
+            return 1;
+         }
+         std::map<uint64_t, std::size_t>::iterator next = allocated.lower_bound( addr );
+         if ( ( next != allocated.end() && next->first < addr + size ) ||
+              ( next != allocated.begin() && (--next)->first + next->second > addr ) ) {
+            cout << "Error: chunk " << (void *) addr << " overlaps an allocated one" << endl;
+            return 1;
+         }
+         allocated[addr] = size;
+         used += size;
+      } else {
+         std::map<uint64_t, std::size_t>::iterator it = allocated.begin();
+         std::advance( it, rand_r( &seed ) % allocated.size() );
+         if ( allocator.free( (void *) it->first ) != it->second ) {
+            cout << "Error: free of " << (void *) it->first << " did not return its size" << endl;
+            return 1;
+         }
+         used -= it->second;
+         allocated.erase( it );
+      }
+   }
+
+   SimpleAllocator::ChunkList freeChunks;
+   allocator.getFreeChunksList( freeChunks );
+   std::size_t freeBytes = 0;
+   for ( SimpleAllocator::ChunkList::iterator it = freeChunks.begin(); it != freeChunks.end(); it++ ) {
+      freeBytes += it->second;
+   }
+   if ( freeBytes + used != CAPACITY ) {
+      cout << "Error: " << freeBytes << " free bytes and " << used << " used bytes" << endl;
+      return 1;
+   }
+
+   for ( std::map<uint64_t, std::size_t>::iterator it = allocated.begin(); it != allocated.end(); it++ ) {
+      allocator.free( (void *) it->first );
+   }
+
+   freeChunks.clear();
+   allocator.getFreeChunksList( freeChunks );
+   if ( freeChunks.size() != 1 || freeChunks.front().first != BASE_ADDRESS || freeChunks.front().second != CAPACITY ) {
+      cout << "Error: free chunks were not coalesced (" << freeChunks.size() << " chunks)" << endl;
+      return 1;
+   }
+
+   std::size_t sizes[2] = { CAPACITY / 2, CAPACITY / 2 };
+   std::size_t remaining[2] = { 1, 1 };
+   allocator.canAllocate( sizes, 2, remaining );
+   if ( remaining[0] != 0 ) {
+      cout << "Error: canAllocate failed on an empty allocator" << endl;
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,120 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator=gens/api-generator
+exec_versions="smp_shared_mem smp_private_mem"
+
+declare test_ENV_smp_shared_mem=""
+declare test_ENV_smp_private_mem="NX_SMP_PRIVATE_MEMORY=yes NX_SMP_PRIVATE_MEMORY_SIZE=65536"
+
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+#define NUM_BLOCKS   256
+#define BLOCK_INTS   256
+#define NUM_ROUNDS   4
+
+/* Each round copies every block in and out of the device memory. The private
+ * memory (when enabled) only holds a few blocks, so blocks keep being evicted
+ * and their chunks reused by the next ones */
+
+int data[NUM_BLOCKS][BLOCK_INTS];
+
+typedef struct {
+   int *block;
+} my_args;
+
+void increment( void *ptr );
+void increment( void *ptr )
+{
+   int i;
+   int *block;
+   nanos_get_addr( 0, (void **) &block, nanos_current_wd() );
+   for ( i = 0; i < BLOCK_INTS; i++ )
+      block[i]++;
+}
+
+nanos_smp_args_t increment_device_arg = { increment };
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 const_data =
+{
+   {{
+      .mandatory_creation = true,
+      .tied = false},
+   __alignof__(my_args),
+   1,
+   1,
+   1,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &increment_device_arg
+      }
+   }
+};
+
+int main ( int argc, char **argv )
+{
+   int round, b, i, errors = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+
+   for ( round = 0; round < NUM_ROUNDS; round++ ) {
+      for ( b = 0; b < NUM_BLOCKS; b++ ) {
+         nanos_wd_t wd = 0;
+         my_args *args = 0;
+         nanos_copy_data_t *cd = 0;
+         nanos_region_dimension_internal_t *dims = 0;
+         nanos_region_dimension_t dimensions[1] = {{BLOCK_INTS * sizeof(int), 0, BLOCK_INTS * sizeof(int)}};
+         nanos_data_access_t data_accesses[1] = {{data[b], {1,1,0,0,0}, 1, dimensions, 0}};
+
+         NANOS_SAFE( nanos_create_wd_compact ( &wd, &const_data.base, &dyn_props, sizeof(my_args), (void **) &args,
+                  nanos_current_wd(), &cd, &dims ) );
+         args->block = data[b];
+         dims[0] = (nanos_region_dimension_internal_t) {BLOCK_INTS * sizeof(int), 0, BLOCK_INTS * sizeof(int)};
+         cd[0] = (nanos_copy_data_t) {(void *) data[b], NANOS_SHARED, {true, true}, 1, &dims[0], 0};
+
+         NANOS_SAFE( nanos_submit( wd, 1, data_accesses, 0 ) );
+      }
+   }
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   for ( b = 0; b < NUM_BLOCKS; b++ ) {
+      for ( i = 0; i < BLOCK_INTS; i++ ) {
+         if ( data[b][i] != NUM_ROUNDS ) errors++;
+      }
+   }
+
+   if ( errors != 0 ) {
+      printf( "Error: %d values were not updated correctly\n", errors );
+      return 1;
+   }
+
+   return 0;
+}
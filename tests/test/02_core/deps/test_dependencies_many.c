@@ -0,0 +1,110 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain,regions,perfect-regions"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+#define NUM_ADDRS    2048
+#define NUM_ROUNDS   8
+
+/* Many distinct dependences created by a single parent, the domain is
+ * cleared and reused at every taskwait */
+
+int values[NUM_ADDRS];
+int errors = 0;
+
+typedef struct {
+   int *value;
+   int expected;
+} task_args_t;
+
+void increment ( void *args );
+void increment ( void *args )
+{
+   task_args_t *targs = (task_args_t *) args;
+   if ( *targs->value != targs->expected ) __sync_fetch_and_add( &errors, 1 );
+   (*targs->value)++;
+}
+
+nanos_smp_args_t increment_device_arg = { increment };
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 const_data =
+{
+   {{
+      .mandatory_creation = true,
+      .tied = false},
+   __alignof__(task_args_t),
+   0,
+   1,
+   0,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &increment_device_arg
+      }
+   }
+};
+
+int main ( int argc, char **argv )
+{
+   int round, i, step;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+
+   for ( round = 0; round < NUM_ROUNDS; round++ ) {
+      /* Two inout tasks per address: the second one must see the first one's update */
+      for ( step = 0; step < 2; step++ ) {
+         for ( i = 0; i < NUM_ADDRS; i++ ) {
+            nanos_wd_t wd = 0;
+            task_args_t *args = NULL;
+            nanos_data_access_t data_accesses[1] = {{&values[i], {1,1,0,0,0}, 1, dimensions, 0}};
+
+            NANOS_SAFE( nanos_create_wd_compact ( &wd, &const_data.base, &dyn_props, sizeof(task_args_t),
+                     (void **) &args, nanos_current_wd(), NULL, NULL ) );
+            args->value = &values[i];
+            args->expected = round * 2 + step;
+            NANOS_SAFE( nanos_submit( wd, 1, data_accesses, 0 ) );
+         }
+      }
+      NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+   }
+
+   for ( i = 0; i < NUM_ADDRS; i++ ) {
+      if ( values[i] != NUM_ROUNDS * 2 ) errors++;
+   }
+
+   if ( errors != 0 ) {
+      printf("Error: Dependencies have not been respected (%d errors).\n", errors);
+      return 1;
+   }
+
+   return 0;
+}
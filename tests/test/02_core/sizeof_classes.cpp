@@ -26,12 +26,14 @@ test_generator_ENV=( "NX_TEST_MAX_CPUS=1"
 */
 
 #include "system.hpp"
+#include "basethread.hpp"
 #include <iostream>
 
 using namespace std;
 using namespace nanos;
 
 #define SIZEOF_WD             256*sizeof(void *)
+#define SIZEOF_WD_HOT          20*sizeof(void *)
 #define SIZEOF_DOWAIT          40*sizeof(void *)
 #define SIZEOF_DOSUBMIT        32*sizeof(void *)
 #define SIZEOF_ICONTEXT        32*sizeof(void *)
@@ -43,6 +45,10 @@ int main ( int argc, char **argv )
    cout << "Size of WorkDescriptor is " << sizeof(WD) << " out of " << SIZEOF_WD << endl;
    if ( sizeof(WD) > SIZEOF_WD ) error = 1;
 
+   size_t wdHotSize = myThread->getCurrentWD()->getHotDataSize();
+   cout << "Size of WorkDescriptor hot fields is " << wdHotSize << " out of " << SIZEOF_WD_HOT << endl;
+   if ( wdHotSize > SIZEOF_WD_HOT ) error = 1;
+
    cout << "Size of DOWait is " << sizeof(DOWait) << " out of " << SIZEOF_DOWAIT << endl;
    if ( sizeof(DOWait) > SIZEOF_DOWAIT ) error = 1;
 
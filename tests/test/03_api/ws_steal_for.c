@@ -0,0 +1,162 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator=gens/api-omp-generator
+</testinfo>
+*/
+
+#include <stdio.h>
+#include "nanos.h"
+#include "omp.h"
+
+/* Runs dynamic_steal_for and guided_steal_for loops in a team and checks every iteration is executed exactly once */
+
+#define NUM_ITERS 10007
+
+static int iters[NUM_ITERS];
+static int lasts;
+
+static const char *policies[] = { "dynamic_steal_for", "guided_steal_for" };
+static const int chunks[] = { 0, 1, 7 };
+
+struct  nanos_const_wd_definition_1
+{
+  nanos_const_wd_definition_t base;
+  nanos_device_t devices[1];
+};
+
+struct  nanos_args_1_t
+{
+  int policy;
+  int chunk;
+};
+
+static void run_loop ( int policy, int chunk )
+{
+  nanos_err_t err;
+  nanos_ws_info_loop_t nanos_setup_info_loop;
+  nanos_ws_desc_t *wsd;
+  nanos_ws_item_loop_t nanos_item_loop;
+  _Bool single_guard;
+  int i;
+
+  void *ws_policy = nanos_find_worksharing( policies[policy] );
+  if ( ws_policy == 0 ) nanos_handle_error( NANOS_UNIMPLEMENTED );
+
+  nanos_setup_info_loop.lower_bound = 0;
+  nanos_setup_info_loop.upper_bound = NUM_ITERS - 1;
+  nanos_setup_info_loop.loop_step = 1;
+  nanos_setup_info_loop.chunk_size = chunk;
+
+  err = nanos_worksharing_create( &wsd, ws_policy, (void **) &nanos_setup_info_loop, &single_guard );
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+
+  err = nanos_worksharing_next_item( wsd, (void **) &nanos_item_loop );
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+  while ( nanos_item_loop.execute ) {
+     for ( i = nanos_item_loop.lower; i <= nanos_item_loop.upper; i++ ) __sync_fetch_and_add( &iters[i], 1 );
+     if ( nanos_item_loop.last ) __sync_fetch_and_add( &lasts, 1 );
+     err = nanos_worksharing_next_item( wsd, (void **) &nanos_item_loop );
+     if ( err != NANOS_OK ) nanos_handle_error( err );
+  }
+}
+
+static void smp_ol_main_1 ( struct nanos_args_1_t *const args )
+{
+  nanos_err_t err;
+  err = nanos_omp_set_implicit( nanos_current_wd() );
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+  err = nanos_enter_team();
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+
+  run_loop( args->policy, args->chunk );
+
+  err = nanos_omp_barrier();
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+  err = nanos_leave_team();
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+}
+
+static void parallel_loop ( int policy, int chunk )
+{
+  nanos_err_t err;
+  nanos_wd_dyn_props_t dyn_props;
+  unsigned int nth_i;
+  struct nanos_args_1_t imm_args;
+  nanos_data_access_t dependences[1];
+  static nanos_smp_args_t smp_ol_main_1_args = {.outline = (void (*)(void *))(void (*)(struct nanos_args_1_t *))&smp_ol_main_1};
+  static struct nanos_const_wd_definition_1 nanos_wd_const_data = {.base = {.props = {.mandatory_creation = 1, .tied = 1, .clear_chunk = 0, .reserved0 = 0, .reserved1 = 0, .reserved2 = 0, .reserved3 = 0, .reserved4 = 0}, .data_alignment = __alignof__(struct nanos_args_1_t), .num_copies = 0, .num_devices = 1, .num_dimensions = 0, .description = 0}, .devices = {[0] = {.factory = &nanos_smp_factory, .arg = &smp_ol_main_1_args}}};
+  unsigned int nanos_num_threads = nanos_omp_get_num_threads_next_parallel(0);
+  nanos_team_t nanos_team = (nanos_team_t)0;
+  nanos_thread_t nanos_team_threads[nanos_num_threads];
+
+  err = nanos_create_team(&nanos_team, (nanos_sched_t)0, &nanos_num_threads, (nanos_constraint_t *)0, 1, nanos_team_threads, NULL );
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+
+  dyn_props.tie_to = (nanos_thread_t)0;
+  dyn_props.priority = 0;
+  dyn_props.flags.is_final = 0;
+  for ( nth_i = 1; nth_i < nanos_num_threads; nth_i = nth_i + 1 ) {
+     dyn_props.tie_to = nanos_team_threads[nth_i];
+     struct nanos_args_1_t *ol_args = 0;
+     nanos_wd_t nanos_wd_ = (nanos_wd_t)0;
+     err = nanos_create_wd_compact(&nanos_wd_, &nanos_wd_const_data.base, &dyn_props, sizeof(struct nanos_args_1_t), (void **)&ol_args, nanos_current_wd(), (nanos_copy_data_t **)0, (nanos_region_dimension_internal_t **)0);
+     if ( err != NANOS_OK ) nanos_handle_error( err );
+     ol_args->policy = policy;
+     ol_args->chunk = chunk;
+     err = nanos_submit(nanos_wd_, 0, (nanos_data_access_t *)0, (nanos_team_t)0);
+     if ( err != NANOS_OK ) nanos_handle_error( err );
+  }
+  dyn_props.tie_to = nanos_team_threads[0];
+  imm_args.policy = policy;
+  imm_args.chunk = chunk;
+  err = nanos_create_wd_and_run_compact(&nanos_wd_const_data.base, &dyn_props, sizeof(struct nanos_args_1_t), &imm_args, 0, dependences, (nanos_copy_data_t *)0, (nanos_region_dimension_internal_t *)0, (nanos_translate_args_t)0);
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+  err = nanos_end_team(nanos_team);
+  if ( err != NANOS_OK ) nanos_handle_error( err );
+}
+
+int main ( int argc, char **argv )
+{
+  int p, c, i, error = 0;
+
+  for ( p = 0; p < 2; p++ ) {
+     for ( c = 0; c < 3; c++ ) {
+        for ( i = 0; i < NUM_ITERS; i++ ) iters[i] = 0;
+        lasts = 0;
+
+        parallel_loop( p, chunks[c] );
+
+        for ( i = 0; i < NUM_ITERS; i++ ) {
+           if ( iters[i] != 1 ) {
+              fprintf( stderr, "%s (chunk %d): iteration %d executed %d times\n", policies[p], chunks[c], i, iters[i] );
+              error = 1;
+              break;
+           }
+        }
+        if ( lasts != 1 ) {
+           fprintf( stderr, "%s (chunk %d): last item seen %d times\n", policies[p], chunks[c], lasts );
+           error = 1;
+        }
+     }
+  }
+
+  return error;
+}
@@ -0,0 +1,72 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+#include "common.h"
+
+/*
+<testinfo>
+test_generator=gens/mcc-openmp-generator
+test_generator_ENV=( "NX_TEST_MODE=performance"
+                     "NX_TEST_MAX_CPUS=8" )
+</testinfo>
+*/
+
+#define TEST_NTASKS_PER_THREAD 1000 // Number of tasks created by each creator task
+
+void empty_task ( void ) { }
+
+// TEST: Task Create/Submit Throughput *************************************************************
+// Every thread creates and submits tasks concurrently, so that the scheduler statistics counters
+// are updated from all threads at the same time. The result is the aggregated throughput in
+// tasks per millisecond, to be compared across the different number of threads.
+void test_create_submit_throughput ( stats_t *s )
+{
+   int i, j, nthreads = omp_get_max_threads();
+   double times[TEST_NSAMPLES];
+
+   for ( i = 0; i < TEST_NSAMPLES; i++ ) {
+      times[i] = GET_TIME;
+      for ( j = 0; j < nthreads; j++ ) {
+#pragma omp task
+         {
+            int k;
+            for ( k = 0; k < TEST_NTASKS_PER_THREAD; k++ ) {
+#pragma omp task
+               empty_task();
+            }
+#pragma omp taskwait
+         }
+      }
+#pragma omp taskwait
+      times[i] = ( nthreads * TEST_NTASKS_PER_THREAD ) / ( ( GET_TIME - times[i] ) * 1.0e-3 );
+   }
+   stats( s, times, TEST_NSAMPLES);
+}
+
+int main ( int argc, char *argv[] )
+{
+   stats_t s;
+
+   test_create_submit_throughput( &s );
+   print_stats ( "Create/submit throughput","warm-up", &s );
+   test_create_submit_throughput( &s );
+   print_stats ( "Create/submit throughput","test", &s );
+
+   return 0;
+}
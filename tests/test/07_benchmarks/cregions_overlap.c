@@ -0,0 +1,122 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator="gens/api-generator -d cregions"
+test_generator_ENV=( "NX_TEST_MODE=performance" "NX_TEST_MAX_CPUS=1" )
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <nanos.h>
+
+#define NUM_SECTIONS 100000
+#define SECTION_LEN  16
+#define NUM_ROUNDS   2
+
+/* Submission cost of many partially overlapping array sections: section i covers
+ * [i*SECTION_LEN, (i+2)*SECTION_LEN), so it overlaps sections i-1 and i+1 (as the
+ * halos of neighbouring blocks do). The domain is cleared at every taskwait */
+
+int data[( NUM_SECTIONS + 1 ) * SECTION_LEN];
+char done[NUM_SECTIONS];
+int errors = 0;
+
+typedef struct {
+   int section;
+} task_args_t;
+
+void update ( void *args );
+void update ( void *args )
+{
+   task_args_t *targs = (task_args_t *) args;
+   int i = targs->section;
+   if ( i > 0 && !done[i-1] ) __sync_fetch_and_add( &errors, 1 );
+   data[i * SECTION_LEN]++;
+   done[i] = 1;
+}
+
+nanos_smp_args_t update_device_arg = { update };
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 const_data =
+{
+   {{
+      .mandatory_creation = true,
+      .tied = false},
+   __alignof__(task_args_t),
+   0,
+   1,
+   0,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &update_device_arg
+      }
+   }
+};
+
+int main ( int argc, char **argv )
+{
+   int round, i;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   nanos_region_dimension_t dimensions[1] = {{2 * SECTION_LEN * sizeof(int), 0, 2 * SECTION_LEN * sizeof(int)}};
+   struct timeval start, end;
+   double submit_time = 0.0;
+
+   for ( round = 0; round < NUM_ROUNDS; round++ ) {
+      for ( i = 0; i < NUM_SECTIONS; i++ ) done[i] = 0;
+
+      gettimeofday( &start, NULL );
+      for ( i = 0; i < NUM_SECTIONS; i++ ) {
+         nanos_wd_t wd = 0;
+         task_args_t *args = NULL;
+         nanos_data_access_t data_accesses[1] = {{&data[i * SECTION_LEN], {1,1,0,0,0}, 1, dimensions, 0}};
+
+         NANOS_SAFE( nanos_create_wd_compact ( &wd, &const_data.base, &dyn_props, sizeof(task_args_t),
+                  (void **) &args, nanos_current_wd(), NULL, NULL ) );
+         args->section = i;
+         NANOS_SAFE( nanos_submit( wd, 1, data_accesses, 0 ) );
+      }
+      gettimeofday( &end, NULL );
+      submit_time += ( end.tv_sec - start.tv_sec ) * 1e6 + ( end.tv_usec - start.tv_usec );
+
+      NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+   }
+
+   printf( "Submission of %d overlapping sections: %.3f us per task\n", NUM_SECTIONS, submit_time / ( NUM_ROUNDS * NUM_SECTIONS ) );
+
+   for ( i = 0; i < NUM_SECTIONS; i++ ) {
+      if ( data[i * SECTION_LEN] != NUM_ROUNDS ) errors++;
+   }
+
+   if ( errors != 0 ) {
+      printf("Error: Dependencies have not been respected (%d errors).\n", errors);
+      return 1;
+   }
+
+   return 0;
+}
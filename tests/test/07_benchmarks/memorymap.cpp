@@ -0,0 +1,129 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_MODE=performance" "NX_TEST_MAX_CPUS=1" )
+</testinfo>
+*/
+
+#include "config.hpp"
+#include "nanos.h"
+#include <stdio.h>
+#include <sys/time.h>
+#include "memorymap.hpp"
+
+using namespace nanos;
+
+/* Insert, split/overlap lookup and removal cost of MemoryMap with 10^3 to 10^5 chunks */
+
+#define CHUNK_SIZE 256
+
+static double get_usecs ()
+{
+   struct timeval tv;
+   gettimeofday( &tv, NULL );
+   return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+// Chunks must be sorted, disjoint and cover [0, size) when the map was filled with whole chunks
+static bool check_map( MemoryMap<int> const &map, uint64_t size )
+{
+   uint64_t next = 0;
+   for ( MemoryMap<int>::const_iterator it = map.begin(); it != map.end(); it++ ) {
+      if ( it->first.getAddress() != next || it->second == NULL ) return false;
+      next += it->first.getLength();
+   }
+   return next == size;
+}
+
+int main ( int argc, char **argv )
+{
+   bool check = true;
+
+   for ( int chunks = 1000; chunks <= 100000; chunks *= 10 ) {
+      uint64_t size = ( uint64_t ) chunks * CHUNK_SIZE;
+      MemoryMap<int> map;
+      MemoryMap<int>::MemChunkList results;
+
+      // Insert every chunk in a scattered order
+      double insert = get_usecs();
+      for ( int i = 0; i < chunks; i++ ) {
+         uint64_t idx = ( (uint64_t) i * 2654435761U ) % chunks;
+         results.clear();
+         map.getOrAddChunk( idx * CHUNK_SIZE, CHUNK_SIZE, results );
+         for ( MemoryMap<int>::MemChunkList::iterator it = results.begin(); it != results.end(); it++ ) {
+            if ( *it->second == NULL ) *it->second = NEW int( 0 );
+         }
+      }
+      insert = get_usecs() - insert;
+      if ( map.size() != (size_t) chunks || !check_map( map, size ) ) check = false;
+
+      // Accesses straddling two chunks split both of them
+      double split = get_usecs();
+      for ( int i = 0; i < chunks - 1; i += 2 ) {
+         results.clear();
+         map.getOrAddChunk( (uint64_t) i * CHUNK_SIZE + CHUNK_SIZE / 2, CHUNK_SIZE, results );
+         for ( MemoryMap<int>::MemChunkList::iterator it = results.begin(); it != results.end(); it++ ) {
+            if ( *it->second == NULL ) *it->second = NEW int( 0 );
+            (**it->second)++;
+         }
+      }
+      split = get_usecs() - split;
+      if ( !check_map( map, size ) ) check = false;
+
+      // Read only lookups spanning several chunks
+      MemoryMap<int>::ConstMemChunkList found;
+      size_t entries = 0;
+      double overlap = get_usecs();
+      for ( int i = 0; i < chunks - 4; i += 4 ) {
+         found.clear();
+         map.getChunk( (uint64_t) i * CHUNK_SIZE, 4 * CHUNK_SIZE, found );
+         entries += found.size();
+      }
+      overlap = get_usecs() - overlap;
+      if ( entries < (size_t) ( chunks - 4 ) / 4 ) check = false;
+
+      // removeChunks does not free the values
+      for ( MemoryMap<int>::iterator it = map.begin(); it != map.end(); it++ ) {
+         delete it->second;
+         it->second = NULL;
+      }
+
+      // Remove everything, two chunks (and their split pieces) at a time
+      double remove = get_usecs();
+      for ( int i = 0; i < chunks; i += 2 ) {
+         map.removeChunks( (uint64_t) i * CHUNK_SIZE, 2 * CHUNK_SIZE );
+      }
+      remove = get_usecs() - remove;
+      if ( !map.empty() ) check = false;
+
+      fprintf( stderr, "MemoryMap %d chunks: insert %.3f us, split %.3f us, overlap %.3f us, remove %.3f us (per op)\n",
+               chunks, insert / chunks, split / ( chunks / 2 ), overlap / ( chunks / 4 ), remove / ( chunks / 2 ) );
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return 0;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return -1;
+   }
+}
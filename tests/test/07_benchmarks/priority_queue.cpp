@@ -0,0 +1,100 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_MODE=performance" "NX_TEST_MAX_CPUS=1" )
+</testinfo>
+*/
+
+#include "config.hpp"
+#include "nanos.h"
+#include <iostream>
+#include <sys/time.h>
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "wddeque.hpp"
+
+using namespace std;
+
+using namespace nanos;
+using namespace nanos::ext;
+
+/* Push/pop cost of WDPriorityQueue with 10^3 to 10^6 queued tasks */
+
+#define MAX_WDS        4096    // Distinct WDs, pushed several times each when more tasks are queued
+#define NUM_PRIORITIES 1024
+
+static double get_usecs ()
+{
+   struct timeval tv;
+   gettimeofday( &tv, NULL );
+   return tv.tv_sec * 1.0e6 + tv.tv_usec;
+}
+
+void task ( void *args ) {}
+
+int main ( int argc, char **argv )
+{
+   bool check = true;
+   char data = 0;
+
+   WD *wds[MAX_WDS];
+   for ( int i = 0; i < MAX_WDS; i++ ) {
+      wds[i] = new WD( new SMPDD( task ), sizeof( data ), __alignof__(char), ( void * ) &data );
+      wds[i]->setPriority( ( (unsigned) i * 2654435761U ) % NUM_PRIORITIES );
+   }
+
+   BaseThread *thread = getMyThreadSafe();
+
+   for ( int tasks = 1000; tasks <= 1000000; tasks *= 10 ) {
+      WDPriorityQueue<> queue( true /* enableDeviceCounter */, true /* optimise option */ );
+
+      double push = get_usecs();
+      for ( int i = 0; i < tasks; i++ ) queue.push_back( wds[i % MAX_WDS] );
+      push = get_usecs() - push;
+
+      if ( queue.size() != (size_t) tasks ) check = false;
+
+      WD *prev = NULL;
+      int popped = 0;
+      double pop = get_usecs();
+      for ( WD *wd = queue.pop_front( thread ); wd != NULL; wd = queue.pop_front( thread ), popped++ ) {
+         if ( prev != NULL && prev->getPriority() < wd->getPriority() ) check = false;
+         // With no repeated WDs the ones with the same priority must come out in FIFO order
+         if ( tasks <= MAX_WDS && prev != NULL && prev->getPriority() == wd->getPriority() && prev->getId() > wd->getId() ) check = false;
+         prev = wd;
+      }
+      pop = get_usecs() - pop;
+
+      if ( popped != tasks || !queue.empty() ) check = false;
+
+      fprintf( stderr, "WDPriorityQueue %d tasks: push %.3f us/task, pop %.3f us/task\n",
+               tasks, push / tasks, pop / tasks );
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return 0;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return -1;
+   }
+}
@@ -0,0 +1,170 @@
+/*************************************************************************************/
+/*      Copyright 2015 Barcelona Supercomputing Center                               */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <http://www.gnu.org/licenses/>.             */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/api-generator
+test_generator_ENV=( "NX_TEST_MODE=performance" "NX_TEST_MAX_CPUS=1" )
+exec_versions="memcpy streaming"
+
+declare test_ENV_memcpy="NX_SMP_PRIVATE_MEMORY=yes NX_SMP_PRIVATE_MEMORY_SIZE=64M NX_SMP_STREAMING_COPY_THRESHOLD=0"
+declare test_ENV_streaming="NX_SMP_PRIVATE_MEMORY=yes NX_SMP_PRIVATE_MEMORY_SIZE=64M NX_SMP_STREAMING_COPY_THRESHOLD=64K"
+
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <nanos.h>
+
+#define SHAPE_BYTES  ( 32 * 1024 * 1024 )
+#define NUM_SHAPES   6
+
+/* Bandwidth of the SMP copy-ins for several copy shapes. Every task copies in a
+ * different slice of the data array (so no copy is a cache hit) and checks the
+ * first byte of each row. Strided shapes use a leading dimension of twice the
+ * row length, the whole array holds SHAPE_BYTES of rows */
+
+typedef struct {
+   const char *name;
+   size_t row;     /* bytes per row */
+   size_t rows;    /* rows per task */
+   size_t ld;      /* leading dimension (bytes) */
+} shape_t;
+
+shape_t shapes[NUM_SHAPES] = {
+   { "contiguous 64K",         64 * 1024,        1,    64 * 1024 },
+   { "contiguous 1M",          1024 * 1024,      1,    1024 * 1024 },
+   { "contiguous 16M",         16 * 1024 * 1024, 1,    16 * 1024 * 1024 },
+   { "strided 256x256B",       256,              256,  512 },
+   { "strided 1024x4K",        4 * 1024,         1024, 8 * 1024 },
+   { "strided 256x64K",        64 * 1024,        256,  128 * 1024 },
+};
+
+char data[2 * SHAPE_BYTES];
+int errors = 0;
+
+typedef struct {
+   char value;
+   size_t rows;
+   size_t ld;
+} my_args;
+
+void check_rows( void *ptr );
+void check_rows( void *ptr )
+{
+   my_args *args = (my_args *) ptr;
+   char *slice;
+   size_t r;
+   nanos_get_addr( 0, (void **) &slice, nanos_current_wd() );
+   for ( r = 0; r < args->rows; r++ ) {
+      if ( slice[r * args->ld] != args->value ) __sync_fetch_and_add( &errors, 1 );
+   }
+}
+
+nanos_smp_args_t check_rows_device_arg = { check_rows };
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 const_data =
+{
+   {{
+      .mandatory_creation = true,
+      .tied = false},
+   __alignof__(my_args),
+   1,
+   1,
+   2,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &check_rows_device_arg
+      }
+   }
+};
+
+static double get_secs( void )
+{
+   struct timeval tv;
+   gettimeofday( &tv, NULL );
+   return tv.tv_sec + tv.tv_usec * 1.0e-6;
+}
+
+static double copy_in_shape( shape_t *shape )
+{
+   nanos_wd_dyn_props_t dyn_props = {0};
+   size_t slice_bytes = shape->rows * shape->ld;
+   size_t num_slices = 2 * SHAPE_BYTES / slice_bytes;
+   size_t s;
+   double start;
+
+   for ( s = 0; s < num_slices; s++ ) {
+      memset( &data[s * slice_bytes], (char) s, slice_bytes );
+   }
+
+   start = get_secs();
+   for ( s = 0; s < num_slices; s++ ) {
+      nanos_wd_t wd = 0;
+      my_args *args = 0;
+      nanos_copy_data_t *cd = 0;
+      nanos_region_dimension_internal_t *dims = 0;
+      char *slice = &data[s * slice_bytes];
+      nanos_region_dimension_t dimensions[2] = {{shape->ld, 0, shape->row}, {shape->rows, 0, shape->rows}};
+      nanos_data_access_t data_accesses[1] = {{slice, {1,0,0,0,0}, 2, dimensions, 0}};
+
+      NANOS_SAFE( nanos_create_wd_compact ( &wd, &const_data.base, &dyn_props, sizeof(my_args), (void **) &args,
+               nanos_current_wd(), &cd, &dims ) );
+      args->value = (char) s;
+      args->rows = shape->rows;
+      args->ld = shape->ld;
+      dims[0] = (nanos_region_dimension_internal_t) {shape->ld, 0, shape->row};
+      dims[1] = (nanos_region_dimension_internal_t) {shape->rows, 0, shape->rows};
+      cd[0] = (nanos_copy_data_t) {(void *) slice, NANOS_SHARED, {true, false}, 2, &dims[0], 0};
+
+      NANOS_SAFE( nanos_submit( wd, 1, data_accesses, 0 ) );
+   }
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   return ( num_slices * shape->rows * shape->row ) / ( get_secs() - start ) / 1.0e9;
+}
+
+int main ( int argc, char **argv )
+{
+   int i;
+
+   for ( i = 0; i < NUM_SHAPES; i++ ) {
+      double gbs;
+      fflush( stdout );
+      gbs = copy_in_shape( &shapes[i] );
+      printf( "%-20s %8.2f GB/s\n", shapes[i].name, gbs );
+   }
+
+   if ( errors != 0 ) {
+      printf( "Error: %d rows were not copied correctly\n", errors );
+      return 1;
+   }
+
+   return 0;
+}